@@ -0,0 +1,119 @@
+#include "DataSearch.h"
+
+#include <cstring>
+
+DataSearch::DataSearch(const std::vector<char>& pattern): Pattern(pattern)
+{
+    size_t m = Pattern.size();
+    for (unsigned i = 0; i < 256; ++i)
+        Shift[i] = (m > 0 ? m : 1);
+    /// last pattern byte is not used for shifts
+    for (size_t i = 0; i + 1 < m; ++i)
+        Shift[(uint8_t)Pattern[i]] = m - 1 - i;
+}
+
+size_t DataSearch::Find(const char* data, size_t size) const
+{
+    size_t m = Pattern.size();
+    if (m == 0 || size < m)
+        return size;
+    /// memchr is the fastest way to scan for a single byte
+    if (m == 1)
+    {
+        const char* found = static_cast<const char*>(memchr(data, Pattern[0], size));
+        return (found == nullptr ? size : found - data);
+    }
+    const char* pattern = Pattern.data();
+    const uint8_t lastByte = Pattern[m - 1];
+    for (size_t pos = 0; pos <= size - m; )
+    {
+        uint8_t c = data[pos + m - 1];
+        if (c == lastByte && memcmp(data + pos, pattern, m - 1) == 0)
+            return pos;
+        pos += Shift[c];
+    }
+    return size;
+}
+
+MultiDataSearch::MultiDataSearch(const std::vector<std::vector<char>>& patterns): State(0)
+{
+    /// trie: state 0 is the root, -1 is no transition
+    Next.assign(256, -1);
+    Output.resize(1);
+    for (unsigned i = 0; i < patterns.size(); ++i)
+    {
+        PatternSizes.push_back(patterns[i].size());
+        /// empty patterns never match
+        if (patterns[i].empty())
+            continue;
+        int32_t s = 0;
+        for (unsigned j = 0; j < patterns[i].size(); ++j)
+        {
+            uint8_t c = patterns[i][j];
+            if (Next[s * 256 + c] < 0)
+            {
+                Next[s * 256 + c] = Output.size();
+                Next.resize(Next.size() + 256, -1);
+                Output.resize(Output.size() + 1);
+            }
+            s = Next[s * 256 + c];
+        }
+        Output[s].push_back(i);
+    }
+    /// turn trie into automaton: missing transitions follow failure links
+    std::vector<int32_t> Fail(Output.size(), 0);
+    std::vector<int32_t> Queue;
+    for (unsigned c = 0; c < 256; ++c)
+    {
+        if (Next[c] < 0)
+        {
+            Next[c] = 0;
+        }
+        else
+        {
+            Fail[Next[c]] = 0;
+            Queue.push_back(Next[c]);
+        }
+    }
+    /// breadth-first order: failure states are processed before their children
+    for (size_t q = 0; q < Queue.size(); ++q)
+    {
+        int32_t s = Queue[q];
+        /// state also matches all the patterns of its failure state
+        Output[s].insert(Output[s].end(), Output[Fail[s]].begin(), Output[Fail[s]].end());
+        for (unsigned c = 0; c < 256; ++c)
+        {
+            int32_t t = Next[s * 256 + c];
+            if (t < 0)
+            {
+                Next[s * 256 + c] = Next[Fail[s] * 256 + c];
+            }
+            else
+            {
+                Fail[t] = Next[Fail[s] * 256 + c];
+                Queue.push_back(t);
+            }
+        }
+    }
+}
+
+void MultiDataSearch::Feed(const char* data, size_t size, size_t streamOffset, std::vector<std::vector<size_t>>& Found)
+{
+    if (Found.size() < PatternSizes.size())
+        Found.resize(PatternSizes.size());
+    const int32_t* next = Next.data();
+    int32_t s = State;
+    for (size_t i = 0; i < size; ++i)
+    {
+        s = next[s * 256 + (uint8_t)data[i]];
+        if (!Output[s].empty())
+        {
+            for (unsigned j = 0; j < Output[s].size(); ++j)
+            {
+                uint32_t idx = Output[s][j];
+                Found[idx].push_back(streamOffset + i + 1 - PatternSizes[idx]);
+            }
+        }
+    }
+    State = s;
+}
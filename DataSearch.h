@@ -0,0 +1,41 @@
+#ifndef DATASEARCH_H
+#define DATASEARCH_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/// single pattern search (Boyer-Moore-Horspool)
+class DataSearch
+{
+public:
+    DataSearch(const std::vector<char>& pattern);
+    size_t GetSize() const { return Pattern.size(); }
+    /// offset of the first occurrence inside data block or size if not found
+    size_t Find(const char* data, size_t size) const;
+private:
+    std::vector<char> Pattern;
+    size_t Shift[256];
+};
+
+/// multiple pattern search (Aho-Corasick)
+/// finds all (including overlapping) occurrences of all the patterns in one pass
+/// data can be fed by blocks: occurrences crossing block bounds are found too
+class MultiDataSearch
+{
+public:
+    MultiDataSearch(const std::vector<std::vector<char>>& patterns);
+    size_t GetPatternCount() const { return PatternSizes.size(); }
+    /// start a new data stream
+    void Reset() { State = 0; }
+    /// search next data block, streamOffset is the block offset inside the stream
+    /// start offsets of occurrences are appended to Found[pattern index] in ascending order
+    void Feed(const char* data, size_t size, size_t streamOffset, std::vector<std::vector<size_t>>& Found);
+private:
+    std::vector<size_t> PatternSizes;
+    std::vector<int32_t> Next;                  /// 256 transitions for each state
+    std::vector<std::vector<uint32_t>> Output;  /// patterns ending at each state
+    int32_t State;
+};
+
+#endif // DATASEARCH_H
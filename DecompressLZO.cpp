@@ -2,22 +2,26 @@
 #include <iomanip>
 
 #include "UPKInfo.h"
+#include "ParallelFor.h"
 #include <fstream>
 #include <sstream>
-#include "minilzo.h"
+#include <cstdlib>
+#include <chrono>
+#include "LZOCodec.h"
 
 using namespace std;
 
-#define IN_LEN      (131072u)                              /// max input block size
-#define OUT_LEN     (IN_LEN + IN_LEN / 16 + 64 + 3)        /// max output block size
+/// number of blocks per worker thread to keep in memory
+#define BLOCKS_PER_THREAD   4
 
-static unsigned char __LZO_MMODEL in  [ IN_LEN ];          /// input data
-static unsigned char __LZO_MMODEL out [ OUT_LEN ];         /// output data
-
-#define HEAP_ALLOC(var,size) \
-    lzo_align_t __LZO_MMODEL var [ ((size) + (sizeof(lzo_align_t) - 1)) / sizeof(lzo_align_t) ]
-
-//static HEAP_ALLOC(wrkmem, LZO1X_1_MEM_COMPRESS);           /// lzo working memory
+/// single compressed block and its place in the output file
+struct DecompressionTask
+{
+    size_t CompressedOffset;
+    size_t CompressedSize;
+    size_t UncompressedOffset;
+    size_t UncompressedSize;
+};
 
 void SerializeSummary(FPackageFileSummary Summary, ostream& decompressedPackage);
 
@@ -25,21 +29,40 @@ int main(int argN, char* argV[])
 {
     cout << "DecompressLZO" << endl;
 
-    if (argN < 2 || argN > 3)
+    unsigned NumThreads = GetNumThreads();
+    vector<string> args;
+    for (int i = 1; i < argN; ++i)
     {
-        cerr << "Usage: DecompressLZO CompressedResourceFile.upk [DecompressedResourceFile.upk]" << endl;
+        string arg = argV[i];
+        if (arg == "-j" && i + 1 < argN)
+        {
+            NumThreads = GetNumThreads(atoi(argV[++i]));
+        }
+        else if (arg.substr(0, 2) == "-j" && arg.size() > 2)
+        {
+            NumThreads = GetNumThreads(atoi(arg.substr(2).c_str()));
+        }
+        else
+        {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.size() < 1 || args.size() > 2)
+    {
+        cerr << "Usage: DecompressLZO CompressedResourceFile.upk [DecompressedResourceFile.upk] [-j N]" << endl;
         return 1;
     }
 
-    ifstream package(argV[1], ios::binary);
-    if (!package.is_open())
+    ifstream package_stream(args[0].c_str(), ios::binary);
+    if (!package_stream.is_open())
     {
-        cerr << "Can't open " << argV[1] << endl;
+        cerr << "Can't open " << args[0] << endl;
         return 1;
     }
-    stringstream package_stream;
-    package_stream << package.rdbuf();
-    package.close();
+    package_stream.seekg(0, ios::end);
+    size_t packageSize = package_stream.tellg();
+    package_stream.seekg(0);
 
     UPKInfo PackageInfo(package_stream);
 
@@ -68,28 +91,20 @@ int main(int argN, char* argV[])
     }
 
     /// init lzo library
-    int lzo_err;
-    lzo_uint in_len;
-    lzo_uint out_len;
-    lzo_uint new_len;
-
-    if (lzo_init() != LZO_E_OK)
+    if (!LZOInit())
     {
         cout << "LZO library internal error: lzo_init() failed!!!\n";
         return 1;
     }
 
-    lzo_memset(in, 0, IN_LEN);
-
-    stringstream decompressed_stream;
     ofstream decompressedPackage;
-    if (argN == 3)
+    if (args.size() == 2)
     {
-        decompressedPackage.open(argV[2], ios::binary);
+        decompressedPackage.open(args[1].c_str(), ios::binary);
     }
     else
     {
-        decompressedPackage.open((string(argV[1]) + ".uncompr").c_str(), ios::binary);
+        decompressedPackage.open((args[0] + ".uncompr").c_str(), ios::binary);
     }
     if (!decompressedPackage.is_open())
     {
@@ -99,6 +114,7 @@ int main(int argN, char* argV[])
 
     unsigned int NumCompressedChunks = Summary.NumCompressedChunks;
 
+    stringstream summary_stream;
     if (PackageInfo.IsFullyCompressed())
     {
         NumCompressedChunks = 1;
@@ -106,11 +122,16 @@ int main(int argN, char* argV[])
     else
     {
         cout << "Writing package summary...\n";
-        SerializeSummary(Summary, decompressed_stream);
+        SerializeSummary(Summary, summary_stream);
     }
+    string serializedSummary = summary_stream.str();
 
-    cout << "Decompressing package...\n";
+    cout << "Reading compressed chunks...\n";
 
+    /// read all the chunk headers and collect blocks for decompression
+    /// blocks from all the chunks are then decompressed together
+    vector<DecompressionTask> Tasks;
+    size_t decompressedSize = serializedSummary.size();
     for (unsigned int i = 0; i < NumCompressedChunks; ++i)
     {
         if (PackageInfo.IsFullyCompressed())
@@ -122,67 +143,102 @@ int main(int argN, char* argV[])
             package_stream.seekg(Summary.CompressedChunks[i].CompressedOffset);
         }
 
-        cout << "Decompressing chunk #" << i << endl;
+        cout << "Chunk #" << i << endl;
 
-        uint32_t tag = 0;
-        package_stream.read(reinterpret_cast<char*>(&tag), 4);
-        if (tag != 0x9E2A83C1)
+        LZOChunkHeader ChunkHeader;
+        if (!LZOReadChunkHeader(package_stream, ChunkHeader))
         {
-            cerr << "Missing magic number!\n";
+            cerr << "Bad chunk header!\n";
             return 1;
         }
-        uint32_t blockSize = 0;
-        package_stream.read(reinterpret_cast<char*>(&blockSize), 4);
-        if (blockSize != IN_LEN)
+        unsigned numBlocks = ChunkHeader.Blocks.size();
+        cout << "Num blocks: " << numBlocks << endl;
+        cout << "Compressed size: " << ChunkHeader.CompressedSize
+             << "\tUncompressed size: " << ChunkHeader.UncompressedSize << endl;
+        for (unsigned i = 0; i < numBlocks; ++i)
         {
-            cerr << "Incorrect max block size!\n";
-            return 1;
+            cout << "Compressed size: " << ChunkHeader.Blocks[i].CompressedSize
+                 << "\tUncompressed size: " << ChunkHeader.Blocks[i].UncompressedSize << endl;
         }
-        vector<uint32_t> sizes(2); /// compressed/uncompressed pairs
-        package_stream.read(reinterpret_cast<char*>(sizes.data()), 4 * sizes.size());
-        size_t dataSize = sizes[1]; /// uncompressed data chunk size
-        unsigned numBlocks = (dataSize + blockSize - 1) / blockSize;
-        cout << "Num blocks: " << numBlocks << endl;
-        if (numBlocks < 1)
+        size_t blockOffset = package_stream.tellg();
+        size_t dataOffset = decompressedSize;
+        if (blockOffset + ChunkHeader.CompressedSize > packageSize)
         {
             cerr << "Bad data!\n";
             return 1;
         }
-        sizes.resize((numBlocks + 1)*2);
-        package_stream.read(reinterpret_cast<char*>(sizes.data()) + 8, 4 * sizes.size() - 8);
-        for (unsigned i = 0; i <= numBlocks; ++i)
+        for (unsigned i = 0; i < numBlocks; ++i)
+        {
+            DecompressionTask Task;
+            Task.CompressedOffset = blockOffset;
+            Task.CompressedSize = ChunkHeader.Blocks[i].CompressedSize;
+            Task.UncompressedOffset = dataOffset;
+            Task.UncompressedSize = ChunkHeader.Blocks[i].UncompressedSize;
+            Tasks.push_back(Task);
+            blockOffset += Task.CompressedSize;
+            dataOffset += Task.UncompressedSize;
+        }
+        decompressedSize = dataOffset;
+    }
+
+    cout << "Decompressing package using " << NumThreads << " thread(s)...\n";
+
+    chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+
+    decompressedPackage.write(serializedSummary.data(), serializedSummary.size());
+
+    /// blocks are processed in small batches: read sequentially, decompressed
+    /// in parallel and written to the output file at their final offsets,
+    /// so memory usage does not depend on package size
+    size_t batchSize = NumThreads * BLOCKS_PER_THREAD;
+    vector<vector<char> > compressedBlocks(batchSize, vector<char>(LZO_MAX_PACKED_SIZE));
+    vector<vector<char> > decompressedBlocks(batchSize, vector<char>(LZO_CHUNK_BLOCK_SIZE));
+    vector<char> taskErrors(batchSize);
+    for (size_t first = 0; first < Tasks.size(); first += batchSize)
+    {
+        size_t count = min(batchSize, Tasks.size() - first);
+        for (size_t i = 0; i < count; ++i)
         {
-            cout << "Compressed size: " << sizes[i * 2]
-                 << "\tUncompressed size: " << sizes[i * 2 + 1] << endl;
+            package_stream.seekg(Tasks[first + i].CompressedOffset);
+            package_stream.read(compressedBlocks[i].data(), Tasks[first + i].CompressedSize);
         }
-        vector<unsigned char> dataChunk(dataSize);
-        vector<unsigned char> compressedData(sizes[0]);
-        package_stream.read(reinterpret_cast<char*>(compressedData.data()), compressedData.size());
-        size_t blockOffset = 0;
-        size_t dataOffset = 0;
-        for (unsigned i = 1; i <= numBlocks; ++i)
+        if (!package_stream.good())
         {
-            out_len = sizes[i * 2]; /// compressed size
-            lzo_memcpy(out, compressedData.data() + blockOffset, out_len);
-            in_len = sizes[i * 2 + 1]; /// uncompressed size
-            new_len = in_len;
-            lzo_err = lzo1x_decompress(out, out_len, in, &new_len, NULL);
-            if (lzo_err == LZO_E_OK && new_len == in_len)
-                cout << "decompressed " << (unsigned long) out_len << " bytes back into "
-                     << (unsigned long) in_len << endl;
-            else
+            cerr << "Error reading compressed data!\n";
+            return 1;
+        }
+        ParallelFor(count, NumThreads, [&](size_t i)
+        {
+            const DecompressionTask& Task = Tasks[first + i];
+            taskErrors[i] = !LZODecompressBlock(compressedBlocks[i].data(), Task.CompressedSize,
+                                                decompressedBlocks[i].data(), Task.UncompressedSize);
+        });
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (taskErrors[i] != 0)
             {
                 cout << "LZO library internal error: decompression failed!!!\n";
                 return 1;
             }
-            lzo_memcpy(dataChunk.data() + dataOffset, in, in_len);
-            blockOffset += out_len;
-            dataOffset += in_len;
+            decompressedPackage.seekp(Tasks[first + i].UncompressedOffset);
+            decompressedPackage.write(decompressedBlocks[i].data(), Tasks[first + i].UncompressedSize);
         }
-        decompressed_stream.write(reinterpret_cast<char*>(dataChunk.data()), dataSize);
     }
+    decompressedPackage.close();
+    if (!decompressedPackage.good())
+    {
+        cerr << "Error writing output file!!!\n";
+        return 1;
+    }
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - startTime;
 
-    decompressedPackage << decompressed_stream.str();
+    double megabytes = (decompressedSize - serializedSummary.size()) / (1024.0 * 1024.0);
+    cout << "Decompressed " << Tasks.size() << " blocks (" << fixed << setprecision(2) << megabytes << " MB) in "
+         << elapsed.count() << " s";
+    if (elapsed.count() > 0)
+        cout << " (" << megabytes / elapsed.count() << " MB/s)";
+    cout << endl;
 
     return 0;
 }
@@ -6,6 +6,7 @@
 #include <wx/filename.h>
 
 #include "UPKUtils.h"
+#include "ParallelFor.h"
 
 using namespace std;
 
@@ -13,7 +14,7 @@ string CreatePath(string fullName, string dirName)
 {
     string str = fullName;
     vector<string> names;
-    unsigned pos = str.find('.');
+    size_t pos = str.find('.');
     if (pos == string::npos)
         return (dirName + "\\" + str + ".txt");
     while (pos != string::npos)
@@ -37,13 +38,35 @@ int main(int argN, char* argV[])
 {
     cout << "DeserializeAll" << endl;
 
-    if (argN < 2 || argN > 3)
+    string NameMask = "";
+    unsigned NumThreads = 1;
+    vector<string> args;
+    for (int i = 1; i < argN; ++i)
     {
-        cerr << "Usage: DeserializeAll UnpackedResourceFile.upk [NameMask]" << endl;
+        string arg = argV[i];
+        if (arg == "-j" && i + 1 < argN)
+        {
+            NumThreads = GetNumThreads(atoi(argV[++i]));
+        }
+        else if (arg.substr(0, 2) == "-j" && arg.size() > 2)
+        {
+            NumThreads = GetNumThreads(atoi(arg.substr(2).c_str()));
+        }
+        else
+        {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.size() < 1 || args.size() > 2)
+    {
+        cerr << "Usage: DeserializeAll UnpackedResourceFile.upk [NameMask] [-j N]" << endl;
         return 1;
     }
 
-    UPKUtils package(argV[1]);
+    /// package is read-only, so it can be safely shared between worker threads
+    UPKUtils package;
+    package.ReadMapped(args[0].c_str());
 
     UPKReadErrors err = package.GetError();
 
@@ -55,12 +78,11 @@ int main(int argN, char* argV[])
         return 1;
     }
 
-    string NameMask = "";
-    if (argN == 3)
-        NameMask = argV[2];
+    if (args.size() == 2)
+        NameMask = args[1];
 
     wxString dirName;
-    wxFileName::SplitPath(argV[1], nullptr, nullptr, &dirName, nullptr);
+    wxFileName::SplitPath(args[0].c_str(), nullptr, nullptr, &dirName, nullptr);
 
     if (!wxDirExists(dirName))
         wxMkdir(dirName);
@@ -73,8 +95,11 @@ int main(int argN, char* argV[])
         << package.FormatExports(false);
     out.close();
 
-    vector<FObjectExport> ExportTable = package.GetExportTable();
+    const vector<FObjectExport>& ExportTable = package.GetExportTable();
 
+    /// create all the directories before deserializing anything,
+    /// so worker threads only write files
+    vector<pair<unsigned, string> > Jobs;
     for (unsigned i = 1; i < ExportTable.size(); ++i)
     {
         cout << ExportTable[i].FullName <<endl;
@@ -83,12 +108,16 @@ int main(int argN, char* argV[])
             if (ExportTable[i].FullName.find(NameMask) == string::npos)
                 continue;
         }
-        string filePath = CreatePath(ExportTable[i].FullName, dirName.ToStdString());
-        ofstream out(filePath);
-        out << package.FormatExport(i, true);
-        out << package.Deserialize(i, true);
-        out.close();
+        Jobs.push_back(make_pair(i, CreatePath(ExportTable[i].FullName, dirName.ToStdString())));
     }
 
+    ParallelFor(Jobs.size(), NumThreads, [&](size_t j)
+    {
+        ofstream out(Jobs[j].second);
+        out << package.FormatExport(Jobs[j].first, true);
+        out << package.Deserialize(Jobs[j].first, true);
+        out.close();
+    });
+
     return 0;
 }
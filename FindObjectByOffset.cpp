@@ -10,9 +10,9 @@ int main(int argN, char* argV[])
 {
     cout << "FindObjectByOffset" << endl;
 
-    if (argN != 3)
+    if (argN < 3)
     {
-        cerr << "Usage: FindObjectByOffset UnpackedResourceFile.upk offset" << endl;
+        cerr << "Usage: FindObjectByOffset UnpackedResourceFile.upk offset [offset ...]" << endl;
         return 1;
     }
 
@@ -23,16 +23,6 @@ int main(int argN, char* argV[])
         return 1;
     }
 
-    size_t Offset = 0;
-    string str(argV[2]);
-    istringstream ss(str);
-    if (str.find("0x") != string::npos)
-        ss >> hex >> Offset;
-    else
-        ss >> dec >> Offset;
-
-    cout << "Offset = " << FormatHEX((uint32_t)Offset) << " (" << Offset << ")\n";
-
     UPKInfo PackageInfo(package);
     UPKReadErrors err = PackageInfo.GetError();
     if (err != UPKReadErrors::NoErrors)
@@ -45,12 +35,29 @@ int main(int argN, char* argV[])
         return 1;
     }
 
-    UObjectReference ObjRef = PackageInfo.FindObjectByOffset(Offset);
-    if (ObjRef <= 0)
+    vector<size_t> Offsets;
+    for (int i = 2; i < argN; ++i)
     {
-        cerr << "Can't find object by specified offset!\n";
+        size_t Offset = 0;
+        string str(argV[i]);
+        istringstream ss(str);
+        if (str.find("0x") != string::npos)
+            ss >> hex >> Offset;
+        else
+            ss >> dec >> Offset;
+        Offsets.push_back(Offset);
+    }
+
+    vector<UObjectReference> ObjRefs = PackageInfo.FindObjectsByOffsets(Offsets);
+    for (unsigned i = 0; i < Offsets.size(); ++i)
+    {
+        cout << "Offset = " << FormatHEX((uint32_t)Offsets[i]) << " (" << Offsets[i] << ")\n";
+        if (ObjRefs[i] <= 0)
+        {
+            cerr << "Can't find object by specified offset!\n";
+        }
+        cout << "Found object: " << PackageInfo.GetExportEntry(ObjRefs[i]).FullName << std::endl;
     }
-    cout << "Found object: " << PackageInfo.GetExportEntry(ObjRef).FullName << std::endl;
 
     return 0;
 }
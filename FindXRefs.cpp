@@ -0,0 +1,118 @@
+#include <iostream>
+#include <cstdlib>
+
+#include "XRefIndex.h"
+#include "ParallelFor.h"
+
+using namespace std;
+
+string GetFullName(UObjectReference ObjRef, UPKUtils& package)
+{
+    if (ObjRef > 0)
+        return package.GetExportEntry(ObjRef).FullName;
+    return package.GetImportEntry(-ObjRef).FullName;
+}
+
+string FormatXRef(const FXRef& Ref, UPKUtils& package)
+{
+    string To = (Ref.ByName ? package.GetNameEntry(Ref.To).Name + " (by name)" : GetFullName(Ref.To, package));
+    return FormatXRefKind(Ref.Kind) + "\t" + GetFullName(Ref.From, package) + " -> " + To;
+}
+
+int main(int argN, char* argV[])
+{
+    cout << "FindXRefs" << endl;
+
+    unsigned NumThreads = GetNumThreads();
+    string Mode = "/to";
+    vector<string> args;
+    for (int i = 1; i < argN; ++i)
+    {
+        string arg = argV[i];
+        if (arg == "-j" && i + 1 < argN)
+        {
+            NumThreads = GetNumThreads(atoi(argV[++i]));
+        }
+        else if (arg.substr(0, 2) == "-j" && arg.size() > 2)
+        {
+            NumThreads = GetNumThreads(atoi(arg.substr(2).c_str()));
+        }
+        else if (arg == "/callers" || arg == "/callees" || arg == "/readers" || arg == "/to" || arg == "/from" || arg == "/name")
+        {
+            Mode = arg;
+        }
+        else
+        {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.size() < 1 || args.size() > 2)
+    {
+        cerr << "Usage: FindXRefs UnpackedResourceFile.upk [ObjectName] [/callers | /callees | /readers | /to | /from | /name] [-j N]" << endl;
+        return 1;
+    }
+
+    UPKUtils package;
+    package.ReadMapped(args[0].c_str());
+
+    UPKReadErrors err = package.GetError();
+
+    if (err != UPKReadErrors::NoErrors)
+    {
+        cerr << "Error reading package:\n" << FormatReadErrors(err);
+        if (package.IsCompressed())
+            cerr << "Compression flags:\n" << FormatCompressionFlags(package.GetCompressionFlags());
+        return 1;
+    }
+
+    XRefIndex Index;
+    Index.Build(package, NumThreads);
+
+    cout << "Scripts indexed: " << Index.GetNumScripts() << endl
+         << "Scripts with decoding errors: " << Index.GetNumBadScripts() << endl
+         << "References found: " << Index.GetNumRefs() << endl;
+
+    if (args.size() < 2)
+        return 0;
+
+    string NameToFind = args[1];
+    vector<FXRef> Refs;
+
+    if (Mode == "/name")
+    {
+        int NameIdx = package.FindName(NameToFind);
+        if (NameIdx < 0)
+        {
+            cerr << "Can't find name " << NameToFind << endl;
+            return 1;
+        }
+        Refs = Index.FindReferencesToName(NameIdx);
+    }
+    else
+    {
+        UObjectReference ObjRef = package.FindObject(NameToFind, false);
+        if (ObjRef == 0)
+        {
+            cerr << "Can't find object entry by name " << NameToFind << endl;
+            return 1;
+        }
+        if (Mode == "/callers")
+            Refs = Index.FindCallers(ObjRef, package);
+        else if (Mode == "/callees")
+            Refs = Index.FindCallees(ObjRef);
+        else if (Mode == "/readers")
+            Refs = Index.FindReaders(ObjRef);
+        else if (Mode == "/from")
+            Refs = Index.FindReferencesFrom(ObjRef);
+        else
+            Refs = Index.FindReferencesTo(ObjRef);
+    }
+
+    for (unsigned i = 0; i < Refs.size(); ++i)
+    {
+        cout << FormatXRef(Refs[i], package) << endl;
+    }
+
+    return 0;
+}
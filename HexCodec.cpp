@@ -0,0 +1,108 @@
+#include "HexCodec.h"
+
+#include <sstream>
+#include <cstdint>
+
+static const char HexDigits[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
+
+/// hex digit values and white-space flags for all the characters
+class HexTables
+{
+public:
+    HexTables()
+    {
+        for (unsigned i = 0; i < 256; ++i)
+        {
+            Value[i] = -1;
+            Space[i] = false;
+        }
+        for (unsigned i = 0; i < 10; ++i)
+            Value['0' + i] = i;
+        for (unsigned i = 0; i < 6; ++i)
+            Value['A' + i] = Value['a' + i] = 10 + i;
+        /// same white-spaces as std::isspace in "C" locale
+        Space[(uint8_t)' '] = Space[(uint8_t)'\t'] = Space[(uint8_t)'\n'] = true;
+        Space[(uint8_t)'\v'] = Space[(uint8_t)'\f'] = Space[(uint8_t)'\r'] = true;
+    }
+    int8_t Value[256];
+    bool Space[256];
+};
+
+static const HexTables Tables;
+
+std::string EncodeHEX(const char* data, size_t size)
+{
+    std::string ret(size * 3, ' ');
+    char* out = &ret[0];
+    for (size_t i = 0; i < size; ++i)
+    {
+        uint8_t ch = data[i];
+        out[0] = HexDigits[ch >> 4];
+        out[1] = HexDigits[ch & 0x0F];
+        out += 3;
+    }
+    return ret;
+}
+
+std::string EncodeHEXBlock(const char* data, size_t size)
+{
+    size_t numLines = (size > 0 ? (size - 1) / 16 : 0);
+    std::string ret(size * 3 + numLines + 1, ' ');
+    char* out = &ret[0];
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (i % 16 == 0 && i != 0)
+            *out++ = '\n';
+        uint8_t ch = data[i];
+        out[0] = HexDigits[ch >> 4];
+        out[1] = HexDigits[ch & 0x0F];
+        out += 3;
+    }
+    *out = '\n';
+    return ret;
+}
+
+std::vector<char> DecodeHEX(const char* text, size_t size)
+{
+    std::vector<char> data;
+    data.reserve(size / 3 + 1);
+    const uint8_t* str = reinterpret_cast<const uint8_t*>(text);
+    size_t pos = 0;
+    while (pos < size)
+    {
+        if (Tables.Space[str[pos]])
+        {
+            ++pos;
+            continue;
+        }
+        /// one or two hex digits, followed by a white-space or the end of text
+        int hi = Tables.Value[str[pos]];
+        if (hi >= 0)
+        {
+            if (pos + 1 == size || Tables.Space[str[pos + 1]])
+            {
+                data.push_back(hi);
+                pos += 1;
+                continue;
+            }
+            int lo = Tables.Value[str[pos + 1]];
+            if (lo >= 0 && (pos + 2 == size || Tables.Space[str[pos + 2]]))
+            {
+                data.push_back((hi << 4) | lo);
+                pos += 2;
+                continue;
+            }
+        }
+        /// other numbers (0x prefixes, long values, bad data) are read by stream
+        std::istringstream ss(std::string(text + pos, size - pos));
+        while (ss.good())
+        {
+            int byte;
+            ss >> std::hex >> byte;
+            if (!ss.fail() && !ss.bad())
+                data.push_back(byte);
+        }
+        break;
+    }
+    return data;
+}
@@ -0,0 +1,18 @@
+#ifndef HEXCODEC_H
+#define HEXCODEC_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+/// table-driven hex text encoding and decoding
+/// output buffers are allocated once from the known data size
+
+/// "XX " for each byte
+std::string EncodeHEX(const char* data, size_t size);
+/// "XX " for each byte, 16 bytes per line, text ends with a new line
+std::string EncodeHEXBlock(const char* data, size_t size);
+/// white-space separated hex numbers to bytes, the result is the same as reading text with std::hex
+std::vector<char> DecodeHEX(const char* text, size_t size);
+
+#endif // HEXCODEC_H
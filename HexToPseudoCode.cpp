@@ -22,7 +22,8 @@ int main(int argN, char* argV[])
         return 1;
     }
 
-    UPKUtils package(argV[1]);
+    UPKUtils package;
+    package.ReadMapped(argV[1]);
 
     UPKReadErrors err = package.GetError();
 
@@ -66,13 +67,11 @@ int main(int argN, char* argV[])
 
     //cout << "Attempting deserialization:\n";
 
-    vector<char> ObjData = package.GetExportData(ObjRef);
-    stringstream stream;
-    stream.write(ObjData.data(), ObjData.size());
+    UPKMemoryStream stream(package.GetExportDataView(ObjRef));
     size_t ScrPos = package.GetScriptRelOffset(ObjRef);
     stream.seekg(ScrPos);
 
-    UScriptCode ScrCode;
+    UScriptCode ScrCode(ObjRef);
     string PseudoCode = ScrCode.Deserialize(stream, package);
     cout << "//This script was generated by HexToPseudoCode decompiler for use with PatchUPK/PatcherGUI tool\n"
          << "UPK_FILE = " << GetFilename(argV[1]) << "\n"
@@ -0,0 +1,149 @@
+#include "LZOCodec.h"
+
+#include <atomic>
+#include <cstring>
+#include <sstream>
+
+#include "ParallelFor.h"
+#include "minilzo.h"
+
+bool LZOInit()
+{
+    return (lzo_init() == LZO_E_OK);
+}
+
+bool LZOReadChunkHeader(std::istream& stream, LZOChunkHeader& header)
+{
+    header.Blocks.clear();
+    stream.read(reinterpret_cast<char*>(&header.Tag), 4);
+    stream.read(reinterpret_cast<char*>(&header.BlockSize), 4);
+    stream.read(reinterpret_cast<char*>(&header.CompressedSize), 4);
+    stream.read(reinterpret_cast<char*>(&header.UncompressedSize), 4);
+    if (!stream.good() || header.Tag != LZO_CHUNK_TAG || header.BlockSize != LZO_CHUNK_BLOCK_SIZE)
+        return false;
+    size_t numBlocks = (header.UncompressedSize + header.BlockSize - 1) / header.BlockSize;
+    if (numBlocks < 1)
+        return false;
+    header.Blocks.resize(numBlocks);
+    stream.read(reinterpret_cast<char*>(header.Blocks.data()), sizeof(LZOChunkBlock) * numBlocks);
+    if (!stream.good())
+        return false;
+    /// validate block sizes against chunk sizes
+    size_t compressedSize = 0, uncompressedSize = 0;
+    for (size_t i = 0; i < numBlocks; ++i)
+    {
+        if (header.Blocks[i].CompressedSize > LZO_MAX_PACKED_SIZE || header.Blocks[i].UncompressedSize > header.BlockSize)
+            return false;
+        compressedSize += header.Blocks[i].CompressedSize;
+        uncompressedSize += header.Blocks[i].UncompressedSize;
+    }
+    return (compressedSize == header.CompressedSize && uncompressedSize == header.UncompressedSize);
+}
+
+size_t LZOGetChunkHeaderSize(const LZOChunkHeader& header)
+{
+    return 16 + sizeof(LZOChunkBlock) * header.Blocks.size();
+}
+
+bool LZODecompressBlock(const char* src, size_t srcSize, char* dst, size_t dstSize)
+{
+    lzo_uint new_len = dstSize;
+    int err = lzo1x_decompress_safe(reinterpret_cast<const unsigned char*>(src), srcSize,
+                                    reinterpret_cast<unsigned char*>(dst), &new_len, NULL);
+    return (err == LZO_E_OK && new_len == dstSize);
+}
+
+bool LZODecompressBlocks(const LZOChunkHeader& header, const char* src, char* dst, unsigned numThreads)
+{
+    /// block offsets are known from the header, so blocks are decompressed
+    /// independently straight into their final place
+    std::vector<size_t> srcOffsets(header.Blocks.size()), dstOffsets(header.Blocks.size());
+    size_t srcOffset = 0, dstOffset = 0;
+    for (size_t i = 0; i < header.Blocks.size(); ++i)
+    {
+        srcOffsets[i] = srcOffset;
+        dstOffsets[i] = dstOffset;
+        srcOffset += header.Blocks[i].CompressedSize;
+        dstOffset += header.Blocks[i].UncompressedSize;
+    }
+    std::atomic<bool> ok(true);
+    ParallelFor(header.Blocks.size(), GetNumThreads(numThreads), [&](size_t i)
+    {
+        if (!LZODecompressBlock(src + srcOffsets[i], header.Blocks[i].CompressedSize,
+                                dst + dstOffsets[i], header.Blocks[i].UncompressedSize))
+            ok = false;
+    });
+    return ok;
+}
+
+bool LZODecompressChunk(const char* chunk, size_t chunkSize, std::vector<char>& data, unsigned numThreads)
+{
+    /// uncompressed size gives the number of blocks and thus the header size
+    if (chunkSize < 16)
+        return false;
+    uint32_t uncompressedSize = 0;
+    memcpy(&uncompressedSize, chunk + 12, 4);
+    size_t headerSize = 16 + sizeof(LZOChunkBlock) * ((uncompressedSize + LZO_CHUNK_BLOCK_SIZE - 1) / LZO_CHUNK_BLOCK_SIZE);
+    if (headerSize > chunkSize)
+        return false;
+    LZOChunkHeader header;
+    std::istringstream headerStream(std::string(chunk, headerSize));
+    if (!LZOReadChunkHeader(headerStream, header) || headerSize + header.CompressedSize > chunkSize)
+        return false;
+    data.resize(header.UncompressedSize);
+    return LZODecompressBlocks(header, chunk + headerSize, data.data(), numThreads);
+}
+
+bool LZOCompressChunk(const char* data, size_t dataSize, std::vector<char>& chunk, unsigned numThreads)
+{
+    if (dataSize < 1 || dataSize > 0xFFFFFFFFu)
+        return false;
+    numThreads = GetNumThreads(numThreads);
+    size_t numBlocks = (dataSize + LZO_CHUNK_BLOCK_SIZE - 1) / LZO_CHUNK_BLOCK_SIZE;
+    /// blocks are compressed into separate buffers, each worker has its own working memory
+    std::vector<std::vector<unsigned char> > packedBlocks(numBlocks);
+    std::vector<std::vector<lzo_align_t> > wrkmem(numThreads < numBlocks ? numThreads : numBlocks,
+        std::vector<lzo_align_t>((LZO1X_1_MEM_COMPRESS + sizeof(lzo_align_t) - 1) / sizeof(lzo_align_t)));
+    std::atomic<bool> ok(true);
+    ParallelForWorkers(numBlocks, numThreads, [&](size_t i, unsigned worker)
+    {
+        size_t offset = i * LZO_CHUNK_BLOCK_SIZE;
+        lzo_uint in_len = (dataSize - offset < LZO_CHUNK_BLOCK_SIZE ? dataSize - offset : LZO_CHUNK_BLOCK_SIZE);
+        lzo_uint out_len = 0;
+        packedBlocks[i].resize(LZO_MAX_PACKED_SIZE);
+        int err = lzo1x_1_compress(reinterpret_cast<const unsigned char*>(data) + offset, in_len,
+                                   packedBlocks[i].data(), &out_len, wrkmem[worker].data());
+        if (err != LZO_E_OK)
+            ok = false;
+        packedBlocks[i].resize(out_len);
+    });
+    if (!ok)
+        return false;
+    /// build header and concatenate compressed blocks
+    LZOChunkHeader header;
+    header.Tag = LZO_CHUNK_TAG;
+    header.BlockSize = LZO_CHUNK_BLOCK_SIZE;
+    header.CompressedSize = 0;
+    header.UncompressedSize = dataSize;
+    header.Blocks.resize(numBlocks);
+    for (size_t i = 0; i < numBlocks; ++i)
+    {
+        header.Blocks[i].CompressedSize = packedBlocks[i].size();
+        header.Blocks[i].UncompressedSize = (i + 1 < numBlocks ? LZO_CHUNK_BLOCK_SIZE : dataSize - i * LZO_CHUNK_BLOCK_SIZE);
+        header.CompressedSize += packedBlocks[i].size();
+    }
+    size_t headerSize = LZOGetChunkHeaderSize(header);
+    chunk.resize(headerSize + header.CompressedSize);
+    memcpy(chunk.data(), &header.Tag, 4);
+    memcpy(chunk.data() + 4, &header.BlockSize, 4);
+    memcpy(chunk.data() + 8, &header.CompressedSize, 4);
+    memcpy(chunk.data() + 12, &header.UncompressedSize, 4);
+    memcpy(chunk.data() + 16, header.Blocks.data(), sizeof(LZOChunkBlock) * numBlocks);
+    size_t offset = headerSize;
+    for (size_t i = 0; i < numBlocks; ++i)
+    {
+        memcpy(chunk.data() + offset, packedBlocks[i].data(), packedBlocks[i].size());
+        offset += packedBlocks[i].size();
+    }
+    return true;
+}
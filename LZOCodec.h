@@ -0,0 +1,47 @@
+#ifndef LZOCODEC_H
+#define LZOCODEC_H
+
+#include <cstdint>
+#include <istream>
+#include <vector>
+
+/// chunked LZO data format, used by compressed packages:
+/// tag, block size, (compressed size, uncompressed size) of the whole chunk,
+/// (compressed size, uncompressed size) pairs for each block, compressed blocks
+
+#define LZO_CHUNK_TAG           0x9E2A83C1
+#define LZO_CHUNK_BLOCK_SIZE    (131072u)                                   /// max uncompressed block size
+#define LZO_MAX_PACKED_SIZE     (LZO_CHUNK_BLOCK_SIZE + LZO_CHUNK_BLOCK_SIZE / 16 + 64 + 3) /// max compressed block size
+
+struct LZOChunkBlock
+{
+    uint32_t CompressedSize;
+    uint32_t UncompressedSize;
+};
+
+struct LZOChunkHeader
+{
+    uint32_t Tag;
+    uint32_t BlockSize;
+    uint32_t CompressedSize;
+    uint32_t UncompressedSize;
+    std::vector<LZOChunkBlock> Blocks;
+};
+
+/// initialize LZO library, returns false if library is not usable
+bool LZOInit();
+/// read and validate chunk header
+bool LZOReadChunkHeader(std::istream& stream, LZOChunkHeader& header);
+/// serialized chunk header size
+size_t LZOGetChunkHeaderSize(const LZOChunkHeader& header);
+/// decompress single block
+bool LZODecompressBlock(const char* src, size_t srcSize, char* dst, size_t dstSize);
+/// decompress all blocks of a chunk in parallel
+/// src points to compressed blocks (header.CompressedSize bytes), dst receives header.UncompressedSize bytes
+bool LZODecompressBlocks(const LZOChunkHeader& header, const char* src, char* dst, unsigned numThreads = 0);
+/// decompress whole chunk (header + compressed blocks)
+bool LZODecompressChunk(const char* chunk, size_t chunkSize, std::vector<char>& data, unsigned numThreads = 0);
+/// compress data into chunk (header + compressed blocks), blocks are compressed in parallel
+bool LZOCompressChunk(const char* data, size_t dataSize, std::vector<char>& chunk, unsigned numThreads = 0);
+
+#endif // LZOCODEC_H
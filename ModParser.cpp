@@ -1,8 +1,10 @@
 #include "ModParser.h"
+#include "HexCodec.h"
 
 #include <iostream>
 #include <sstream>
 #include <cstring>
+#include <cstdio>
 #include <cctype>
 
 std::string Trim(std::string str)
@@ -38,24 +40,9 @@ size_t SplitAt(char ch, std::string in, std::string& out1, std::string& out2)
     return pos;
 }
 
-const char chLookup[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
-
 std::string MakeTextBlock(char *data, size_t dataSize)
 {
-    std::string out = "";
-    for (unsigned i = 0; i < dataSize; ++i)
-    {
-        if ((i%16 == 0) && (i != 0))
-            out += '\n';
-        uint8_t ch = data[i];
-        uint8_t up = ((ch & 0xF0) >> 4);
-        uint8_t lw =  (ch & 0x0F);
-        out += chLookup[up];
-        out += chLookup[lw];
-        out += ' ';
-    }
-    out += '\n';
-    return out;
+    return EncodeHEXBlock(data, dataSize);
 }
 
 std::string GetFilename(std::string str)
@@ -81,18 +68,7 @@ std::string GetStringValue(const std::string& TextBuffer)
 
 std::vector<char> GetDataChunk(const std::string& TextBuffer)
 {
-    std::vector<char> data;
-    if (TextBuffer.length() < 1)
-        return data;
-    std::istringstream ss(TextBuffer);
-    while (ss.good())
-    {
-        int byte;
-        ss >> std::hex >> byte;
-        if (!ss.fail() && !ss.bad())
-            data.push_back(byte);
-    }
-    return data;
+    return DecodeHEX(TextBuffer.data(), TextBuffer.length());
 }
 
 int GetIntValue(const std::string& TextBuffer)
@@ -136,46 +112,6 @@ float GetFloatValue(const std::string& TextBuffer)
     return val;
 }
 
-std::string ModParser::GetText()
-{
-    std::string str = "";
-    std::string line = "";
-    size_t savedPos = modFile.tellg();
-    line = GetLine(); /// read key/section line
-    if (isKey)
-    {
-        str += line.substr(line.find("=") + 1);
-        while ( modFile.good() )
-        {
-            savedPos = modFile.tellg();
-            line = GetLine();
-            if (FindKey(line) != -1 || FindSection(line) != -1)
-            {
-                modFile.clear(); /// to parse last line correctly
-                break;
-            }
-            str += std::string("\n") + line;
-        }
-    }
-    else if (isSection)
-    {
-        while ( modFile.good() )
-        {
-            savedPos = modFile.tellg();
-            line = GetLine();
-            if (FindKey(line) != -1 || FindSection(line) != -1)
-            {
-                modFile.clear(); /// to parse last line correctly
-                break;
-            }
-            if (str != "") str += "\n";
-            str += line;
-        }
-    }
-    modFile.seekg(savedPos, std::ios::beg);
-    return str;
-}
-
 std::string ModParser::GetTextValue()
 {
     return Value;
@@ -201,92 +137,157 @@ float ModParser::GetFloatValue()
     return ::GetFloatValue(Value);
 }
 
-std::string ModParser::GetLine()
+/// in-memory mod file reader with the same end of data behavior as istream get() and peek()
+class ModTextReader
 {
-    std::string line = "";
-    int ch = 0;
-    while(ch != 0x0D && ch != 0x0A && modFile.good())
+public:
+    ModTextReader(const std::string& data): Data(data.data()), Size(data.size()), Pos(0), Good(true), ASCII(true) {}
+    int Get()
+    {
+        if (!Good || Pos >= Size)
+        {
+            Good = false;
+            return EOF;
+        }
+        int ch = (uint8_t)Data[Pos++];
+        if (ch < 1 || ch > 127)
+            ASCII = false;
+        return ch;
+    }
+    int Peek()
     {
-        ch = modFile.get();
-        if (modFile.fail() || modFile.bad())
-            break;
-        if (CStyleComments && ch == '/' && modFile.peek() == '/')
+        if (!Good || Pos >= Size)
         {
-            while (ch != 0x0D && ch != 0x0A && modFile.good())
-                ch = modFile.get();
+            Good = false;
+            return EOF;
         }
-        else if (CStyleComments && ch == '/' && modFile.peek() == '*')
+        return (uint8_t)Data[Pos];
+    }
+    bool IsGood() { return Good; }
+    bool IsASCII() { return ASCII; }
+private:
+    const char* Data;
+    size_t Size;
+    size_t Pos;
+    bool Good;
+    bool ASCII;
+};
+
+bool ModParser::Lex(const std::string& data)
+{
+    Text.clear();
+    Records.clear();
+    NextRecord = 0;
+    Text.reserve(data.size());
+    ModTextReader Reader(data);
+    FModRecord* Record = nullptr;
+    while (Reader.IsGood())
+    {
+        /// read one line, skipping comments
+        size_t LineBegin = Text.size();
+        int ch = 0;
+        while (ch != 0x0D && ch != 0x0A && Reader.IsGood())
         {
-            while (modFile.good())
+            ch = Reader.Get();
+            if (!Reader.IsGood())
+                break;
+            if (CStyleComments && ch == '/' && Reader.Peek() == '/')
             {
-                ch = modFile.get();
-                if (ch == '*' && modFile.peek() == '/')
+                while (ch != 0x0D && ch != 0x0A && Reader.IsGood())
+                    ch = Reader.Get();
+            }
+            else if (CStyleComments && ch == '/' && Reader.Peek() == '*')
+            {
+                while (Reader.IsGood())
                 {
-                    ch = modFile.get();
-                    break;
+                    ch = Reader.Get();
+                    if (ch == '*' && Reader.Peek() == '/')
+                    {
+                        ch = Reader.Get();
+                        break;
+                    }
                 }
             }
+            else if (ch == commentLine)
+            {
+                while (ch != 0x0D && ch != 0x0A && Reader.IsGood())
+                    ch = Reader.Get();
+            }
+            else if (ch == commentBegin)
+            {
+                while (ch != commentEnd && Reader.IsGood())
+                    ch = Reader.Get();
+            }
+            else if (ch != 0x0D && ch != 0x0A && Reader.IsGood())
+            {
+                Text += (char)ch;
+            }
         }
-        else if (ch == commentLine)
-        {
-            while (ch != 0x0D && ch != 0x0A && modFile.good())
-                ch = modFile.get();
-        }
-        else if (ch == commentBegin)
+        if (Reader.Peek() == 0x0A || Reader.Peek() == 0x0D)
+            Reader.Get();
+        if (!Reader.IsASCII())
+            return false;
+        size_t LineEnd = Text.size();
+        Text += '\n';
+        /// check for key or section, most of the lines are neither
+        const char* line = Text.data() + LineBegin;
+        size_t lineSize = LineEnd - LineBegin;
+        int keyIdx = -1, sectionIdx = -1;
+        if (memchr(line, '=', lineSize) != nullptr)
+            keyIdx = FindKey(Text.substr(LineBegin, lineSize));
+        if (memchr(line, '[', lineSize) != nullptr && memchr(line, ']', lineSize) != nullptr)
+            sectionIdx = FindSection(Text.substr(LineBegin, lineSize));
+        if (keyIdx != -1 || sectionIdx != -1)
         {
-            while (ch != commentEnd && modFile.good())
-                ch = modFile.get();
+            FModRecord NewRecord;
+            NewRecord.Index = (sectionIdx != -1 ? sectionIdx : keyIdx);
+            NewRecord.IsKey = (keyIdx != -1);
+            NewRecord.IsSection = (sectionIdx != -1);
+            /// key value begins on the key line, section value begins on the next line
+            if (NewRecord.IsKey)
+                NewRecord.ValueBegin = Text.find('=', LineBegin) + 1;
+            else
+                NewRecord.ValueBegin = LineEnd;
+            NewRecord.ValueEnd = LineEnd;
+            Records.push_back(NewRecord);
+            Record = &Records.back();
         }
-        else if (ch != 0x0D && ch != 0x0A && modFile.good())
+        else if (Record != nullptr)
         {
-            line += ch;
+            /// section value skips leading empty lines
+            if (Record->IsKey || Record->ValueBegin != Record->ValueEnd)
+            {
+                Record->ValueEnd = LineEnd;
+            }
+            else if (LineEnd != LineBegin)
+            {
+                Record->ValueBegin = LineBegin;
+                Record->ValueEnd = LineEnd;
+            }
         }
     }
-    if (modFile.peek() == 0x0A || modFile.peek() == 0x0D)
-        modFile.get();
-    return line;
+    return true;
 }
 
 int ModParser::FindNext()
 {
-    if (!modFile.good())
-        return -1;
     Name = "";
     Value = "";
     Index = -1;
-    int idx = -1, keyIdx = -1, sectionIdx = -1;
-    std::string line = "";
-    size_t savedPos = modFile.tellg();
-    while ( keyIdx == -1 && sectionIdx == -1 && modFile.good() )
-    {
-        savedPos = modFile.tellg();
-        line = GetLine();
-        keyIdx = FindKey(line);
-        sectionIdx = FindSection(line);
-    }
-    modFile.clear(); /// to get last line value correctly
-    modFile.seekg(savedPos, std::ios::beg);
-    isKey = (keyIdx != -1);
-    isSection = (sectionIdx != -1);
-    if (keyIdx != -1)
-    {
-        idx = keyIdx;
-        Name = keyNames[idx];
-    }
-    if (sectionIdx != -1)
-    {
-        idx = sectionIdx;
-        Name = sectionNames[idx];
-    }
-    if (idx != -1)
-    {
-        Value = GetText();
-    }
-    Index = idx;
-    return idx;
+    isKey = false;
+    isSection = false;
+    if (NextRecord >= Records.size())
+        return -1;
+    const FModRecord& Record = Records[NextRecord++];
+    isKey = Record.IsKey;
+    isSection = Record.IsSection;
+    Index = Record.Index;
+    Name = (isSection ? sectionNames[Index] : keyNames[Index]);
+    Value = Text.substr(Record.ValueBegin, Record.ValueEnd - Record.ValueBegin);
+    return Index;
 }
 
-int ModParser::FindKey(std::string str)
+int ModParser::FindKey(const std::string& str)
 {
     size_t pos = str.find("=");
     if (pos == std::string::npos)
@@ -299,7 +300,7 @@ int ModParser::FindKey(std::string str)
     return idx;
 }
 
-int ModParser::FindSection(std::string str)
+int ModParser::FindSection(const std::string& str)
 {
     if (str.find("[") == std::string::npos || str.find("]") == std::string::npos)
         return -1;
@@ -331,33 +332,29 @@ int ModParser::FindSectionNameIdx(std::string name)
 
 bool ModParser::OpenModFile(const char* name)
 {
-    if (modFile.is_open())
-    {
-        modFile.close();
-        modFile.clear();
-    }
-    modFile.open(name, std::ios::binary);
-    if (!modFile.good())
-        return false;
-    /// check if file is text
-    while (modFile.good())
-    {
-        char ch = modFile.get();
-        if (modFile.eof())
-            break;
-        if (ch < 1 || ch > 127)
-        {
-            modFile.close();
-            return false;
-        }
-    }
-    modFile.clear();
-    modFile.seekg(0);
+    Text.clear();
+    Records.clear();
+    NextRecord = 0;
     isKey = false;
     isSection = false;
     Name = "";
     Value = "";
     Index = -1;
+    std::ifstream modFile(name, std::ios::binary | std::ios::ate);
+    if (!modFile.good())
+        return false;
+    size_t modFileSize = modFile.tellg();
+    std::string data(modFileSize, '\0');
+    modFile.seekg(0);
+    if (modFileSize > 0 && !modFile.read(&data[0], modFileSize))
+        return false;
+    /// fails if file is not text
+    if (!Lex(data))
+    {
+        Text.clear();
+        Records.clear();
+        return false;
+    }
     return true;
 }
 
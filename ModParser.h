@@ -15,10 +15,20 @@ int GetIntValue(const std::string& TextBuffer);
 unsigned GetUnsignedValue(const std::string& TextBuffer);
 float GetFloatValue(const std::string& TextBuffer);
 
+/// key or section found in mod file and its text value span
+struct FModRecord
+{
+    int Index;
+    bool IsKey;
+    bool IsSection;
+    size_t ValueBegin;
+    size_t ValueEnd;
+};
+
 class ModParser
 {
 public:
-    ModParser(): commentBegin(0), commentEnd(0), commentLine(0), isKey(false), isSection(false), Name(""), Value(""), Index(-1), CStyleComments(true) {}
+    ModParser(): commentBegin(0), commentEnd(0), commentLine(0), isKey(false), isSection(false), Name(""), Value(""), Index(-1), CStyleComments(true), NextRecord(0) {}
     ~ModParser() {}
     /// keys, sections and comments
     void AddKeyName(std::string name);
@@ -28,10 +38,11 @@ public:
     void ClearKeyNames() { keyNames.clear(); }
     void ClearSectionNames() { sectionNames.clear(); }
     void SetCommentMarkers(char begMarker, char endMarker, char lineMarker);
-    /// init
+    /// init: keys, sections and comment markers must be set before opening mod file
+    /// file is loaded and split into key/section records in one pass
     bool OpenModFile(const char* name);
     void UseCStyleComments(bool val) { CStyleComments = val; }
-    /// find next key or section, set read pointer at the beginning of the line
+    /// find next key or section
     int FindNext();
     /// Getters
     std::string GetTextValue();
@@ -43,16 +54,14 @@ public:
     std::string GetName() { return Name; }
     std::string GetValue() { return Value; }
 protected:
-    std::string GetLine();
-    std::string GetText();
-    int FindKey(std::string str);
-    int FindSection(std::string str);
+    bool Lex(const std::string& data);
+    int FindKey(const std::string& str);
+    int FindSection(const std::string& str);
     int FindKeyNameIdx(std::string name);
     int FindSectionNameIdx(std::string name);
     bool IsKey() { return isKey; }
     bool IsSection() { return isSection; }
 private:
-    std::ifstream modFile;
     std::vector<std::string> keyNames;
     std::vector<std::string> sectionNames;
     char commentBegin;
@@ -64,6 +73,10 @@ private:
     std::string Value;
     int Index;
     bool CStyleComments;
+    /// mod file text without comments, lines are separated by '\n'
+    std::string Text;
+    std::vector<FModRecord> Records;
+    size_t NextRecord;
 };
 
 #endif // MODPARSER_H
@@ -0,0 +1,213 @@
+#include "ModPlan.h"
+
+#include <fstream>
+#include <cstring>
+
+/// plan file signature and version, plans of other versions are ignored
+static const char PlanSignature[8] = {'U', 'P', 'K', 'P', 'L', 'A', 'N', 0};
+static const uint32_t PlanVersion = 1;
+
+uint64_t HashData(const char* data, size_t size, uint64_t hash)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= (uint8_t)data[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+uint64_t HashData(const std::string& data)
+{
+    return HashData(data.data(), data.size());
+}
+
+uint64_t HashData(const std::vector<char>& data)
+{
+    return HashData(data.data(), data.size());
+}
+
+bool HashFile(const char* filename, uint64_t& hash)
+{
+    std::ifstream in(filename, std::ios::binary);
+    if (!in)
+        return false;
+    hash = HashData(nullptr, 0);
+    std::vector<char> buf(1024 * 1024);
+    while (in)
+    {
+        in.read(buf.data(), buf.size());
+        hash = HashData(buf.data(), in.gcount(), hash);
+    }
+    return in.eof();
+}
+
+static void WritePlanValue(std::ostream& out, uint32_t val)
+{
+    out.write(reinterpret_cast<char*>(&val), sizeof(val));
+}
+
+static void WritePlanValue(std::ostream& out, uint64_t val)
+{
+    out.write(reinterpret_cast<char*>(&val), sizeof(val));
+}
+
+static void WritePlanValue(std::ostream& out, const std::string& str)
+{
+    WritePlanValue(out, (uint32_t)str.size());
+    out.write(str.data(), str.size());
+}
+
+static bool ReadPlanValue(std::istream& in, uint32_t& val)
+{
+    return (bool)in.read(reinterpret_cast<char*>(&val), sizeof(val));
+}
+
+static bool ReadPlanValue(std::istream& in, uint64_t& val)
+{
+    return (bool)in.read(reinterpret_cast<char*>(&val), sizeof(val));
+}
+
+static bool ReadPlanValue(std::istream& in, std::string& str)
+{
+    uint32_t size = 0;
+    if (!ReadPlanValue(in, size))
+        return false;
+    /// string can not be longer than the rest of the file
+    std::streampos pos = in.tellg();
+    in.seekg(0, std::ios::end);
+    std::streampos end = in.tellg();
+    in.seekg(pos);
+    if (size > end - pos)
+        return false;
+    str.resize(size);
+    return (size == 0 || (bool)in.read(&str[0], size));
+}
+
+bool ModPlan::Read(const char* filename)
+{
+    Clear();
+    std::ifstream in(filename, std::ios::binary);
+    if (!in)
+        return false;
+    char Signature[sizeof(PlanSignature)];
+    uint32_t Version = 0;
+    if (!in.read(Signature, sizeof(Signature)) || memcmp(Signature, PlanSignature, sizeof(Signature)) != 0)
+        return false;
+    if (!ReadPlanValue(in, Version) || Version != PlanVersion)
+        return false;
+    uint32_t count = 0;
+    bool good = ReadPlanValue(in, ModHash) && ReadPlanValue(in, count);
+    for (uint32_t i = 0; good && i < count; ++i)
+    {
+        FPlanPackage Package;
+        good = ReadPlanValue(in, Package.UPKName) && ReadPlanValue(in, Package.GUID) &&
+               ReadPlanValue(in, Package.HeaderHash) && ReadPlanValue(in, Package.FileSize);
+        Packages.push_back(Package);
+    }
+    good = good && ReadPlanValue(in, count);
+    for (uint32_t i = 0; good && i < count; ++i)
+    {
+        FPlanCommand Command;
+        uint32_t numParsed = 0;
+        good = ReadPlanValue(in, Command.Name) && ReadPlanValue(in, Command.Param) && ReadPlanValue(in, numParsed);
+        for (uint32_t j = 0; good && j < numParsed; ++j)
+        {
+            FPlanParsedScript Parsed;
+            good = ReadPlanValue(in, Parsed.SourceHash) && ReadPlanValue(in, Parsed.ParsedHEX) &&
+                   ReadPlanValue(in, Parsed.MemSize);
+            Command.ParsedScripts.push_back(Parsed);
+        }
+        Commands.push_back(Command);
+    }
+    if (!good)
+    {
+        Clear();
+        return false;
+    }
+    return true;
+}
+
+bool ModPlan::Write(const char* filename)
+{
+    std::ofstream out(filename, std::ios::binary);
+    if (!out)
+        return false;
+    out.write(PlanSignature, sizeof(PlanSignature));
+    WritePlanValue(out, PlanVersion);
+    WritePlanValue(out, ModHash);
+    WritePlanValue(out, (uint32_t)Packages.size());
+    for (unsigned i = 0; i < Packages.size(); ++i)
+    {
+        WritePlanValue(out, Packages[i].UPKName);
+        WritePlanValue(out, Packages[i].GUID);
+        WritePlanValue(out, Packages[i].HeaderHash);
+        WritePlanValue(out, Packages[i].FileSize);
+    }
+    WritePlanValue(out, (uint32_t)Commands.size());
+    for (unsigned i = 0; i < Commands.size(); ++i)
+    {
+        WritePlanValue(out, Commands[i].Name);
+        WritePlanValue(out, Commands[i].Param);
+        WritePlanValue(out, (uint32_t)Commands[i].ParsedScripts.size());
+        for (unsigned j = 0; j < Commands[i].ParsedScripts.size(); ++j)
+        {
+            WritePlanValue(out, Commands[i].ParsedScripts[j].SourceHash);
+            WritePlanValue(out, Commands[i].ParsedScripts[j].ParsedHEX);
+            WritePlanValue(out, Commands[i].ParsedScripts[j].MemSize);
+        }
+    }
+    return out.good();
+}
+
+const FPlanPackage* ModPlan::FindPackage(const std::string& UPKName)
+{
+    for (unsigned i = 0; i < Packages.size(); ++i)
+    {
+        if (Packages[i].UPKName == UPKName)
+            return &Packages[i];
+    }
+    return nullptr;
+}
+
+void ModPlan::SetPackage(const FPlanPackage& Package)
+{
+    for (unsigned i = 0; i < Packages.size(); ++i)
+    {
+        if (Packages[i].UPKName == Package.UPKName)
+        {
+            Packages[i] = Package;
+            return;
+        }
+    }
+    Packages.push_back(Package);
+}
+
+const FPlanParsedScript* ModPlan::FindParsedScript(unsigned CommandIdx, uint64_t SourceHash)
+{
+    if (CommandIdx >= Commands.size())
+        return nullptr;
+    std::vector<FPlanParsedScript>& ParsedScripts = Commands[CommandIdx].ParsedScripts;
+    for (unsigned i = 0; i < ParsedScripts.size(); ++i)
+    {
+        if (ParsedScripts[i].SourceHash == SourceHash)
+            return &ParsedScripts[i];
+    }
+    return nullptr;
+}
+
+void ModPlan::SetParsedScript(unsigned CommandIdx, const FPlanParsedScript& Parsed)
+{
+    if (CommandIdx >= Commands.size())
+        return;
+    std::vector<FPlanParsedScript>& ParsedScripts = Commands[CommandIdx].ParsedScripts;
+    for (unsigned i = 0; i < ParsedScripts.size(); ++i)
+    {
+        if (ParsedScripts[i].SourceHash == Parsed.SourceHash)
+        {
+            ParsedScripts[i] = Parsed;
+            return;
+        }
+    }
+    ParsedScripts.push_back(Parsed);
+}
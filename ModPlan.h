@@ -0,0 +1,63 @@
+#ifndef MODPLAN_H
+#define MODPLAN_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/// FNV-1a 64 bit hash
+uint64_t HashData(const char* data, size_t size, uint64_t hash = 0xCBF29CE484222325ULL);
+uint64_t HashData(const std::string& data);
+uint64_t HashData(const std::vector<char>& data);
+bool HashFile(const char* filename, uint64_t& hash);
+
+/// package state at the first opening by a mod script
+struct FPlanPackage
+{
+    std::string UPKName;
+    std::string GUID;
+    uint64_t HeaderHash;
+    uint64_t FileSize;
+};
+
+/// pseudo-code compiled to hex
+struct FPlanParsedScript
+{
+    uint64_t SourceHash;
+    std::string ParsedHEX;
+    uint32_t MemSize;
+};
+
+struct FPlanCommand
+{
+    std::string Name;
+    std::string Param;
+    std::vector<FPlanParsedScript> ParsedScripts;
+};
+
+/// precompiled mod script: parsed commands and compiled pseudo-code
+/// compiled code is valid only for the same mod file and the same packages
+class ModPlan
+{
+public:
+    ModPlan(): ModHash(0) {}
+    ~ModPlan() {}
+    void Clear() { ModHash = 0; Packages.clear(); Commands.clear(); }
+    bool Read(const char* filename);
+    bool Write(const char* filename);
+    /// getters/setters
+    uint64_t GetModHash() { return ModHash; }
+    void SetModHash(uint64_t hash) { ModHash = hash; }
+    const FPlanPackage* FindPackage(const std::string& UPKName);
+    void SetPackage(const FPlanPackage& Package);
+    std::vector<FPlanCommand>& GetCommands() { return Commands; }
+    const FPlanParsedScript* FindParsedScript(unsigned CommandIdx, uint64_t SourceHash);
+    void SetParsedScript(unsigned CommandIdx, const FPlanParsedScript& Parsed);
+private:
+    uint64_t ModHash;
+    std::vector<FPlanPackage> Packages;
+    std::vector<FPlanCommand> Commands;
+};
+
+#endif // MODPLAN_H
@@ -3,8 +3,11 @@
 #include <cstring>
 #include <cctype>
 #include <algorithm>
+#include <iterator>
 #include <stack>
 
+#include "ParallelFor.h"
+
 void ModScript::SetExecutors()
 {
     Executors.clear();
@@ -198,16 +201,15 @@ void ModScript::InitStreams(std::ostream& err, std::ostream& res)
 
 bool ModScript::Parse(const char* filename)
 {
-    BackupScript.clear();
-    UPKNames.clear();
-    GUIDs.clear();
+    ResetModState(filename);
+    /// parser needs all the keys and comment markers before opening mod file
+    SetExecutors();
+    Parser.SetCommentMarkers('{', '}', 0);
     if (Parser.OpenModFile(filename) == false)
     {
         *ErrorMessages << "Can't open " << filename << " (file does not exist, or bad, or not ASCII)!" << std::endl;
         return SetBad();
     }
-    SetExecutors();
-    Parser.SetCommentMarkers('{', '}', 0);
     /// begin parsing mod file
     ExecutionStack.clear();
     ResetScriptFlags();
@@ -226,6 +228,228 @@ bool ModScript::Parse(const char* filename)
     return SetGood();
 }
 
+bool ModScript::ParsePlan(const char* filename, const char* planname)
+{
+    ResetPlanState();
+    uint64_t ModHash = 0;
+    if (HashFile(filename, ModHash) == false)
+    {
+        *ErrorMessages << "Can't open " << filename << " (file does not exist, or bad, or not ASCII)!" << std::endl;
+        return SetBad();
+    }
+    PlanState.Enabled = true;
+    PlanState.FileName = planname;
+    if (Plan.Read(planname) && Plan.GetModHash() == ModHash && Plan.GetCommands().size() > 0)
+    {
+        ResetModState(filename);
+        SetExecutors();
+        ExecutionStack.clear();
+        ResetScriptFlags();
+        ResetScope();
+        std::vector<FPlanCommand>& Commands = Plan.GetCommands();
+        for (unsigned i = 0; i < Commands.size(); ++i)
+        {
+            if (Executors.count(Commands[i].Name) == 0)
+                break;
+            ExecutionStack.push_back({Commands[i].Name, Commands[i].Param, Executors[Commands[i].Name]});
+        }
+        if (ExecutionStack.size() == Commands.size())
+        {
+            PlanState.Valid = true;
+            *ExecutionResults << "Using precompiled plan: " << planname << std::endl;
+            return SetGood();
+        }
+    }
+    /// no plan or plan is outdated: parse mod file and compile new plan
+    *ExecutionResults << "Compiling plan: " << planname << std::endl;
+    if (Parse(filename) == false)
+    {
+        ResetPlanState();
+        return SetBad();
+    }
+    Plan.Clear();
+    Plan.SetModHash(ModHash);
+    for (unsigned i = 0; i < ExecutionStack.size(); ++i)
+    {
+        Plan.GetCommands().push_back({ExecutionStack[i].Name, ExecutionStack[i].Param, std::vector<FPlanParsedScript>()});
+    }
+    return SetGood();
+}
+
+bool ModScript::SavePlan()
+{
+    if (PlanState.Enabled == false || PlanState.Valid == true)
+        return true;
+    if (Plan.Write(PlanState.FileName.c_str()) == false)
+    {
+        *ErrorMessages << "Error saving plan: " << PlanState.FileName << std::endl;
+        return false;
+    }
+    *ExecutionResults << "Plan saved to " << PlanState.FileName << std::endl;
+    return true;
+}
+
+void ModScript::CheckPlanPackage()
+{
+    FPlanPackage Package;
+    Package.UPKName = ScriptState.UPKName;
+    Package.GUID = FormatHEX(ScriptState.Package->GetGUID());
+    Package.HeaderHash = HashData(ScriptState.Package->SerializeHeader());
+    Package.FileSize = ScriptState.Package->GetFileSize();
+    if (PlanState.Valid)
+    {
+        const FPlanPackage* Planned = Plan.FindPackage(Package.UPKName);
+        if (Planned != nullptr && Planned->GUID == Package.GUID &&
+            Planned->HeaderHash == Package.HeaderHash && Planned->FileSize == Package.FileSize)
+        {
+            return;
+        }
+        /// code parsed for other package state can't be used: re-compile the rest of the plan
+        *ExecutionResults << "Package " << Package.UPKName << " was changed, re-compiling plan ...\n";
+        PlanState.Valid = false;
+        Plan.GetCommands()[PlanState.CommandIdx].ParsedScripts.clear();
+    }
+    Plan.SetPackage(Package);
+}
+
+void ModScript::ResetBatch(bool batchMode)
+{
+    BatchMode = batchMode;
+    Packages.clear();
+    Packages[""].reset(new UPKUtils());
+    ScriptState.Package = Packages[""].get();
+    ScriptState.UPKName = "";
+    WriteExtents.clear();
+    ModNames.clear();
+    NumConflicts = 0;
+}
+
+void ModScript::ResetModState(const char* filename)
+{
+    BackupScript.clear();
+    ResetJournal();
+    UPKNames.clear();
+    GUIDs.clear();
+    /// each mod has to open its packages
+    if (BatchMode)
+    {
+        Alias.clear();
+        ScriptState.Package = Packages[""].get();
+        ScriptState.UPKName = "";
+        ModNames.push_back(filename);
+    }
+    else if (Transactions)
+    {
+        ResetBatch(false);
+    }
+    else
+    {
+        /// package is re-read to record its changes to the new journal
+        ScriptState.UPKName = "";
+    }
+}
+
+void ModScript::ResetJournal()
+{
+    /// packages kept open by batch mode record changes of the next mod to its own journal
+    std::map<std::string, std::unique_ptr<UPKUtils>>::iterator it;
+    for (it = Packages.begin(); it != Packages.end(); ++it)
+    {
+        it->second->SetUndoRecords(nullptr);
+    }
+    Journal.Clear();
+}
+
+bool ModScript::IsUninstallPartial()
+{
+    for (unsigned i = 0; i < ExecutionStack.size(); ++i)
+    {
+        if (ExecutionStack[i].Exec == &ModScript::SetUninstallAllowed &&
+            GetStringValue(ExecutionStack[i].Param) == "FALSE")
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ModScript::HasUndoJournal()
+{
+    return (IsUninstallPartial() == false && Journal.IsEmpty() == false);
+}
+
+bool ModScript::SaveUndoJournal(const char* filename)
+{
+    if (Journal.Write(filename) == false)
+    {
+        *ErrorMessages << "Error saving undo journal: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ModScript::ExecuteUndo(const char* filename)
+{
+    UndoJournal Undo;
+    if (Undo.Read(filename) == false)
+    {
+        *ErrorMessages << "Error reading undo journal: " << filename << std::endl;
+        return SetBad();
+    }
+    /// all the packages are checked before any of them is changed
+    std::vector<std::unique_ptr<UPKUtils>> UndoPackages;
+    std::map<std::string, FUndoPackage>::iterator it;
+    for (it = Undo.GetPackages().begin(); it != Undo.GetPackages().end(); ++it)
+    {
+        std::string pathName = UPKPath + "/" + it->first;
+        UndoPackages.emplace_back(new UPKUtils());
+        UPKUtils* Package = UndoPackages.back().get();
+        if (Package->Read(pathName.c_str()) == false || Package->IsCompressedMode())
+        {
+            *ErrorMessages << "Error reading package: " << pathName << std::endl;
+            return SetBad();
+        }
+        if (FormatHEX(Package->GetGUID()) != it->second.GUID)
+        {
+            *ErrorMessages << "Package GUID " << FormatHEX(Package->GetGUID()) << " does not match journal GUID "
+                           << it->second.GUID << " for package " << it->first << std::endl;
+            return SetBad();
+        }
+        if (Package->GetFileSize() != GetChangedFileSize(it->second) || Package->CheckUndoChanges(it->second.Records) == false)
+        {
+            *ErrorMessages << "Package " << it->first << " was changed after the mod was installed!\n";
+            return SetBad();
+        }
+    }
+    unsigned i = 0;
+    for (it = Undo.GetPackages().begin(); it != Undo.GetPackages().end(); ++it, ++i)
+    {
+        *ExecutionResults << "Restoring package " << it->first << " (" << it->second.Records.size() << " changes) ...\n";
+        if (UndoPackages[i]->UndoChanges(it->second.Records) == false)
+        {
+            *ErrorMessages << "Error restoring package: " << it->first << std::endl;
+            return SetBad();
+        }
+        *ExecutionResults << "Package restored successfully!\n";
+    }
+    return SetGood();
+}
+
+bool ModScript::FlushPackages()
+{
+    bool ret = true;
+    std::map<std::string, std::unique_ptr<UPKUtils>>::iterator it;
+    for (it = Packages.begin(); it != Packages.end(); ++it)
+    {
+        if (it->second->FlushWrites() == false)
+        {
+            *ErrorMessages << "Error writing package: " << it->first << std::endl;
+            ret = false;
+        }
+    }
+    return ret;
+}
+
 bool ModScript::ExecuteStack()
 {
     if (IsGood() == false)
@@ -238,19 +462,267 @@ bool ModScript::ExecuteStack()
         *ErrorMessages << "Execution stack is empty!\n";
         return SetBad();
     }
-    for (unsigned i = 0; i < ExecutionStack.size(); ++i)
+    ScriptFlags.IsTextBackup = (TextBackup || IsUninstallPartial());
+    /// packages opened by previous mods and plan data are shared between all the commands
+    bool result = false;
+    if (NumThreads > 1 && BatchMode == false && PlanState.Enabled == false)
+    {
+        result = ExecuteSegments();
+    }
+    else
     {
-        bool result = (this->*ExecutionStack[i].Exec)(ExecutionStack[i].Param);
+        result = ExecuteCommands(0, ExecutionStack.size());
+    }
+    if (EndTransactions(result) == false)
+    {
+        return SetBad();
+    }
+    return SetGood();
+}
+
+bool ModScript::EndTransactions(bool commit)
+{
+    bool ret = commit;
+    std::map<std::string, std::unique_ptr<UPKUtils>>::iterator it;
+    /// journal records get hashes of the data the mod left
+    for (it = Packages.begin(); it != Packages.end(); ++it)
+    {
+        it->second->SetUndoRecords(nullptr);
+    }
+    /// batch mode has no transactions: changes of the failed mod are undone,
+    /// changes of the previous mods are kept
+    if (commit == false && BatchMode)
+    {
+        /// packages, which could not be restored, keep their undo journal
+        std::map<std::string, FUndoPackage>::iterator jt = Journal.GetPackages().begin();
+        while (jt != Journal.GetPackages().end())
+        {
+            it = Packages.find(UPKPath + "/" + jt->first);
+            if (it != Packages.end() && jt->second.Records.size() > 0 &&
+                it->second->UndoChanges(jt->second.Records) == false)
+            {
+                *ErrorMessages << "Error discarding changes of package: " << it->first << std::endl;
+                ++jt;
+                continue;
+            }
+            if (it != Packages.end())
+                *ExecutionResults << "Changes discarded, package is not modified by this mod: " << it->first << std::endl;
+            BackupScript.erase(jt->first);
+            jt = Journal.GetPackages().erase(jt);
+        }
+        return ret;
+    }
+    for (it = Packages.begin(); it != Packages.end(); ++it)
+    {
+        if (it->second->IsTransactionActive() == false)
+            continue;
+        if (commit == false)
+        {
+            it->second->RollbackTransaction();
+            *ExecutionResults << "Changes discarded, package is not modified: " << it->first << std::endl;
+            /// nothing to uninstall for rolled back package, changes of other packages are kept
+            it->second->SetUndoRecords(nullptr);
+            std::string UPKName = it->first.substr(UPKPath.size() + 1);
+            BackupScript.erase(UPKName);
+            Journal.GetPackages().erase(UPKName);
+        }
+        else if (it->second->CommitTransaction() == false)
+        {
+            *ErrorMessages << "Error writing package: " << it->first << std::endl;
+            ret = false;
+        }
+    }
+    return ret;
+}
+
+bool ModScript::ExecuteCommands(unsigned first, unsigned last, const std::vector<unsigned>* Segments, unsigned Segment)
+{
+    for (unsigned i = first; i < last; ++i)
+    {
+        bool result = true;
+        /// search results are shared by consecutive REPLACE_HEX/REPLACE_CODE commands only
+        ExecIdx = i;
+        if ((Segments != nullptr && (*Segments)[i] != Segment) ||
+            (ExecutionStack[i].Exec != &ModScript::WriteReplaceAllHEX && ExecutionStack[i].Exec != &ModScript::WriteReplaceAllCode))
+        {
+            ResetFindCache();
+        }
+        if (Segments != nullptr && (*Segments)[i] != Segment)
+        {
+            if (ExecutionStack[i].Exec == &ModScript::OpenPackage)
+            {
+                /// other package is opened: current package will be re-read on the next opening
+                result = CommitHeaderAdditions();
+                ScriptState.UPKName = "";
+            }
+            else if (IsStateCommand(ExecutionStack[i].Exec))
+            {
+                /// state is changed for all the segments, but reported by the segment's owner only
+                std::ostream* err = ErrorMessages;
+                std::ostream* res = ExecutionResults;
+                std::ostringstream discard;
+                InitStreams(discard, discard);
+                bool ret = (this->*ExecutionStack[i].Exec)(ExecutionStack[i].Param);
+                InitStreams(*err, *res);
+                if (ret == false)
+                    return SetBad();
+            }
+        }
+        else
+        {
+            if (PlanState.Enabled)
+            {
+                PlanState.CommandIdx = i;
+                if (PlanState.Valid == false)
+                    Plan.GetCommands()[i].ParsedScripts.clear();
+            }
+            /// consecutive header additions are written to package at once
+            result = (IsHeaderAddition(ExecutionStack[i].Exec) || CommitHeaderAdditions());
+            if (result == true)
+            {
+                result = (this->*ExecutionStack[i].Exec)(ExecutionStack[i].Param);
+            }
+        }
         if (result == false)
         {
             *ErrorMessages << "Execution stopped at #" << i << " command named "
                            << ExecutionStack[i].Name << ".\n";
+            /// header additions of the failed batch are not written
+            if (ScriptState.Package != nullptr && ScriptState.Package->IsHeaderBatchActive())
+                ScriptState.Package->DiscardHeaderBatch();
             return SetBad();
         }
     }
+    if (CommitHeaderAdditions() == false)
+    {
+        *ErrorMessages << "Execution stopped at the end of script.\n";
+        return SetBad();
+    }
     return SetGood();
 }
 
+bool ModScript::IsStateCommand(ExecFunction Exec)
+{
+    return (Exec == &ModScript::SetUpdateRelOffset ||
+            Exec == &ModScript::SetUninstallAllowed ||
+            Exec == &ModScript::SetGUID);
+}
+
+bool ModScript::ExecuteSegments()
+{
+    /// segment is a package: all the commands after UPK_FILE key until the next one
+    /// commands before the first UPK_FILE key are executed first
+    std::vector<std::string> SegmentNames;
+    std::vector<unsigned> Segments(ExecutionStack.size(), 0);
+    unsigned first = ExecutionStack.size();
+    bool sharedAliases = false;
+    bool hasAliases = false;
+    for (unsigned i = 0; i < ExecutionStack.size(); ++i)
+    {
+        if (ExecutionStack[i].Exec == &ModScript::OpenPackage)
+        {
+            std::string UPKFileName = GetStringValue(ExecutionStack[i].Param);
+            std::transform(UPKFileName.begin(), UPKFileName.end(), UPKFileName.begin(), ::tolower);
+            std::vector<std::string>::iterator it = std::find(SegmentNames.begin(), SegmentNames.end(), UPKFileName);
+            if (it == SegmentNames.end())
+                it = SegmentNames.insert(SegmentNames.end(), UPKFileName);
+            Segments[i] = it - SegmentNames.begin();
+            first = std::min(first, i);
+        }
+        else if (i > 0)
+        {
+            Segments[i] = Segments[i - 1];
+        }
+        /// aliases are visible to all the packages opened after them
+        if (hasAliases && ExecutionStack[i].Exec == &ModScript::OpenPackage && Segments[i] != Segments[i - 1])
+            sharedAliases = true;
+        hasAliases = hasAliases || (ExecutionStack[i].Exec == &ModScript::AddAlias);
+    }
+    if (SegmentNames.size() < 2 || sharedAliases)
+    {
+        return ExecuteCommands(0, ExecutionStack.size());
+    }
+    if (ExecuteCommands(0, first) == false)
+    {
+        return SetBad();
+    }
+    /// each segment is executed by its own script with its own package
+    std::vector<std::unique_ptr<ModScript>> Workers(SegmentNames.size());
+    std::vector<std::ostringstream> Errors(SegmentNames.size());
+    std::vector<std::ostringstream> Results(SegmentNames.size());
+    ParallelFor(SegmentNames.size(), NumThreads, [&](size_t s)
+    {
+        Workers[s].reset(new ModScript());
+        ModScript& Worker = *Workers[s];
+        Worker.InitStreams(Errors[s], Results[s]);
+        Worker.UPKPath = UPKPath;
+        Worker.ExecutionStack = ExecutionStack;
+        Worker.ScriptFlags = ScriptFlags;
+        Worker.GUIDs = GUIDs;
+        Worker.Transactions = Transactions;
+        Worker.ResetScope();
+        Worker.SetGood();
+        Worker.ExecuteCommands(first, ExecutionStack.size(), &Segments, s);
+    });
+    /// packages are changed only if all the segments succeeded
+    bool result = true;
+    for (unsigned s = 0; s < Workers.size(); ++s)
+    {
+        result = result && Workers[s]->IsGood();
+    }
+    /// results are merged in order of the first package opening
+    bool committed = true;
+    for (unsigned s = 0; s < Workers.size(); ++s)
+    {
+        committed = Workers[s]->EndTransactions(result) && committed;
+        *ExecutionResults << Results[s].str();
+        *ErrorMessages << Errors[s].str();
+        for (unsigned i = 0; i < Workers[s]->UPKNames.size(); ++i)
+        {
+            const std::string& UPKName = Workers[s]->UPKNames[i];
+            AddUPKName(UPKName);
+            BackupScript[UPKName] = Workers[s]->BackupScript[UPKName];
+            Journal.AddPackage(UPKName) = std::move(Workers[s]->Journal.AddPackage(UPKName));
+        }
+    }
+    return (result && committed ? SetGood() : SetBad());
+}
+
+bool ModScript::IsHeaderAddition(ExecFunction Exec)
+{
+    /// end-of-section markers between additions do not break the batch
+    return (Exec == &ModScript::WriteAddNameEntry ||
+            Exec == &ModScript::WriteAddImportEntry ||
+            Exec == &ModScript::WriteAddExportEntry ||
+            Exec == &ModScript::Sink);
+}
+
+bool ModScript::BeginHeaderAdditions()
+{
+    if (ScriptState.Package->IsHeaderBatchActive())
+        return true;
+    if (ScriptState.Package->BeginHeaderBatch() == false)
+    {
+        *ErrorMessages << "Error starting header update!\n";
+        return false;
+    }
+    return true;
+}
+
+bool ModScript::CommitHeaderAdditions()
+{
+    if (ScriptState.Package->IsHeaderBatchActive() == false)
+        return true;
+    *ExecutionResults << "Writing new header entries ...\n";
+    if (ScriptState.Package->CommitHeaderBatch() == false)
+    {
+        *ErrorMessages << "Error writing new header entries!\n";
+        return false;
+    }
+    *ExecutionResults << "Header updated successfully!\n";
+    return true;
+}
+
 /********************************************************************
 ************************** patcher keys *****************************
 *********************************************************************/
@@ -348,15 +820,48 @@ bool ModScript::OpenPackage(const std::string& Param)
     }
     ScriptState.UPKName = UPKFileName;
     std::string pathName = UPKPath + "/" + UPKFileName;
-    if (ScriptState.Package.Read(pathName.c_str()) == false)
+    bool isLoaded = false;
+    /// packages are kept open until the end of batch or transaction
+    if (BatchMode || Transactions)
+    {
+        std::unique_ptr<UPKUtils>& Package = Packages[pathName];
+        if (Package == nullptr)
+            Package.reset(new UPKUtils());
+        isLoaded = Package->IsLoaded();
+        ScriptState.Package = Package.get();
+    }
+    if (isLoaded)
+    {
+        if (BatchMode)
+            *ExecutionResults << "Package is already loaded by previous mod.\n";
+    }
+    else if (ScriptState.Package->Read(pathName.c_str()) == false)
     {
         *ErrorMessages << "Error reading package: " << pathName << std::endl;
-        UPKReadErrors err = ScriptState.Package.GetError();
+        UPKReadErrors err = ScriptState.Package->GetError();
         *ErrorMessages << FormatReadErrors(err);
-        if (ScriptState.Package.IsCompressed())
-            *ErrorMessages << "Compression flags:\n" << FormatCompressionFlags(ScriptState.Package.GetCompressionFlags());
+        if (ScriptState.Package->IsCompressed())
+            *ErrorMessages << "Compression flags:\n" << FormatCompressionFlags(ScriptState.Package->GetCompressionFlags());
         return SetBad();
     }
+    if (ScriptState.Package->IsCompressedMode())
+    {
+        *ErrorMessages << "Can't patch compressed package: " << pathName << std::endl;
+        *ErrorMessages << "Compression flags:\n" << FormatCompressionFlags(ScriptState.Package->GetCompressionFlags());
+        *ErrorMessages << "Decompress it with DecompressLZO first.\n";
+        return SetBad();
+    }
+    if (BatchMode)
+    {
+        ScriptState.Package->SetWriteBuffering(true);
+    }
+    else if (Transactions && ScriptState.Package->IsTransactionActive() == false &&
+             ScriptState.Package->BeginTransaction() == false)
+    {
+        *ErrorMessages << "Error starting transaction: " << pathName << std::endl;
+        return SetBad();
+    }
+    bool isFirstOpen = (std::find(UPKNames.begin(), UPKNames.end(), ScriptState.UPKName) == UPKNames.end());
     AddUPKName(ScriptState.UPKName);
     ResetScope();
     *ExecutionResults << "Package file: " << pathName;
@@ -364,7 +869,7 @@ bool ModScript::OpenPackage(const std::string& Param)
     if (GUIDs.count(UPKFileName) > 0)
     {
         bool found = false;
-        std::string GUID = FormatHEX(ScriptState.Package.GetGUID());
+        std::string GUID = FormatHEX(ScriptState.Package->GetGUID());
         std::multimap<std::string, std::string>::iterator it;
         for (it = GUIDs.equal_range(UPKFileName).first; it != GUIDs.equal_range(UPKFileName).second; ++it)
         {
@@ -384,6 +889,19 @@ bool ModScript::OpenPackage(const std::string& Param)
     {
         BackupScript.insert({ScriptState.UPKName, std::string("")});
     }
+    /// changes are recorded to undo journal as they are made
+    FUndoPackage& Undo = Journal.AddPackage(ScriptState.UPKName);
+    if (Undo.Records.empty())
+    {
+        Undo.GUID = FormatHEX(ScriptState.Package->GetGUID());
+        Undo.FileSize = ScriptState.Package->GetFileSize();
+    }
+    ScriptState.Package->SetUndoRecords(&Undo.Records);
+    /// plan is compiled for package state at the first opening
+    if (PlanState.Enabled && isFirstOpen)
+    {
+        CheckPlanPackage();
+    }
     *ExecutionResults << "Package opened successfully!\n";
     return SetGood();
 }
@@ -411,7 +929,7 @@ bool ModScript::SetGUID(const std::string& Param)
 
 bool ModScript::SetGlobalOffset(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -419,10 +937,10 @@ bool ModScript::SetGlobalOffset(const std::string& Param)
     ResetScope();
     ScriptState.Scope = UPKScope::Package;
     ScriptState.Offset = GetUnsignedValue(Param);
-    ScriptState.MaxOffset = ScriptState.Package.GetFileSize() - 1;
+    ScriptState.MaxOffset = ScriptState.Package->GetFileSize() - 1;
     *ExecutionResults << "Global offset: " << FormatHEX((uint32_t)ScriptState.Offset)
                       << " (" << ScriptState.Offset << ")" << std::endl;
-    if (ScriptState.Package.CheckValidFileOffset(ScriptState.Offset) == false)
+    if (ScriptState.Package->CheckValidFileOffset(ScriptState.Offset) == false)
     {
         *ErrorMessages << "Invalid package offset!\n";
         return SetBad();
@@ -458,7 +976,7 @@ bool ModScript::CheckBehavior()
 
 bool ModScript::SetObject(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -473,7 +991,7 @@ bool ModScript::SetObject(const std::string& Param)
         return SetBad();
     }
     *ExecutionResults << "Searching for object named " << ObjName << " ...\n";
-    UObjectReference ObjRef = ScriptState.Package.FindObject(ObjName);
+    UObjectReference ObjRef = ScriptState.Package->FindObject(ObjName);
     if (ObjRef == 0)
     {
         *ErrorMessages << "Can't find object named " << ObjName << std::endl;
@@ -486,9 +1004,9 @@ bool ModScript::SetObject(const std::string& Param)
     }
     *ExecutionResults << "Object found!\n";
     ScriptState.ObjIdx = (uint32_t)ObjRef;
-    ScriptState.Offset = ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).SerialOffset;
+    ScriptState.Offset = ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).SerialOffset;
     ScriptState.RelOffset = 0;
-    ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).SerialSize - 1;
+    ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).SerialSize - 1;
     /*
     *ExecutionResults << "Scope: " << FormatUPKScope(ScriptState.Scope)
                       << "\nObject: " << ObjName
@@ -502,7 +1020,7 @@ bool ModScript::SetObject(const std::string& Param)
 
 bool ModScript::SetNameEntry(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -511,7 +1029,7 @@ bool ModScript::SetNameEntry(const std::string& Param)
     ScriptState.Scope = UPKScope::Name;
     std::string ObjName = GetStringValue(Param);
     *ExecutionResults << "Searching for name " << ObjName << " ...\n";
-    int idx = ScriptState.Package.FindName(ObjName);
+    int idx = ScriptState.Package->FindName(ObjName);
     if (idx < 0)
     {
         *ErrorMessages << "Can't find NameTable name " << ObjName << std::endl;
@@ -519,9 +1037,9 @@ bool ModScript::SetNameEntry(const std::string& Param)
     }
     *ExecutionResults << "Name found!\n";
     ScriptState.ObjIdx = idx;
-    ScriptState.Offset = ScriptState.Package.GetNameEntry(ScriptState.ObjIdx).EntryOffset;
+    ScriptState.Offset = ScriptState.Package->GetNameEntry(ScriptState.ObjIdx).EntryOffset;
     ScriptState.RelOffset = 0;
-    ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package.GetNameEntry(ScriptState.ObjIdx).EntrySize - 1;
+    ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package->GetNameEntry(ScriptState.ObjIdx).EntrySize - 1;
     /*
     *ExecutionResults << "Scope: " << FormatUPKScope(ScriptState.Scope)
                       << "\nName entry: " << ObjName
@@ -534,7 +1052,7 @@ bool ModScript::SetNameEntry(const std::string& Param)
 
 bool ModScript::SetImportEntry(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -543,7 +1061,7 @@ bool ModScript::SetImportEntry(const std::string& Param)
     ScriptState.Scope = UPKScope::Import;
     std::string ObjName = GetStringValue(Param);
     *ExecutionResults << "Searching for import table entry " << ObjName << " ...\n";
-    UObjectReference ObjRef = ScriptState.Package.FindObject(ObjName, false);
+    UObjectReference ObjRef = ScriptState.Package->FindObject(ObjName, false);
     if (ObjRef == 0)
     {
         *ErrorMessages << "Can't find ImportTable entry named " << ObjName << std::endl;
@@ -556,9 +1074,9 @@ bool ModScript::SetImportEntry(const std::string& Param)
     }
     *ExecutionResults << "Import table entry found!\n";
     ScriptState.ObjIdx = (uint32_t)(-ObjRef);
-    ScriptState.Offset = ScriptState.Package.GetImportEntry(ScriptState.ObjIdx).EntryOffset;
+    ScriptState.Offset = ScriptState.Package->GetImportEntry(ScriptState.ObjIdx).EntryOffset;
     ScriptState.RelOffset = 0;
-    ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package.GetImportEntry(ScriptState.ObjIdx).EntrySize - 1;
+    ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package->GetImportEntry(ScriptState.ObjIdx).EntrySize - 1;
     /*
     *ExecutionResults << "Scope: " << FormatUPKScope(ScriptState.Scope)
                       << "\nImport entry: " << ObjName
@@ -571,7 +1089,7 @@ bool ModScript::SetImportEntry(const std::string& Param)
 
 bool ModScript::SetExportEntry(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -580,7 +1098,7 @@ bool ModScript::SetExportEntry(const std::string& Param)
     ScriptState.Scope = UPKScope::Export;
     std::string ObjName = GetStringValue(Param);
     *ExecutionResults << "Searching for export table entry " << ObjName << " ...\n";
-    UObjectReference ObjRef = ScriptState.Package.FindObject(ObjName);
+    UObjectReference ObjRef = ScriptState.Package->FindObject(ObjName);
     if (ObjRef == 0)
     {
         *ErrorMessages << "Can't find ExportTable entry named " << ObjName << std::endl;
@@ -588,9 +1106,9 @@ bool ModScript::SetExportEntry(const std::string& Param)
     }
     *ExecutionResults << "Export table entry found!\n";
     ScriptState.ObjIdx = (uint32_t)ObjRef;
-    ScriptState.Offset = ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).EntryOffset;
+    ScriptState.Offset = ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).EntryOffset;
     ScriptState.RelOffset = 0;
-    ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).EntrySize - 1;
+    ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).EntrySize - 1;
     /*
     *ExecutionResults << "Scope: " << FormatUPKScope(ScriptState.Scope)
                       << "\nExport entry: " << ObjName
@@ -603,7 +1121,7 @@ bool ModScript::SetExportEntry(const std::string& Param)
 
 bool ModScript::SetRelOffset(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -628,19 +1146,19 @@ void ModScript::ResetMaxOffset()
     switch (ScriptState.Scope)
     {
         case UPKScope::Object:
-            ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).SerialSize - 1;
+            ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).SerialSize - 1;
             return;
         case UPKScope::Name:
-            ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package.GetNameEntry(ScriptState.ObjIdx).EntrySize - 1;
+            ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package->GetNameEntry(ScriptState.ObjIdx).EntrySize - 1;
             return;
         case UPKScope::Import:
-            ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package.GetImportEntry(ScriptState.ObjIdx).EntrySize - 1;
+            ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package->GetImportEntry(ScriptState.ObjIdx).EntrySize - 1;
             return;
         case UPKScope::Export:
-            ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).EntrySize - 1;
+            ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).EntrySize - 1;
             return;
         default:
-            ScriptState.MaxOffset = ScriptState.Package.GetFileSize() - 1;
+            ScriptState.MaxOffset = ScriptState.Package->GetFileSize() - 1;
             return;
     }
 }
@@ -664,7 +1182,7 @@ bool ModScript::CheckMoveResize(size_t DataSize, bool FitScope)
     if (ScriptState.Scope == UPKScope::Object)
     {
         bool NeedMoveResize = false;
-        size_t ObjSize = ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).SerialSize;
+        size_t ObjSize = ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).SerialSize;
         if (FitScope && ScopeSize != DataSize)
         {
             if (ScriptState.Behavior != "KEEP")
@@ -725,19 +1243,20 @@ bool ModScript::DoResize(int ObjSize)
 bool ModScript::MoveResizeAtRelOffset(int ObjSize)
 {
     *ExecutionResults << "Moving/resizing object.\nNew object size: " << ObjSize << std::endl;
-    if (ScriptState.Package.MoveResizeObject(ScriptState.ObjIdx, ObjSize, ScriptState.RelOffset) == false)
+    if (ScriptState.Package->MoveResizeObject(ScriptState.ObjIdx, ObjSize, ScriptState.RelOffset) == false)
     {
         *ErrorMessages << "Error moving/resizing object!\n";
         return SetBad();
     }
+    AddObjectExtent();
     *ExecutionResults << "Object moved/resized successfully.\n";
-    ScriptState.Offset = ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).SerialOffset;
-    ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).SerialSize - 1;
+    ScriptState.Offset = ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).SerialOffset;
+    ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).SerialSize - 1;
     /// backup info
-    if (ScriptFlags.IsUninstallAllowed)
+    if (ScriptFlags.IsUninstallAllowed && ScriptFlags.IsTextBackup)
     {
         std::ostringstream ss;
-        ss << "EXPAND_UNDO=" << ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).FullName << "\n\n";
+        ss << "EXPAND_UNDO=" << ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).FullName << "\n\n";
         ss << BackupScript[ScriptState.UPKName];
         BackupScript[ScriptState.UPKName] = ss.str();
     }
@@ -746,22 +1265,23 @@ bool ModScript::MoveResizeAtRelOffset(int ObjSize)
 
 bool ModScript::ResizeInPlace(int ObjSize)
 {
-    size_t oldSize = ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).SerialSize;
-    std::vector<char> oldData = ScriptState.Package.GetExportData(ScriptState.ObjIdx);
+    size_t oldSize = ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).SerialSize;
+    std::vector<char> oldData = ScriptState.Package->GetExportData(ScriptState.ObjIdx);
     *ExecutionResults << "Resizing object in place.\nNew object size: " << ObjSize << std::endl;
-    if (ScriptState.Package.ResizeInPlace(ScriptState.ObjIdx, ObjSize, ScriptState.RelOffset) == false)
+    if (ScriptState.Package->ResizeInPlace(ScriptState.ObjIdx, ObjSize, ScriptState.RelOffset) == false)
     {
         *ErrorMessages << "Error resizing object in place!\n";
         return SetBad();
     }
+    AddObjectExtent();
     *ExecutionResults << "Object resized in place successfully.\n";
-    ScriptState.Offset = ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).SerialOffset;
-    ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).SerialSize - 1;
+    ScriptState.Offset = ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).SerialOffset;
+    ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).SerialSize - 1;
     /// backup info
-    if (ScriptFlags.IsUninstallAllowed)
+    if (ScriptFlags.IsUninstallAllowed && ScriptFlags.IsTextBackup)
     {
         std::ostringstream ss;
-        ss << "OBJECT=" << ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).FullName << ":INPL" << "\n\n";
+        ss << "OBJECT=" << ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).FullName << ":INPL" << "\n\n";
         ss << "RESIZE=" << oldSize << "\n\n";
         ss << "[MODDED_HEX]\n" << MakeTextBlock(oldData.data(), oldData.size()) << "\n\n";
         ss << BackupScript[ScriptState.UPKName];
@@ -780,29 +1300,30 @@ bool ModScript::WriteBinaryData(const std::vector<char>& DataChunk)
                       << " (" << ScriptState.Offset << ")"
                       << "\nOffset (scope-relative): " << FormatHEX((uint32_t)ScriptState.RelOffset)
                       << " (" << ScriptState.RelOffset << ")\n";
-    if (!ScriptState.Package.WriteData(ScriptState.Offset + ScriptState.RelOffset, DataChunk, &BackupData))
+    if (!ScriptState.Package->WriteData(ScriptState.Offset + ScriptState.RelOffset, DataChunk, &BackupData))
     {
         *ErrorMessages << "Write error!\n";
         return SetBad();
     }
+    AddWriteExtent(ScriptState.Offset + ScriptState.RelOffset, DataChunk.size());
     *ExecutionResults << "Write successful!" << std::endl;
     /// backup info
-    if (ScriptFlags.IsUninstallAllowed)
+    if (ScriptFlags.IsUninstallAllowed && ScriptFlags.IsTextBackup)
     {
         std::ostringstream ss;
         switch (ScriptState.Scope)
         {
             case UPKScope::Object:
-                ss << "OBJECT=" << ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).FullName << "\n\n";
+                ss << "OBJECT=" << ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).FullName << "\n\n";
                 break;
             case UPKScope::Import:
-                ss << "IMPORT_ENTRY=" << ScriptState.Package.GetImportEntry(ScriptState.ObjIdx).FullName << "\n\n";
+                ss << "IMPORT_ENTRY=" << ScriptState.Package->GetImportEntry(ScriptState.ObjIdx).FullName << "\n\n";
                 break;
             case UPKScope::Export:
-                ss << "EXPORT_ENTRY=" << ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).FullName << "\n\n";
+                ss << "EXPORT_ENTRY=" << ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).FullName << "\n\n";
                 break;
             case UPKScope::Name:
-                ss << "NAME_ENTRY=" << ScriptState.Package.GetNameEntry(ScriptState.ObjIdx).Name << "\n\n";
+                ss << "NAME_ENTRY=" << ScriptState.Package->GetNameEntry(ScriptState.ObjIdx).Name << "\n\n";
                 break;
             default:
                 ss << "OFFSET=" << ScriptState.Offset << "\n\n";
@@ -829,9 +1350,97 @@ bool ModScript::WriteBinaryData(const std::vector<char>& DataChunk)
     return SetGood();
 }
 
+void ModScript::AddWriteExtent(size_t offset, size_t size)
+{
+    if (BatchMode == false || size == 0 || ModNames.empty())
+        return;
+    /// find written object or table entry, package scope writes inside serialized data belong to objects
+    UPKScope Scope = ScriptState.Scope;
+    uint32_t ObjIdx = ScriptState.ObjIdx;
+    if (Scope == UPKScope::Package)
+    {
+        ObjIdx = ScriptState.Package->FindObjectByOffset(offset);
+        if (ObjIdx > 0)
+            Scope = UPKScope::Object;
+    }
+    std::string Target = "";
+    size_t base = 0;
+    switch (Scope)
+    {
+    case UPKScope::Name:
+        base = ScriptState.Package->GetNameEntry(ObjIdx).EntryOffset;
+        Target = "name entry " + ScriptState.Package->GetNameEntry(ObjIdx).Name;
+        break;
+    case UPKScope::Import:
+        base = ScriptState.Package->GetImportEntry(ObjIdx).EntryOffset;
+        Target = "import entry " + ScriptState.Package->GetImportEntry(ObjIdx).FullName;
+        break;
+    case UPKScope::Export:
+        base = ScriptState.Package->GetExportEntry(ObjIdx).EntryOffset;
+        Target = "export entry " + ScriptState.Package->GetExportEntry(ObjIdx).FullName;
+        break;
+    case UPKScope::Object:
+        base = ScriptState.Package->GetExportEntry(ObjIdx).SerialOffset;
+        Target = "object " + ScriptState.Package->GetExportEntry(ObjIdx).FullName;
+        break;
+    default:
+        ObjIdx = 0;
+        Target = "package";
+        break;
+    }
+    AddWriteExtent(Scope, ObjIdx, Target, offset - std::min(base, offset), size);
+}
+
+void ModScript::AddWriteExtent(UPKScope Scope, uint32_t ObjIdx, const std::string& Target, size_t offset, size_t size)
+{
+    if (BatchMode == false || size == 0 || ModNames.empty())
+        return;
+    unsigned ModIdx = ModNames.size() - 1;
+    size_t end = offset + size;
+    std::ostringstream key;
+    key << ScriptState.UPKName << ":" << (int)Scope << ":" << ObjIdx;
+    std::map<size_t, WriteExtent>& Extents = WriteExtents[key.str()];
+    std::map<size_t, WriteExtent>::iterator first = Extents.upper_bound(offset);
+    if (first != Extents.begin() && std::prev(first)->second.End > offset)
+        --first;
+    /// new extent replaces overlapped parts of old extents
+    std::vector<std::pair<size_t, WriteExtent>> Remainders;
+    int ConflictIdx = -1;
+    std::map<size_t, WriteExtent>::iterator last = first;
+    for (; last != Extents.end() && last->first < end; ++last)
+    {
+        if (last->second.ModIdx != ModIdx && ConflictIdx < 0)
+            ConflictIdx = last->second.ModIdx;
+        if (last->first < offset)
+            Remainders.push_back({last->first, {offset, last->second.ModIdx}});
+        if (last->second.End > end)
+            Remainders.push_back({end, last->second});
+    }
+    Extents.erase(first, last);
+    Extents.insert(Remainders.begin(), Remainders.end());
+    Extents[offset] = {end, ModIdx};
+    if (ConflictIdx >= 0)
+    {
+        ++NumConflicts;
+        *ErrorMessages << "Conflict: " << ModNames[ModIdx] << " changes " << ScriptState.UPKName << " " << Target
+                       << " data at " << FormatHEX((uint32_t)offset) << " (" << size << " bytes), changed by "
+                       << ModNames[ConflictIdx] << std::endl;
+    }
+}
+
+void ModScript::AddObjectExtent()
+{
+    if (BatchMode == false || ScriptState.Scope != UPKScope::Object)
+        return;
+    const FObjectExport& Entry = ScriptState.Package->GetExportEntry(ScriptState.ObjIdx);
+    /// serial size and offset of the export entry
+    AddWriteExtent(UPKScope::Export, ScriptState.ObjIdx, "export entry " + Entry.FullName, sizeof(uint32_t) * 8, sizeof(uint32_t) * 2);
+    AddWriteExtent(UPKScope::Object, ScriptState.ObjIdx, "object " + Entry.FullName, 0, Entry.SerialSize);
+}
+
 bool ModScript::WriteModdedData(const std::vector<char>& DataChunk, bool FitScope)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -860,15 +1469,16 @@ bool ModScript::WriteUndoMoveResize(const std::string& Param)
         return SetBad();
     }
     *ExecutionResults << "Restoring object ...\n";
-    if (ScriptState.Package.UndoMoveResizeObject(ScriptState.ObjIdx) == false)
+    if (ScriptState.Package->UndoMoveResizeObject(ScriptState.ObjIdx) == false)
     {
         *ErrorMessages << "Error restoring object " << ScriptState.ObjIdx << std::endl;
         return SetBad();
     }
+    AddObjectExtent();
     *ExecutionResults << "Move/expand undo successful!\nScope set to current object.\n";
-    ScriptState.Offset = ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).SerialOffset;
+    ScriptState.Offset = ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).SerialOffset;
     ScriptState.RelOffset = 0;
-    ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).SerialSize - 1;
+    ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).SerialSize - 1;
     /*
     *ExecutionResults << "Scope: " << FormatUPKScope(ScriptState.Scope)
                       << "\nObject: " << ScriptState.ObjIdx
@@ -882,7 +1492,7 @@ bool ModScript::WriteUndoMoveResize(const std::string& Param)
 
 bool ModScript::ResizeExportObject(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -922,7 +1532,7 @@ bool ModScript::ResizeExportObject(const std::string& Param)
 
 bool ModScript::WriteBulkData(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -934,7 +1544,7 @@ bool ModScript::WriteBulkData(const std::string& Param)
     }
     std::vector<char> DataChunk = GetDataChunk(Param);
     *ExecutionResults << "Bulk data size = " << DataChunk.size() << std::endl;
-    std::vector<char> BulkData = ScriptState.Package.GetBulkData(ScriptState.Offset + ScriptState.RelOffset, DataChunk);
+    std::vector<char> BulkData = ScriptState.Package->GetBulkData(ScriptState.Offset + ScriptState.RelOffset, DataChunk);
     /// temporarily set ScriptState.Behavior to KEEP to avoid resizing!
     std::string SavedBehavior = ScriptState.Behavior;
     *ExecutionResults << "Temporarily resetting object behavior to KEEP!\n";
@@ -949,7 +1559,7 @@ bool ModScript::WriteBulkData(const std::string& Param)
 
 bool ModScript::WriteBulkFile(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -976,7 +1586,7 @@ bool ModScript::WriteBulkFile(const std::string& Param)
     std::vector<char> DataChunk(BulkSize);
     inFile.seekg(0);
     inFile.read(DataChunk.data(), DataChunk.size());
-    std::vector<char> BulkData = ScriptState.Package.GetBulkData(ScriptState.Offset + ScriptState.RelOffset, DataChunk);
+    std::vector<char> BulkData = ScriptState.Package->GetBulkData(ScriptState.Offset + ScriptState.RelOffset, DataChunk);
     /// temporarily set ScriptState.Behavior to KEEP to avoid resizing!
     std::string SavedBehavior = ScriptState.Behavior;
     *ExecutionResults << "Temporarily resetting object behavior to KEEP!\n";
@@ -1002,7 +1612,7 @@ bool ModScript::WriteModdedCode(const std::string& Param)
 
 bool ModScript::WriteReplacementCode(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -1012,13 +1622,13 @@ bool ModScript::WriteReplacementCode(const std::string& Param)
         *ErrorMessages << "Replacement code only works for export object data!\n";
         return SetBad();
     }
-    size_t ScriptSize = ScriptState.Package.GetScriptSize(ScriptState.ObjIdx);
+    size_t ScriptSize = ScriptState.Package->GetScriptSize(ScriptState.ObjIdx);
     if (ScriptSize == 0)
     {
         *ErrorMessages << "Object has no script to replace!\n";
         return SetBad();
     }
-    size_t ScriptRelOffset = ScriptState.Package.GetScriptRelOffset(ScriptState.ObjIdx);
+    size_t ScriptRelOffset = ScriptState.Package->GetScriptRelOffset(ScriptState.ObjIdx);
     ScriptState.RelOffset = ScriptRelOffset - 8;
     ScriptState.MaxOffset = ScriptState.Offset + ScriptRelOffset + ScriptSize - 1;
     unsigned ScriptMemorySize = 0;
@@ -1042,7 +1652,7 @@ bool ModScript::WriteReplacementCode(const std::string& Param)
 
 bool ModScript::WriteInsertCode(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -1064,7 +1674,7 @@ bool ModScript::WriteInsertCode(const std::string& Param)
 
 bool ModScript::WriteModdedFile(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -1113,7 +1723,7 @@ bool ModScript::WriteModdedFile(const std::string& Param)
     else
     {
         FileName = FileName.substr(0, FileName.find_last_of('.'));
-        UObjectReference ObjRef = ScriptState.Package.FindObject(FileName);
+        UObjectReference ObjRef = ScriptState.Package->FindObject(FileName);
         if (ObjRef > 0)
         {
             if (SetObject(FileName + ":" + Spec) == false)
@@ -1186,7 +1796,7 @@ bool ModScript::WriteNameIdx(const std::string& Param)
         num = 1 + GetIntValue(str.substr(pos + 1));
     }
     *ExecutionResults << "Searching for name " << str << " ...\n";
-    int idx = ScriptState.Package.FindName(Name);
+    int idx = ScriptState.Package->FindName(Name);
     if (idx < 0)
     {
         *ErrorMessages << "Incorrect name: " << str << std::endl;
@@ -1206,7 +1816,7 @@ bool ModScript::WriteObjectIdx(const std::string& Param)
 {
     std::string FullName = GetStringValue(Param);
     *ExecutionResults << "Searching for object named " << FullName << " ...\n";
-    UObjectReference ObjRef = ScriptState.Package.FindObject(FullName, false);
+    UObjectReference ObjRef = ScriptState.Package->FindObject(FullName, false);
     *ExecutionResults << "Object found!\n";
     if (ObjRef == 0)
     {
@@ -1240,7 +1850,7 @@ bool ModScript::SetDataOffset(const std::string& Param, bool isEnd, bool isBefor
     *ExecutionResults << "Searching for specified data chunk ...\n";
     if (ScriptState.Scope == UPKScope::Package)
     {
-        size_t offset = ScriptState.Package.FindDataChunk(DataChunk);
+        size_t offset = FindDataChunk(DataChunk);
         if (offset != 0)
         {
             if (isEnd) /// seek to the end of specified data
@@ -1255,7 +1865,7 @@ bool ModScript::SetDataOffset(const std::string& Param, bool isEnd, bool isBefor
             }
             else /// set scope to entire package
             {
-                ScriptState.MaxOffset = ScriptState.Package.GetFileSize() - 1;
+                ScriptState.MaxOffset = ScriptState.Package->GetFileSize() - 1;
             }
             *ExecutionResults << "Data found!\nGlobal offset: " << FormatHEX((uint32_t)ScriptState.Offset)
                               << " (" << ScriptState.Offset << ")" << std::endl;
@@ -1269,7 +1879,7 @@ bool ModScript::SetDataOffset(const std::string& Param, bool isEnd, bool isBefor
     else
     {
         size_t startOffset = ScriptState.Offset + ScriptState.RelOffset;
-        size_t offset = ScriptState.Package.FindDataChunk(DataChunk, startOffset, ScriptState.MaxOffset);
+        size_t offset = FindDataChunk(DataChunk, startOffset, ScriptState.MaxOffset);
         if (offset != 0)
         {
             if (isEnd) /// seek to the end of specified data
@@ -1298,9 +1908,83 @@ bool ModScript::SetDataOffset(const std::string& Param, bool isEnd, bool isBefor
     return SetGood();
 }
 
+size_t ModScript::FindDataChunk(const std::vector<char>& DataChunk, size_t beg, size_t limit)
+{
+    if (!FindCache.Enabled)
+        return ScriptState.Package->FindDataChunk(DataChunk, beg, limit);
+    size_t idx = std::find(FindCache.Patterns.begin(), FindCache.Patterns.end(), DataChunk) - FindCache.Patterns.begin();
+    if (idx == FindCache.Patterns.size())
+    {
+        FindCache.Patterns.assign(1, DataChunk);
+        FindCache.Valid = false;
+        idx = 0;
+    }
+    if (!FindCache.Valid)
+        BuildFindCache();
+    size_t FileSize = ScriptState.Package->GetFileSize();
+    size_t end = (limit == 0 ? FileSize : std::min(limit + 1, FileSize));
+    /// search outside of cached range
+    if (beg < FindCache.Begin || end > FindCache.End)
+        return ScriptState.Package->FindDataChunk(DataChunk, beg, limit);
+    if (limit != 0 && (limit - beg + 1 < DataChunk.size() || limit < beg))
+        return 0;
+    const std::vector<size_t>& Offsets = FindCache.Offsets[idx];
+    std::vector<size_t>::const_iterator it = std::lower_bound(Offsets.begin(), Offsets.end(), beg);
+    if (it == Offsets.end() || *it + DataChunk.size() > end)
+        return 0;
+    return *it;
+}
+
+void ModScript::BuildFindCache()
+{
+    if (ScriptState.Scope == UPKScope::Package)
+    {
+        FindCache.Begin = 0;
+        FindCache.End = ScriptState.Package->GetFileSize();
+    }
+    else
+    {
+        FindCache.Begin = ScriptState.Offset;
+        FindCache.End = ScriptState.MaxOffset + 1;
+    }
+    FindCache.Offsets.assign(FindCache.Patterns.size(), std::vector<size_t>());
+    if (FindCache.End > FindCache.Begin)
+    {
+        FindCache.Offsets = ScriptState.Package->FindDataChunks(FindCache.Patterns, FindCache.Begin, FindCache.End - 1);
+    }
+    FindCache.Valid = true;
+}
+
+void ModScript::UpdateFindCache(size_t offset, size_t size)
+{
+    if (!FindCache.Valid)
+        return;
+    size_t MaxSize = 1;
+    for (unsigned i = 0; i < FindCache.Patterns.size(); ++i)
+        MaxSize = std::max(MaxSize, FindCache.Patterns[i].size());
+    /// occurrences overlapping written data may be changed, all the patterns are searched in one pass
+    size_t first = (offset > FindCache.Begin + MaxSize - 1 ? offset - MaxSize + 1 : FindCache.Begin);
+    size_t last = std::min(offset + size + MaxSize - 1, FindCache.End);
+    std::vector<std::vector<size_t>> Found(FindCache.Patterns.size());
+    if (last > first)
+    {
+        Found = ScriptState.Package->FindDataChunks(FindCache.Patterns, first, last - 1);
+    }
+    for (unsigned i = 0; i < FindCache.Patterns.size(); ++i)
+    {
+        /// occurrences, which start after written data, are not changed
+        std::vector<size_t>& Offsets = FindCache.Offsets[i];
+        std::vector<size_t>::iterator beg = std::lower_bound(Offsets.begin(), Offsets.end(), first);
+        std::vector<size_t>::iterator end = std::lower_bound(beg, Offsets.end(), offset + size);
+        std::vector<size_t>::iterator foundEnd = std::lower_bound(Found[i].begin(), Found[i].end(), offset + size);
+        beg = Offsets.erase(beg, end);
+        Offsets.insert(beg, Found[i].begin(), foundEnd);
+    }
+}
+
 bool ModScript::SetDataChunkOffset(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -1325,7 +2009,7 @@ bool ModScript::SetDataChunkOffset(const std::string& Param)
 
 bool ModScript::SetCodeOffset(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -1350,7 +2034,7 @@ bool ModScript::SetCodeOffset(const std::string& Param)
 
 bool ModScript::SetBeforeHEXOffset(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -1360,7 +2044,7 @@ bool ModScript::SetBeforeHEXOffset(const std::string& Param)
 
 bool ModScript::SetBeforeCodeOffset(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -1378,7 +2062,7 @@ bool ModScript::WriteAfterHEX(const std::string& Param)
 
 bool ModScript::WriteAfterCode(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -1412,28 +2096,62 @@ bool ModScript::WriteReplaceAll(const std::string& Param, bool isCode)
     size_t SavedRelOffset = ScriptState.RelOffset;
     size_t RelOffset = SavedRelOffset;
     size_t MaxRelOffset = ScriptState.MaxOffset - ScriptState.Offset;
+    /// before data occurrences are found in one pass and updated after each write
+    /// before data of the following REPLACE_HEX commands are searched in the same pass
+    if (!isCode)
+    {
+        std::vector<char> BeforeChunk = GetDataChunk(BeforeStr);
+        if (std::find(FindCache.Patterns.begin(), FindCache.Patterns.end(), BeforeChunk) == FindCache.Patterns.end())
+        {
+            ResetFindCache();
+            FindCache.Patterns.push_back(BeforeChunk);
+            for (unsigned i = ExecIdx + 1; i < ExecutionStack.size() && ExecutionStack[i].Exec == &ModScript::WriteReplaceAllHEX; ++i)
+            {
+                std::string NextBeforeStr, NextAfterStr;
+                SplitAt(':', ExecutionStack[i].Param, NextBeforeStr, NextAfterStr);
+                std::vector<char> NextChunk = GetDataChunk(NextBeforeStr);
+                if (NextChunk.size() > 0)
+                    FindCache.Patterns.push_back(NextChunk);
+            }
+        }
+    }
+    FindCache.Enabled = true;
     while (RelOffset + BeforeSize <= MaxRelOffset)
     {
         ScriptState.RelOffset = RelOffset;
-        if (isCode)
+        if (isCode ? !SetBeforeCodeOffset(BeforeStr) : !SetBeforeHEXOffset(BeforeStr))
+            break;
+        /// writes, which move/resize objects or change anything but found data, invalidate search results
+        size_t WriteOffset = ScriptState.Offset + ScriptState.RelOffset;
+        size_t FileSize = ScriptState.Package->GetFileSize();
+        size_t ScopeOffset = ScriptState.Offset;
+        bool isObject = (ScriptState.Scope == UPKScope::Object);
+        size_t ObjSize = (isObject ? ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).SerialSize : 0);
+        size_t MemSize = (isObject && isCode ? ScriptState.Package->GetScriptMemSize(ScriptState.ObjIdx) : 0);
+        if (isCode ? !WriteAfterCode(AfterStr) : !WriteAfterHEX(AfterStr))
         {
-            if (!SetBeforeCodeOffset(BeforeStr))
-                break;
-            if (!WriteAfterCode(AfterStr))
-                return SetBad();
+            ResetFindCache();
+            return SetBad();
+        }
+        if (FileSize != ScriptState.Package->GetFileSize() ||
+            (isObject && (ScopeOffset != ScriptState.Offset ||
+                          ObjSize != ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).SerialSize ||
+                          (isCode && MemSize != ScriptState.Package->GetScriptMemSize(ScriptState.ObjIdx)))))
+        {
+            FindCache.Valid = false;
         }
         else
         {
-            if (!SetBeforeHEXOffset(BeforeStr))
-                break;
-            if (!WriteAfterHEX(AfterStr))
-                return SetBad();
+            /// data written in place has the same size as found data
+            UpdateFindCache(WriteOffset, BeforeSize);
         }
         /// because write operation can cause object resize AfterSize is used
         /// and MaxRelOffset is re-calculated
         RelOffset += AfterSize;
         MaxRelOffset = ScriptState.MaxOffset - ScriptState.Offset;
     }
+    /// search results are kept for the next REPLACE_HEX command
+    FindCache.Enabled = false;
     if (ScriptFlags.UpdateRelOffset != true)
     {
         ScriptState.RelOffset = SavedRelOffset;
@@ -1443,7 +2161,7 @@ bool ModScript::WriteReplaceAll(const std::string& Param, bool isCode)
 
 bool ModScript::WriteAfterData(const std::string& DataBlock, int MemSize)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -1489,14 +2207,14 @@ bool ModScript::GetAdjustedSizes(std::vector<char>& SizesChunk, size_t& SizesRel
     {
         return false;
     }
-    size_t ScriptSize = ScriptState.Package.GetScriptSize(ScriptState.ObjIdx);
+    size_t ScriptSize = ScriptState.Package->GetScriptSize(ScriptState.ObjIdx);
     /// does not have script
     if (ScriptSize == 0)
     {
         return false;
     }
-    size_t ScriptMemSize = ScriptState.Package.GetScriptMemSize(ScriptState.ObjIdx);
-    size_t ScriptRelOffset = ScriptState.Package.GetScriptRelOffset(ScriptState.ObjIdx);
+    size_t ScriptMemSize = ScriptState.Package->GetScriptMemSize(ScriptState.ObjIdx);
+    size_t ScriptRelOffset = ScriptState.Package->GetScriptRelOffset(ScriptState.ObjIdx);
     size_t ScopeSize = ScriptState.MaxOffset - ScriptState.Offset - ScriptState.RelOffset + 1;
     /// checking if we're inside script
     if ( ScriptState.RelOffset >= ScriptRelOffset &&
@@ -1533,7 +2251,7 @@ bool ModScript::GetAdjustedSizes(std::vector<char>& SizesChunk, size_t& SizesRel
 
 bool ModScript::WriteMoveExpandLegacy(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -1548,24 +2266,25 @@ bool ModScript::WriteMoveExpandLegacy(const std::string& Param)
     if (SetObject(ObjName) == false)
         return SetBad();
     *ExecutionResults << "Moving/expanding function ...\n";
-    if (ScriptState.Package.MoveExportData(ScriptState.ObjIdx, NewSize) == false)
+    if (ScriptState.Package->MoveExportData(ScriptState.ObjIdx, NewSize) == false)
     {
         *ErrorMessages << "Error expanding function!\n";
         return SetBad();
     }
+    AddObjectExtent();
     *ExecutionResults << "Function moved/expanded successfully!\n";
     /// backup info
-    if (ScriptFlags.IsUninstallAllowed)
+    if (ScriptFlags.IsUninstallAllowed && ScriptFlags.IsTextBackup)
     {
         std::ostringstream ss;
-        ss << "EXPAND_UNDO=" << ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).FullName << "\n\n";
+        ss << "EXPAND_UNDO=" << ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).FullName << "\n\n";
         ss << BackupScript[ScriptState.UPKName];
         BackupScript[ScriptState.UPKName] = ss.str();
     }
     /// set new offset value
-    ScriptState.Offset = ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).SerialOffset;
+    ScriptState.Offset = ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).SerialOffset;
     ScriptState.RelOffset = 0;
-    ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).SerialSize - 1;
+    ScriptState.MaxOffset = ScriptState.Offset + ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).SerialSize - 1;
     return SetGood();
 }
 
@@ -1602,7 +2321,7 @@ std::string ModScript::GetBackupScript()
 
 bool ModScript::WriteRename(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -1633,14 +2352,15 @@ bool ModScript::WriteRename(const std::string& Param)
             return SetGood();
         }
     }
-    if (ScriptState.Package.WriteNameTableName(ScriptState.ObjIdx, NewName) == false)
+    if (ScriptState.Package->WriteNameTableName(ScriptState.ObjIdx, NewName) == false)
     {
         *ErrorMessages << "Error writing new name!\n";
         return SetBad();
     }
+    AddWriteExtent(ScriptState.Package->GetNameEntry(ScriptState.ObjIdx).EntryOffset + 4, NewName.length());
     *ExecutionResults << "Renamed successfully!\n";
     /// backup info
-    if (ScriptFlags.IsUninstallAllowed)
+    if (ScriptFlags.IsUninstallAllowed && ScriptFlags.IsTextBackup)
     {
         std::ostringstream ss;
         ss << "RENAME=" << NewName << ":" << ObjName << "\n\n";
@@ -1652,7 +2372,7 @@ bool ModScript::WriteRename(const std::string& Param)
 
 bool ModScript::WriteAddNameEntry(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -1660,28 +2380,33 @@ bool ModScript::WriteAddNameEntry(const std::string& Param)
     *ExecutionResults << "Adding new name entry ...\n";
     FNameEntry Entry;
     std::vector<char> data = GetDataChunk(ParseScript(Param));
-    if (!ScriptState.Package.Deserialize(Entry, data))
+    if (!ScriptState.Package->Deserialize(Entry, data))
     {
         *ErrorMessages << "Error deserializing new name entry: wrong data!\n";
         return SetBad();
     }
-    if (ScriptState.Package.FindName(Entry.Name) != -1)
+    if (ScriptState.Package->FindName(Entry.Name) != -1)
     {
         *ExecutionResults << "Name " << Entry.Name << " already exists, skipping...\n";
         return SetGood();
     }
-    if (!ScriptState.Package.AddNameEntry(Entry))
+    if (!BeginHeaderAdditions())
+    {
+        return SetBad();
+    }
+    if (!ScriptState.Package->AddNameEntry(Entry))
     {
         *ErrorMessages << "Error adding new name entry!\n";
         return SetBad();
     }
+    AddWriteExtent(UPKScope::Name, ScriptState.Package->FindName(Entry.Name), "name entry " + Entry.Name, 0, Entry.EntrySize);
     *ExecutionResults << "Name " << Entry.Name << " added successfully!\n";
     return SetGood();
 }
 
 bool ModScript::WriteAddImportEntry(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -1689,28 +2414,33 @@ bool ModScript::WriteAddImportEntry(const std::string& Param)
     *ExecutionResults << "Adding new import entry ...\n";
     FObjectImport Entry;
     std::vector<char> data = GetDataChunk(ParseScript(Param));
-    if (!ScriptState.Package.Deserialize(Entry, data))
+    if (!ScriptState.Package->Deserialize(Entry, data))
     {
         *ErrorMessages << "Error deserializing new import entry: wrong data!\n";
         return SetBad();
     }
-    if (ScriptState.Package.FindObject(Entry.FullName, false) != 0)
+    if (ScriptState.Package->FindObject(Entry.FullName, false) != 0)
     {
         *ExecutionResults << "Import object " << Entry.FullName << " already exists, skipping...\n";
         return SetGood();
     }
-    if (!ScriptState.Package.AddImportEntry(Entry))
+    if (!BeginHeaderAdditions())
+    {
+        return SetBad();
+    }
+    if (!ScriptState.Package->AddImportEntry(Entry))
     {
         *ErrorMessages << "Error adding new import entry!\n";
         return SetBad();
     }
+    AddWriteExtent(UPKScope::Import, -ScriptState.Package->FindObject(Entry.FullName, false), "import entry " + Entry.FullName, 0, Entry.EntrySize);
     *ExecutionResults << "Import object " << Entry.FullName << " added successfully!\n";
     return SetGood();
 }
 
 bool ModScript::WriteAddExportEntry(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -1718,22 +2448,30 @@ bool ModScript::WriteAddExportEntry(const std::string& Param)
     *ExecutionResults << "Adding new export entry ...\n";
     FObjectExport Entry;
     std::vector<char> data = GetDataChunk(ParseScript(Param));
-    if (!ScriptState.Package.Deserialize(Entry, data))
+    if (!ScriptState.Package->Deserialize(Entry, data))
     {
         *ErrorMessages << "Error deserializing new export entry: wrong data!\n";
         return SetBad();
     }
-    if (ScriptState.Package.FindObject(Entry.FullName, true) != 0)
+    UObjectReference ExistingRef = ScriptState.Package->FindObject(Entry.FullName, true);
+    if (ExistingRef != 0)
     {
         *ExecutionResults << "Export object " << Entry.FullName << " already exists, skipping...\n";
+        /// entry added by previous mod may differ from this one
+        AddWriteExtent(UPKScope::Export, ExistingRef, "export entry " + Entry.FullName, 0, Entry.EntrySize);
         return SetGood();
     }
-    if (!ScriptState.Package.AddExportEntry(Entry))
+    if (!BeginHeaderAdditions())
+    {
+        return SetBad();
+    }
+    if (!ScriptState.Package->AddExportEntry(Entry))
     {
         *ErrorMessages << "Error adding new export entry!\n";
         return SetBad();
     }
-    *ExecutionResults << "Export object " << Entry.FullName << " added and linked successfully!\n";
+    AddWriteExtent(UPKScope::Export, ScriptState.Package->FindObject(Entry.FullName, true), "export entry " + Entry.FullName, 0, Entry.EntrySize);
+    *ExecutionResults << "Export object " << Entry.FullName << " added successfully!\n";
     return SetGood();
 }
 
@@ -1743,7 +2481,7 @@ bool ModScript::WriteAddExportEntry(const std::string& Param)
 
 bool ModScript::AddAlias(const std::string& Param)
 {
-    if (ScriptState.Package.IsLoaded() == false)
+    if (ScriptState.Package->IsLoaded() == false)
     {
         *ErrorMessages << "Package is not opened!\n";
         return SetBad();
@@ -1757,7 +2495,7 @@ bool ModScript::AddAlias(const std::string& Param)
     }
     if (ScriptState.Scope == UPKScope::Object)
     {
-        Name = ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).FullName + '.' + Name;
+        Name = ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).FullName + '.' + Name;
     }
     if (Alias.count(Name) != 0)
     {
@@ -1902,6 +2640,40 @@ std::string ExtractString(std::string str)
 }
 
 std::string ModScript::ParseScript(std::string ScriptData, unsigned* ScriptMemSizeRef)
+{
+    if (PlanState.Enabled == false)
+    {
+        return ParseScriptText(ScriptData, ScriptMemSizeRef);
+    }
+    FPlanParsedScript Parsed;
+    Parsed.SourceHash = HashData(ScriptData);
+    if (PlanState.Valid)
+    {
+        const FPlanParsedScript* Found = Plan.FindParsedScript(PlanState.CommandIdx, Parsed.SourceHash);
+        if (Found != nullptr)
+        {
+            if (ScriptMemSizeRef != nullptr)
+            {
+                (*ScriptMemSizeRef) = Found->MemSize;
+            }
+            return Found->ParsedHEX;
+        }
+    }
+    Parsed.MemSize = 0;
+    Parsed.ParsedHEX = ParseScriptText(ScriptData, &Parsed.MemSize);
+    if (ScriptState.Good == false)
+    {
+        return Parsed.ParsedHEX;
+    }
+    Plan.SetParsedScript(PlanState.CommandIdx, Parsed);
+    if (ScriptMemSizeRef != nullptr)
+    {
+        (*ScriptMemSizeRef) = Parsed.MemSize;
+    }
+    return Parsed.ParsedHEX;
+}
+
+std::string ModScript::ParseScriptText(std::string ScriptData, unsigned* ScriptMemSizeRef)
 {
     std::ostringstream ScriptHEX;
     std::istringstream WorkingData(ScriptData);
@@ -2112,7 +2884,7 @@ std::string ModScript::TokenToHEX(std::string Token, unsigned* MemSizeRef)
         std::string Name = Code.substr(1);
         if (ScriptState.Scope == UPKScope::Object)
         {
-            Name = ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).FullName + '.' + Name;
+            Name = ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).FullName + '.' + Name;
             if (Alias.count(Name) == 0)
             {
                 Name = Code.substr(1);
@@ -2125,7 +2897,7 @@ std::string ModScript::TokenToHEX(std::string Token, unsigned* MemSizeRef)
             return std::string("");
         }
         std::string replacement = Alias[Name];
-        std::string parsed = ParseScript(replacement, &MemSize);
+        std::string parsed = ParseScriptText(replacement, &MemSize);
         dataChunk = GetDataChunk(parsed);
     }
     else if (Code[0] == '%')
@@ -2201,10 +2973,10 @@ std::string ModScript::TokenToHEX(std::string Token, unsigned* MemSizeRef)
             SetBad();
             return std::string("");
         }
-        std::string ObjName = ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).FullName;
+        std::string ObjName = ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).FullName;
         std::string ClassName = ObjName.substr(0, ObjName.find('.'));
         std::string VarName = ClassName + '.' + Code.substr(1);
-        UObjectReference ObjRef = ScriptState.Package.FindObject(VarName, true);
+        UObjectReference ObjRef = ScriptState.Package->FindObject(VarName, true);
         if (ObjRef == 0)
         {
             *ErrorMessages << "Bad object name: " << VarName << std::endl;
@@ -2228,14 +3000,14 @@ std::string ModScript::TokenToHEX(std::string Token, unsigned* MemSizeRef)
             }
             else
             {
-                ObjName = ScriptState.Package.GetExportEntry(ScriptState.ObjIdx).FullName + Code;
+                ObjName = ScriptState.Package->GetExportEntry(ScriptState.ObjIdx).FullName + Code;
             }
         }
         else if (Code.find("Class.") == 0) /// class reference
         {
             ObjName = Code.substr(6);
         }
-        UObjectReference ObjRef = ScriptState.Package.FindObject(ObjName, false);
+        UObjectReference ObjRef = ScriptState.Package->FindObject(ObjName, false);
         if (ObjRef == 0)
         {
             *ErrorMessages << "Bad object name: " << ObjName << std::endl;
@@ -2261,7 +3033,7 @@ std::string ModScript::TokenToHEX(std::string Token, unsigned* MemSizeRef)
             Name = Code.substr(0, pos);
             num = 1 + GetIntValue(Code.substr(pos + 1));
         }
-        int idx = ScriptState.Package.FindName(Name);
+        int idx = ScriptState.Package->FindName(Name);
         if (idx < 0)
         {
             *ErrorMessages << "Bad name: " << Name << std::endl;
@@ -2,9 +2,12 @@
 #define MODSCRIPT_H
 
 #include <map>
+#include <memory>
 #include <sstream>
 
 #include "ModParser.h"
+#include "ModPlan.h"
+#include "UndoJournal.h"
 #include "UPKUtils.h"
 
 enum class UPKScope
@@ -20,18 +23,43 @@ std::string FormatUPKScope(UPKScope scope);
 class ModScript
 {
 public:
-    ModScript(): UPKPath(".") { InitStreams(); SetBad(); }
+    ModScript(): UPKPath("."), NumThreads(1), Transactions(true), ExecIdx(0), TextBackup(true) { InitStreams(); ResetFindCache(); ResetPlanState(); ResetBatch(false); SetBad(); }
     ~ModScript() {};
-    ModScript(const char* filename): UPKPath(".") { InitStreams(); Parse(filename); }
-    ModScript(const char* filename, const char* pathname) { InitStreams(); Parse(filename); SetUPKPath(pathname); }
+    ModScript(const char* filename): UPKPath("."), NumThreads(1), Transactions(true), ExecIdx(0), TextBackup(true) { InitStreams(); ResetFindCache(); ResetPlanState(); ResetBatch(false); Parse(filename); }
+    ModScript(const char* filename, const char* pathname): NumThreads(1), Transactions(true), ExecIdx(0), TextBackup(true) { InitStreams(); ResetFindCache(); ResetPlanState(); ResetBatch(false); Parse(filename); SetUPKPath(pathname); }
     /// Init stream objects
     void InitStreams(std::ostream& err = std::cerr, std::ostream& res = std::cout);
     /// parse mod file to build execution stack
     bool Parse(const char* filename);
+    /// load execution stack from precompiled plan, if plan is up to date
+    /// parse mod file and compile new plan otherwise
+    bool ParsePlan(const char* filename, const char* planname);
+    /// save compiled plan (plan is saved only if it was changed)
+    bool SavePlan();
     /// set path to upk files, referenced inside mod files
     void SetUPKPath(const char* pathname);
     /// execute script
     bool ExecuteStack();
+    /// number of threads to execute commands for different packages in parallel
+    /// not used in batch mode and with precompiled plans
+    void SetNumThreads(unsigned val) { NumThreads = (val > 0 ? val : 1); }
+    /// packages are changed only if the whole script was executed successfully
+    /// not used in batch mode
+    void SetTransactions(bool val) { Transactions = val; }
+    /// batch mode: mod files are parsed and executed one by one, each package is read once
+    /// and kept open for all the mods, writes are buffered until FlushPackages call
+    void SetBatchMode(bool val) { FlushPackages(); ResetBatch(val); }
+    bool FlushPackages();
+    /// number of writes, which changed data written by other mods in batch mode
+    unsigned GetConflictsCount() { return NumConflicts; }
+    /// text uninstall script is made only if switched on or if uninstall is switched off
+    /// for some parts of the script, as undo journal can't undo them separately
+    void SetTextBackup(bool val) { TextBackup = val; }
+    /// undo journal is made for scripts, which allow uninstall of all their changes
+    bool HasUndoJournal();
+    bool SaveUndoJournal(const char* filename);
+    /// undo changes saved to journal, packages must be in the state the mod left them in
+    bool ExecuteUndo(const char* filename);
     /// state
     std::string GetBackupScript();
     bool IsGood() { return ScriptState.Good; }
@@ -45,25 +73,63 @@ protected:
     };
     ModParser Parser;
     std::string UPKPath;
+    unsigned NumThreads;
+    bool Transactions;
     std::map<std::string, ExecFunction> Executors;
     std::vector<ScriptCommand> ExecutionStack;
+    unsigned ExecIdx;               /// command being executed
     std::ostream *ErrorMessages;
     std::ostream *ExecutionResults;
     std::map<std::string, std::string> BackupScript;
+    bool TextBackup;
+    UndoJournal Journal;
     std::multimap<std::string, std::string> GUIDs;
     std::vector<std::string> UPKNames;
     std::map<std::string, std::string> Alias;
+    /// packages by path, empty path is a package, which is used in single mod mode
+    std::map<std::string, std::unique_ptr<UPKUtils>> Packages;
+    bool BatchMode;
+    /// data written by mods in batch mode: written object or table entry -> offset inside it ->
+    /// end offset and mod index, relative offsets stay valid when objects are moved or resized
+    /// and header entries are added by later mods
+    /// data writes and renames record written bytes, moves and resizes record the whole object
+    /// and its serial size and offset, additions record the whole new entry
+    struct WriteExtent
+    {
+        size_t End;
+        unsigned ModIdx;
+    };
+    std::map<std::string, std::map<size_t, WriteExtent>> WriteExtents;
+    std::vector<std::string> ModNames;
+    unsigned NumConflicts;
+    void ResetBatch(bool batchMode);
+    void ResetModState(const char* filename);
+    void ResetJournal();
+    bool IsUninstallPartial();
+    void AddWriteExtent(size_t offset, size_t size);
+    void AddWriteExtent(UPKScope Scope, uint32_t ObjIdx, const std::string& Target, size_t offset, size_t size);
+    /// moved or resized object: its export entry serial size and offset and all its data
+    void AddObjectExtent();
     void SetExecutors(); /// map names to keys/sections and functions
+    /// execute commands [first, last), commands of other segments are skipped,
+    /// except for package switches and script state changes
+    bool ExecuteCommands(unsigned first, unsigned last, const std::vector<unsigned>* Segments = nullptr, unsigned Segment = 0);
+    /// execute segments of different packages in parallel
+    bool ExecuteSegments();
+    bool IsStateCommand(ExecFunction Exec);
+    /// commit or roll back package changes made by executed script
+    bool EndTransactions(bool commit);
     struct
     {
         bool UpdateRelOffset;
         bool IsUninstallAllowed;
+        bool IsTextBackup;
     } ScriptFlags;
-    void ResetScriptFlags() { ScriptFlags.UpdateRelOffset = false; ScriptFlags.IsUninstallAllowed = true; }
+    void ResetScriptFlags() { ScriptFlags.UpdateRelOffset = false; ScriptFlags.IsUninstallAllowed = true; ScriptFlags.IsTextBackup = true; }
     struct
     {
         std::string UPKName;
-        UPKUtils Package;
+        UPKUtils* Package;
         UPKScope Scope;
         uint32_t ObjIdx;
         size_t Offset;
@@ -75,6 +141,30 @@ protected:
         unsigned BeforeMemSize;
     } ScriptState;
     void ResetScope() { ScriptState.Scope = UPKScope::Package; ScriptState.ObjIdx = 0; ScriptState.Offset = 0; ScriptState.RelOffset = 0; ScriptState.MaxOffset = 0; ScriptState.Behavior = "KEEP"; ScriptState.BeforeUsed = false; ScriptState.BeforeMemSize = 0; }
+    /// occurrences of searched data, found in one pass and updated after each write
+    /// used by REPLACE_HEX/REPLACE_CODE only, before data of consecutive REPLACE_HEX commands
+    /// are searched together and are kept until any other command is executed
+    struct
+    {
+        bool Enabled;
+        bool Valid;
+        std::vector<std::vector<char>> Patterns;
+        size_t Begin;               /// searched range [Begin, End)
+        size_t End;
+        std::vector<std::vector<size_t>> Offsets;   /// occurrences of each pattern
+    } FindCache;
+    void ResetFindCache() { FindCache.Enabled = false; FindCache.Valid = false; FindCache.Patterns.clear(); FindCache.Offsets.clear(); }
+    /// precompiled plan: pseudo-code is parsed once and re-used while packages are in the same state
+    ModPlan Plan;
+    struct
+    {
+        bool Enabled;
+        bool Valid;                 /// plan matches mod file and packages
+        unsigned CommandIdx;        /// command being executed
+        std::string FileName;
+    } PlanState;
+    void ResetPlanState() { PlanState.Enabled = false; PlanState.Valid = false; PlanState.CommandIdx = 0; PlanState.FileName = ""; }
+    void CheckPlanPackage();
     bool SetBad() { return (ScriptState.Good = false); }
     bool SetGood() { return (ScriptState.Good = true); }
     void AddUPKName(std::string upkname);
@@ -126,10 +216,17 @@ protected:
     bool WriteAddNameEntry(const std::string& Param);
     bool WriteAddImportEntry(const std::string& Param);
     bool WriteAddExportEntry(const std::string& Param);
+    /// batched header additions
+    bool IsHeaderAddition(ExecFunction Exec);
+    bool BeginHeaderAdditions();
+    bool CommitHeaderAdditions();
     /// helpers
     bool CheckBehavior();
     bool IsInsideScope(size_t DataSize = 1);
     bool SetDataOffset(const std::string& Param, bool isEnd, bool isBeforeData);
+    size_t FindDataChunk(const std::vector<char>& DataChunk, size_t beg = 0, size_t limit = 0);
+    void BuildFindCache();
+    void UpdateFindCache(size_t offset, size_t size);
     bool CheckMoveResize(size_t DataSize, bool FitScope = false);
     bool DoResize(int ObjSize);
     bool MoveResizeAtRelOffset(int ObjSize);
@@ -142,6 +239,7 @@ protected:
     void ResetMaxOffset();
     /// parse script
     std::string ParseScript(std::string ScriptData, unsigned* ScriptMemSizeRef = nullptr);
+    std::string ParseScriptText(std::string ScriptData, unsigned* ScriptMemSizeRef = nullptr);
     bool IsHEX(std::string word);
     bool IsToken(std::string word);
     bool IsCommand(std::string word);
@@ -0,0 +1,53 @@
+#ifndef PARALLELFOR_H
+#define PARALLELFOR_H
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+/// number of worker threads to use: requested number or number of hardware threads if 0
+inline unsigned GetNumThreads(unsigned requested = 0)
+{
+    if (requested > 0)
+        return requested;
+    unsigned hw = std::thread::hardware_concurrency();
+    return (hw > 0 ? hw : 1);
+}
+
+/// calls func(i, worker) for each i in [0, count) using numThreads workers
+/// worker is the index of the calling worker in [0, numThreads), so per-worker
+/// scratch data can be indexed by it
+/// items are handed out one at a time, so uneven items are balanced between workers
+/// func is called on the calling thread only if numThreads < 2
+inline void ParallelForWorkers(size_t count, unsigned numThreads, const std::function<void(size_t, unsigned)>& func)
+{
+    if (numThreads > count)
+        numThreads = count;
+    if (numThreads < 2)
+    {
+        for (size_t i = 0; i < count; ++i)
+            func(i, 0);
+        return;
+    }
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < numThreads; ++t)
+    {
+        workers.push_back(std::thread([&, t]()
+        {
+            for (size_t i = next++; i < count; i = next++)
+                func(i, t);
+        }));
+    }
+    for (unsigned t = 0; t < workers.size(); ++t)
+        workers[t].join();
+}
+
+/// calls func(i) for each i in [0, count) using numThreads workers
+inline void ParallelFor(size_t count, unsigned numThreads, const std::function<void(size_t)>& func)
+{
+    ParallelForWorkers(count, numThreads, [&func](size_t i, unsigned) { func(i); });
+}
+
+#endif // PARALLELFOR_H
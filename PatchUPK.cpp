@@ -1,8 +1,10 @@
 #include <iostream>
 #include <sstream>
 #include <cstring>
+#include <cstdlib>
 
 #include "ModScript.h"
+#include "ParallelFor.h"
 
 using namespace std;
 
@@ -21,21 +23,113 @@ string int2fstr(int val)
     return ss.str();
 }
 
+/// parse and execute mod file, save undo journal and uninstall script
+bool ApplyMod(ModScript& script, string modName, bool usePlan)
+{
+    if (usePlan)
+    {
+        string planName = modName + string(".plan");
+        script.ParsePlan(modName.c_str(), planName.c_str());
+    }
+    else
+    {
+        script.Parse(modName.c_str());
+    }
+    if (script.IsGood() == false)
+    {
+        return false;
+    }
+
+    bool ExecResult = script.ExecuteStack();
+
+    if (ExecResult && usePlan)
+    {
+        script.SavePlan();
+    }
+
+    string backupScript = script.GetBackupScript();
+    bool hasJournal = script.HasUndoJournal();
+
+    if (modName.find(".uninstall") != string::npos || (backupScript == "" && !hasJournal))
+    {
+        return ExecResult;
+    }
+
+    /// undo journal and uninstall script of the same mod have the same number
+    unsigned i = 0;
+    string baseName = "";
+    do
+    {
+        baseName = modName + string(".uninstall") + int2fstr(i);
+        ++i;
+    } while (FileExists(baseName + string(".txt")) || FileExists(baseName + string(".bin")));
+
+    if (hasJournal)
+    {
+        string journalName = baseName + string(".bin");
+        if (!script.SaveUndoJournal(journalName.c_str()))
+        {
+            return false;
+        }
+        cout << "Undo journal saved to " << journalName << endl;
+    }
+
+    if (backupScript != "")
+    {
+        string nextName = baseName + string(".txt");
+        ofstream uninstFile(nextName);
+        if (!uninstFile.good())
+        {
+            cerr << "Error saving uninstall script!" << endl;
+            return false;
+        }
+        uninstFile << "MOD_NAME=" << modName << " uninstall script\n"
+                   << "AUTHOR=PatchUPK\n"
+                   << "DESCRIPTION=This is automatically generated uninstall script. Do not change anything!\n\n"
+                   << backupScript << "\n{ backup script end }\n";
+        cout << "Uninstall script saved to " << nextName << endl;
+    }
+
+    return ExecResult;
+}
+
 int main(int argN, char* argV[])
 {
     cout << "PatchUPK" << endl;
 
-    if (argN < 2 || argN > 3)
+    bool usePlan = false, useBatch = false, useUndo = false, saveText = false;
+    unsigned numThreads = 1;
+    vector<string> args;
+    for (int i = 1; i < argN; ++i)
     {
-        cerr << "Usage: PatchUPK modfile.txt [PATH_TO_UPK]" << endl;
+        string arg = argV[i];
+        if (arg == "/p")
+            usePlan = true;
+        else if (arg == "/b" && args.empty())
+            useBatch = true;
+        else if ((arg == "/u" || arg == "--undo") && args.empty())
+            useUndo = true;
+        else if (arg == "/t")
+            saveText = true;
+        else if (arg == "/j" && i + 1 < argN)
+            numThreads = GetNumThreads(atoi(argV[++i]));
+        else
+            args.push_back(arg);
+    }
+
+    if (args.size() < 1 || args.size() > 2)
+    {
+        cerr << "Usage: PatchUPK modfile.txt [PATH_TO_UPK] [/p] [/j N] [/t]" << endl;
+        cerr << "       PatchUPK /b modlist.txt [PATH_TO_UPK] [/p] [/t]" << endl;
+        cerr << "       PatchUPK /u modfile.txt.uninstall.bin [PATH_TO_UPK]" << endl;
         return 1;
     }
 
     string upkPath = "";
 
-    if (argN == 3)
+    if (args.size() == 2)
     {
-        upkPath = argV[2];
+        upkPath = args[1];
         if (upkPath.length() < 1)
         {
             cerr << "Incorrect package path!" << endl;
@@ -43,41 +137,64 @@ int main(int argN, char* argV[])
         }
     }
 
-    ModScript script(argV[1], upkPath.c_str());
+    ModScript script;
     script.InitStreams(std::cerr, std::cout);
-    if (script.IsGood() == false)
+    script.SetUPKPath(upkPath.c_str());
+    script.SetNumThreads(numThreads);
+    script.SetTextBackup(saveText);
+
+    if (useUndo)
     {
-        return 1;
+        return (script.ExecuteUndo(args[0].c_str()) ? 0 : 1);
     }
 
-    bool ExecResult = script.ExecuteStack();
+    if (!useBatch)
+    {
+        return (ApplyMod(script, args[0], usePlan) ? 0 : 1);
+    }
 
-    string backupScript = script.GetBackupScript();
+    /// batch mode: one mod file name per line
+    ifstream modList(args[0]);
+    if (!modList.good())
+    {
+        cerr << "Can't open mod list: " << args[0] << endl;
+        return 1;
+    }
+    vector<string> modNames;
+    string line;
+    while (getline(modList, line))
+    {
+        line = Trim(line);
+        if (line != "" && line.substr(0, 2) != "//")
+            modNames.push_back(line);
+    }
 
-    if (string(argV[1]).find(".uninstall") == string::npos && backupScript != "")
+    if (numThreads > 1)
     {
-        unsigned i = 0;
-        string nextName = "";
-        do
-        {
-            nextName = string(argV[1]) + string(".uninstall") + int2fstr(i) + string(".txt");
-            ++i;
-        } while (FileExists(nextName));
+        cerr << "Mods are applied by a single thread in batch mode, /j switch is ignored." << endl;
+    }
 
-        ofstream uninstFile(nextName);
-        if (!uninstFile.good())
+    script.SetBatchMode(true);
+    unsigned numApplied = 0;
+    for (unsigned i = 0; i < modNames.size(); ++i)
+    {
+        cout << "Applying mod " << (i + 1) << " of " << modNames.size() << ": " << modNames[i] << endl;
+        if (ApplyMod(script, modNames[i], usePlan) == false)
         {
-            cerr << "Error saving uninstall script!" << endl;
-            return 1;
+            cerr << "Error applying mod: " << modNames[i] << endl;
+            break;
         }
-        uninstFile << "MOD_NAME=" << argV[1] << " uninstall script\n"
-                   << "AUTHOR=PatchUPK\n"
-                   << "DESCRIPTION=This is automatically generated uninstall script. Do not change anything!\n\n"
-                   << backupScript << "\n{ backup script end }\n";
-        cout << "Uninstall script saved to " << nextName << endl;
+        ++numApplied;
+    }
+    bool FlushResult = script.FlushPackages();
+
+    cout << "Mods applied: " << numApplied << " of " << modNames.size() << endl;
+    if (script.GetConflictsCount() > 0)
+    {
+        cerr << "Conflicting writes: " << script.GetConflictsCount() << endl;
     }
 
-    if (!ExecResult)
+    if (!FlushResult || numApplied != modNames.size())
         return 1;
 
     return 0;
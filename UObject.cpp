@@ -25,10 +25,11 @@ std::string UBulkDataMirror::Serialize()
     return ss.str();
 }
 
-std::string UDefaultPropertiesList::Deserialize(std::istream& stream, UPKInfo& info, UObjectReference owner, bool unsafe, bool quick)
+std::string UDefaultPropertiesList::Deserialize(std::istream& stream, UPKInfo& info, UObjectReference owner, bool unsafe, bool quick, bool text)
 {
     std::ostringstream ss;
-    ss << "UDefaultPropertiesList:\n";
+    if (text)
+        ss << "UDefaultPropertiesList:\n";
     PropertyOffset = stream.tellg();
     DefaultProperties.clear();
     size_t maxOffset = info.GetExportEntry(owner).SerialOffset + info.GetExportEntry(owner).SerialSize;
@@ -36,47 +37,52 @@ std::string UDefaultPropertiesList::Deserialize(std::istream& stream, UPKInfo& i
     do
     {
         Property = UDefaultProperty{};
-        ss << Property.Deserialize(stream, info, owner, unsafe, quick);
+        ss << Property.Deserialize(stream, info, owner, unsafe, quick, text);
         DefaultProperties.push_back(Property);
     } while (Property.GetName() != "None" && stream.good() && (size_t)stream.tellg() < maxOffset);
     PropertySize = (unsigned)stream.tellg() - (unsigned)PropertyOffset;
     return ss.str();
 }
 
-std::string UDefaultProperty::Deserialize(std::istream& stream, UPKInfo& info, UObjectReference owner, bool unsafe, bool quick)
+std::string UDefaultProperty::Deserialize(std::istream& stream, UPKInfo& info, UObjectReference owner, bool unsafe, bool quick, bool text)
 {
-    Init(owner, unsafe, quick);
+    Init(owner, unsafe, quick, text);
     size_t maxOffset = info.GetExportEntry(owner).SerialOffset + info.GetExportEntry(owner).SerialSize;
     std::ostringstream ss;
-    ss << "UDefaultProperty:\n";
     stream.read(reinterpret_cast<char*>(&NameIdx), sizeof(NameIdx));
     Name = info.IndexToName(NameIdx);
-    ss << "\tNameIdx: " << FormatHEX(NameIdx) << " -> " << info.IndexToName(NameIdx) << std::endl;
+    if (TextOutput)
+    {
+        ss << "UDefaultProperty:\n";
+        ss << "\tNameIdx: " << FormatHEX(NameIdx) << " -> " << Name << std::endl;
+    }
     if (Name != "None")
     {
         stream.read(reinterpret_cast<char*>(&TypeIdx), sizeof(TypeIdx));
-        ss << "\tTypeIdx: " << FormatHEX(TypeIdx) << " -> " << info.IndexToName(TypeIdx) << std::endl;
         stream.read(reinterpret_cast<char*>(&PropertySize), sizeof(PropertySize));
-        ss << "\tPropertySize: " << FormatHEX(PropertySize) << std::endl;
+        if (TextOutput)
+        {
+            ss << "\tTypeIdx: " << FormatHEX(TypeIdx) << " -> " << info.IndexToName(TypeIdx) << std::endl;
+            ss << "\tPropertySize: " << FormatHEX(PropertySize) << std::endl;
+        }
         /// prevent long loop, caused by bad data
         if ((int)stream.tellg() + (int)PropertySize > (int)maxOffset)
             return ss.str();
         stream.read(reinterpret_cast<char*>(&ArrayIdx), sizeof(ArrayIdx));
-        ss << "\tArrayIdx: " << FormatHEX(ArrayIdx) << std::endl;
+        if (TextOutput)
+            ss << "\tArrayIdx: " << FormatHEX(ArrayIdx) << std::endl;
         Type = info.IndexToName(TypeIdx);
         if (Type == "BoolProperty")
         {
             stream.read(reinterpret_cast<char*>(&BoolValue), sizeof(BoolValue));
-            ss << "\tBoolean value: " << FormatHEX(BoolValue) << " = ";
-            if (BoolValue == 0)
-                ss << "false\n";
-            else
-                ss << "true\n";
+            if (TextOutput)
+                ss << "\tBoolean value: " << FormatHEX(BoolValue) << " = " << (BoolValue == 0 ? "false\n" : "true\n");
         }
         if (Type == "StructProperty" || Type == "ByteProperty")
         {
             stream.read(reinterpret_cast<char*>(&InnerNameIdx), sizeof(InnerNameIdx));
-            ss << "\tInnerNameIdx: " << FormatHEX(InnerNameIdx) << " -> " << info.IndexToName(InnerNameIdx) << std::endl;
+            if (TextOutput)
+                ss << "\tInnerNameIdx: " << FormatHEX(InnerNameIdx) << " -> " << info.IndexToName(InnerNameIdx) << std::endl;
             if (Type == "StructProperty")
                 Type = info.IndexToName(InnerNameIdx);
         }
@@ -86,7 +92,8 @@ std::string UDefaultProperty::Deserialize(std::istream& stream, UPKInfo& info, U
             InnerValue.resize(PropertySize);
             stream.read(InnerValue.data(), InnerValue.size());
             size_t offset2 = stream.tellg();
-            if (QuickMode == false)
+            /// value is kept in InnerValue, DeserializeValue only formats it
+            if (QuickMode == false && TextOutput == true)
             {
                 stream.seekg(offset);
                 ss << DeserializeValue(stream, info);
@@ -322,33 +329,38 @@ std::string UDefaultProperty::FindArrayType(std::string ArrName, std::istream& s
 {
     if (OwnerRef <= 0)
         return "None";
-    FObjectExport OwnerEntry = info.GetExportEntry(OwnerRef);
-    std::string OwnerName = OwnerEntry.FullName;
-    size_t pos = OwnerName.find("Default__");
-    if (pos != std::string::npos)
-    {
-        OwnerName = OwnerName.substr(pos + 9);
-    }
-    std::string FullName = OwnerName + "." + ArrName;
+    /// inner types are resolved once per package for each owner and array name
+    std::string InnerType;
+    if (info.FindArrayInnerType(OwnerRef, ArrName, InnerType))
+        return InnerType;
+    InnerType = ResolveArrayType(ArrName, stream, info);
+    info.AddArrayInnerType(OwnerRef, ArrName, InnerType);
+    return InnerType;
+}
+
+std::string UDefaultProperty::ResolveArrayType(const std::string& ArrName, std::istream& stream, UPKInfo& info)
+{
+    const std::string& OwnerFullName = info.GetExportEntry(OwnerRef).FullName;
+    size_t pos = OwnerFullName.find("Default__");
+    std::string FullName = (pos != std::string::npos ? OwnerFullName.substr(pos + 9) : OwnerFullName) + "." + ArrName;
     UObjectReference ObjRef = info.FindObject(FullName);
     if (ObjRef <= 0)
         return "None";
-    FObjectExport ArrayEntry = info.GetExportEntry(ObjRef);
+    const FObjectExport& ArrayEntry = info.GetExportEntry(ObjRef);
     if (ArrayEntry.Type == "ArrayProperty")
     {
         UArrayProperty ArrProperty;
         size_t StreamPos = stream.tellg();
         stream.seekg(ArrayEntry.SerialOffset);
-        /// quick-deserialize property, as we need only it's inner type info
+        /// quick-decode property, as we need only it's inner type info
         ArrProperty.SetRef(ObjRef);
         ArrProperty.SetUnsafe(false);
         ArrProperty.SetQuickMode(true);
-        ArrProperty.Deserialize(stream, info);
+        ArrProperty.Decode(stream, info);
         stream.seekg(StreamPos);
         if (ArrProperty.GetInner() <= 0)
             return "None";
-        FObjectExport InnerEntry = info.GetExportEntry(ArrProperty.GetInner());
-        return InnerEntry.Type;
+        return info.GetExportEntry(ArrProperty.GetInner()).Type;
     }
     return "None";
 }
@@ -378,21 +390,65 @@ std::string UDefaultProperty::GuessArrayType(std::string ArrName)
     return "None";
 }
 
+template<typename T>
+static void ReadArray(std::istream& stream, uint32_t NumElements, std::vector<T>& Array)
+{
+    Array.resize(NumElements);
+    if (NumElements > 0)
+        stream.read(reinterpret_cast<char*>(Array.data()), NumElements * sizeof(T));
+}
+
+static std::string FormatNameArray(const char* ArrName, const std::vector<UNameIndex>& Array, UPKInfo& info)
+{
+    std::ostringstream ss;
+    for (unsigned i = 0; i < Array.size(); ++i)
+    {
+        ss << "\t" << ArrName << "[" << i << "]:\n";
+        ss << "\t\t" << FormatHEX(Array[i]) << " -> " << info.IndexToName(Array[i]) << std::endl;
+    }
+    return ss.str();
+}
+
+static std::string FormatNameMap(const char* ArrName, const std::vector<std::pair<UNameIndex, UObjectReference>>& Array, UPKInfo& info)
+{
+    std::ostringstream ss;
+    for (unsigned i = 0; i < Array.size(); ++i)
+    {
+        ss << "\t" << ArrName << "[" << i << "]:\n";
+        ss << "\t\t" << FormatHEX(Array[i].first) << " -> " << info.IndexToName(Array[i].first) << std::endl;
+        ss << "\t\t" << FormatHEX((uint32_t)Array[i].second) << " -> " << info.ObjRefToName(Array[i].second) << std::endl;
+    }
+    return ss.str();
+}
+
+bool UObject::Decode(std::istream& stream, UPKInfo& info)
+{
+    bool OldTextOutput = TextOutput;
+    TextOutput = false;
+    Deserialize(stream, info);
+    TextOutput = OldTextOutput;
+    return !stream.fail();
+}
+
 std::string UObject::Deserialize(std::istream& stream, UPKInfo& info)
 {
     std::ostringstream ss;
-    ss << "UObject:\n";
     stream.read(reinterpret_cast<char*>(&ObjRef), sizeof(ObjRef));
-    ss << "\tPrevObjRef = " << FormatHEX((uint32_t)ObjRef) << " -> " << info.ObjRefToName(ObjRef) << std::endl;
+    if (TextOutput)
+    {
+        ss << "UObject:\n";
+        ss << "\tPrevObjRef = " << FormatHEX((uint32_t)ObjRef) << " -> " << info.ObjRefToName(ObjRef) << std::endl;
+    }
     if (Type != GlobalType::UClass)
     {
         FObjectExport ThisTableEntry = info.GetExportEntry(ThisRef);
         if (TryUnsafe == true && ThisRef > 0 && (ThisTableEntry.ObjectFlagsL & (uint32_t)UObjectFlagsL::HasStack))
         {
             stream.seekg(22, std::ios::cur);
-            ss << "Can't deserialize stack: skipping!\n";
+            if (TextOutput)
+                ss << "Can't deserialize stack: skipping!\n";
         }
-        ss << DefaultProperties.Deserialize(stream, info, ThisRef, TryUnsafe, QuickMode);
+        ss << DefaultProperties.Deserialize(stream, info, ThisRef, TryUnsafe, QuickMode, TextOutput);
     }
     return ss.str();
 }
@@ -404,16 +460,20 @@ std::string UField::Deserialize(std::istream& stream, UPKInfo& info)
     /// check for bad data
     if ((unsigned)stream.tellg() > info.GetExportEntry(ThisRef).SerialOffset + info.GetExportEntry(ThisRef).SerialSize)
         return ss.str();
-    ss << "UField:\n";
     FieldOffset = NextRefOffset = stream.tellg();
     stream.read(reinterpret_cast<char*>(&NextRef), sizeof(NextRef));
-    ss << "\tNextRef = " << FormatHEX((uint32_t)NextRef) << " -> " << info.ObjRefToName(NextRef) << std::endl;
     if (IsStructure())
     {
         stream.read(reinterpret_cast<char*>(&ParentRef), sizeof(ParentRef));
-        ss << "\tParentRef = " << FormatHEX((uint32_t)ParentRef) << " -> " << info.ObjRefToName(ParentRef) << std::endl;
     }
     FieldSize = (unsigned)stream.tellg() - (unsigned)FieldOffset;
+    if (TextOutput)
+    {
+        ss << "UField:\n";
+        ss << "\tNextRef = " << FormatHEX((uint32_t)NextRef) << " -> " << info.ObjRefToName(NextRef) << std::endl;
+        if (IsStructure())
+            ss << "\tParentRef = " << FormatHEX((uint32_t)ParentRef) << " -> " << info.ObjRefToName(ParentRef) << std::endl;
+    }
     return ss.str();
 }
 
@@ -424,30 +484,34 @@ std::string UStruct::Deserialize(std::istream& stream, UPKInfo& info)
     /// check for bad data
     if ((unsigned)stream.tellg() > info.GetExportEntry(ThisRef).SerialOffset + info.GetExportEntry(ThisRef).SerialSize)
         return ss.str();
-    ss << "UStruct:\n";
     StructOffset = stream.tellg();
     stream.read(reinterpret_cast<char*>(&ScriptTextRef), sizeof(ScriptTextRef));
-    ss << "\tScriptTextRef = " << FormatHEX((uint32_t)ScriptTextRef) << " -> " << info.ObjRefToName(ScriptTextRef) << std::endl;
     FirstChildRefOffset = stream.tellg();
     stream.read(reinterpret_cast<char*>(&FirstChildRef), sizeof(FirstChildRef));
-    ss << "\tFirstChildRef = " << FormatHEX((uint32_t)FirstChildRef) << " -> " << info.ObjRefToName(FirstChildRef) << std::endl;
     stream.read(reinterpret_cast<char*>(&CppTextRef), sizeof(CppTextRef));
-    ss << "\tCppTextRef = " << FormatHEX((uint32_t)CppTextRef) << " -> " << info.ObjRefToName(CppTextRef) << std::endl;
     stream.read(reinterpret_cast<char*>(&Line), sizeof(Line));
-    ss << "\tLine = " << FormatHEX(Line) << std::endl;
     stream.read(reinterpret_cast<char*>(&TextPos), sizeof(TextPos));
-    ss << "\tTextPos = " << FormatHEX(TextPos) << std::endl;
     stream.read(reinterpret_cast<char*>(&ScriptMemorySize), sizeof(ScriptMemorySize));
-    ss << "\tScriptMemorySize = " << FormatHEX(ScriptMemorySize) << std::endl;
     stream.read(reinterpret_cast<char*>(&ScriptSerialSize), sizeof(ScriptSerialSize));
-    ss << "\tScriptSerialSize = " << FormatHEX(ScriptSerialSize) << std::endl;
+    if (TextOutput)
+    {
+        ss << "UStruct:\n";
+        ss << "\tScriptTextRef = " << FormatHEX((uint32_t)ScriptTextRef) << " -> " << info.ObjRefToName(ScriptTextRef) << std::endl;
+        ss << "\tFirstChildRef = " << FormatHEX((uint32_t)FirstChildRef) << " -> " << info.ObjRefToName(FirstChildRef) << std::endl;
+        ss << "\tCppTextRef = " << FormatHEX((uint32_t)CppTextRef) << " -> " << info.ObjRefToName(CppTextRef) << std::endl;
+        ss << "\tLine = " << FormatHEX(Line) << std::endl;
+        ss << "\tTextPos = " << FormatHEX(TextPos) << std::endl;
+        ss << "\tScriptMemorySize = " << FormatHEX(ScriptMemorySize) << std::endl;
+        ss << "\tScriptSerialSize = " << FormatHEX(ScriptSerialSize) << std::endl;
+    }
     /// prevent allocation errors, caused by bad data
     if ((unsigned)stream.tellg() > info.GetExportEntry(ThisRef).SerialOffset + info.GetExportEntry(ThisRef).SerialSize)
         return ss.str();
     DataScript.resize(ScriptSerialSize);
     ScriptOffset = stream.tellg();
     stream.read(DataScript.data(), DataScript.size());
-    ss << "\tScript decompiler is not implemented!\n";
+    if (TextOutput)
+        ss << "\tScript decompiler is not implemented!\n";
     StructSize = (unsigned)stream.tellg() - (unsigned)StructOffset;
     return ss.str();
 }
@@ -459,24 +523,28 @@ std::string UFunction::Deserialize(std::istream& stream, UPKInfo& info)
     /// check for bad data
     if ((unsigned)stream.tellg() > info.GetExportEntry(ThisRef).SerialOffset + info.GetExportEntry(ThisRef).SerialSize)
         return ss.str();
-    ss << "UFunction:\n";
     FunctionOffset = stream.tellg();
     stream.read(reinterpret_cast<char*>(&NativeToken), sizeof(NativeToken));
-    ss << "\tNativeToken = " << FormatHEX(NativeToken) << std::endl;
     stream.read(reinterpret_cast<char*>(&OperPrecedence), sizeof(OperPrecedence));
-    ss << "\tOperPrecedence = " << FormatHEX(OperPrecedence) << std::endl;
     FlagsOffset = stream.tellg();
     stream.read(reinterpret_cast<char*>(&FunctionFlags), sizeof(FunctionFlags));
-    ss << "\tFunctionFlags = " << FormatHEX(FunctionFlags) << std::endl;
-    ss << FormatFunctionFlags(FunctionFlags);
     if (FunctionFlags & (uint32_t)UFunctionFlags::Net)
     {
         stream.read(reinterpret_cast<char*>(&RepOffset), sizeof(RepOffset));
-        ss << "\tRepOffset = " << FormatHEX(RepOffset) << std::endl;
     }
     stream.read(reinterpret_cast<char*>(&NameIdx), sizeof(NameIdx));
-    ss << "\tNameIdx = " << FormatHEX(NameIdx) << " -> " << info.IndexToName(NameIdx) << std::endl;
     FunctionSize = (unsigned)stream.tellg() - (unsigned)FunctionOffset;
+    if (TextOutput)
+    {
+        ss << "UFunction:\n";
+        ss << "\tNativeToken = " << FormatHEX(NativeToken) << std::endl;
+        ss << "\tOperPrecedence = " << FormatHEX(OperPrecedence) << std::endl;
+        ss << "\tFunctionFlags = " << FormatHEX(FunctionFlags) << std::endl;
+        ss << FormatFunctionFlags(FunctionFlags);
+        if (FunctionFlags & (uint32_t)UFunctionFlags::Net)
+            ss << "\tRepOffset = " << FormatHEX(RepOffset) << std::endl;
+        ss << "\tNameIdx = " << FormatHEX(NameIdx) << " -> " << info.IndexToName(NameIdx) << std::endl;
+    }
     return ss.str();
 }
 
@@ -487,13 +555,16 @@ std::string UScriptStruct::Deserialize(std::istream& stream, UPKInfo& info)
     /// check for bad data
     if ((unsigned)stream.tellg() > info.GetExportEntry(ThisRef).SerialOffset + info.GetExportEntry(ThisRef).SerialSize)
         return ss.str();
-    ss << "UScriptStruct:\n";
     ScriptStructOffset = stream.tellg();
     FlagsOffset = stream.tellg();
     stream.read(reinterpret_cast<char*>(&StructFlags), sizeof(StructFlags));
-    ss << "\tStructFlags = " << FormatHEX(StructFlags) << std::endl;
-    ss << FormatStructFlags(StructFlags);
-    ss << StructDefaultProperties.Deserialize(stream, info, ThisRef, TryUnsafe, QuickMode);
+    if (TextOutput)
+    {
+        ss << "UScriptStruct:\n";
+        ss << "\tStructFlags = " << FormatHEX(StructFlags) << std::endl;
+        ss << FormatStructFlags(StructFlags);
+    }
+    ss << StructDefaultProperties.Deserialize(stream, info, ThisRef, TryUnsafe, QuickMode, TextOutput);
     ScriptStructSize = (unsigned)stream.tellg() - (unsigned)ScriptStructOffset;
     return ss.str();
 }
@@ -505,30 +576,27 @@ std::string UState::Deserialize(std::istream& stream, UPKInfo& info)
     /// check for bad data
     if ((unsigned)stream.tellg() > info.GetExportEntry(ThisRef).SerialOffset + info.GetExportEntry(ThisRef).SerialSize)
         return ss.str();
-    ss << "UState:\n";
     StateOffset = stream.tellg();
     stream.read(reinterpret_cast<char*>(&ProbeMask), sizeof(ProbeMask));
-    ss << "\tProbeMask = " << FormatHEX(ProbeMask) << std::endl;
     stream.read(reinterpret_cast<char*>(&LabelTableOffset), sizeof(LabelTableOffset));
-    ss << "\tLabelTableOffset = " << FormatHEX(LabelTableOffset) << std::endl;
     FlagsOffset = stream.tellg();
     stream.read(reinterpret_cast<char*>(&StateFlags), sizeof(StateFlags));
-    ss << "\tStateFlags = " << FormatHEX(StateFlags) << std::endl;
-    ss << FormatStateFlags(StateFlags);
     stream.read(reinterpret_cast<char*>(&StateMapSize), sizeof(StateMapSize));
-    ss << "\tStateMapSize = " << FormatHEX(StateMapSize) << " (" << StateMapSize << ")" << std::endl;
+    if (TextOutput)
+    {
+        ss << "UState:\n";
+        ss << "\tProbeMask = " << FormatHEX(ProbeMask) << std::endl;
+        ss << "\tLabelTableOffset = " << FormatHEX(LabelTableOffset) << std::endl;
+        ss << "\tStateFlags = " << FormatHEX(StateFlags) << std::endl;
+        ss << FormatStateFlags(StateFlags);
+        ss << "\tStateMapSize = " << FormatHEX(StateMapSize) << " (" << StateMapSize << ")" << std::endl;
+    }
     StateMap.clear();
     if (StateMapSize > info.GetExportEntry(ThisRef).SerialSize) /// bad data malloc error prevention
         StateMapSize = 0;
-    for (unsigned i = 0; i < StateMapSize; ++i)
-    {
-        std::pair<UNameIndex, UObjectReference> MapElement;
-        stream.read(reinterpret_cast<char*>(&MapElement), sizeof(MapElement));
-        ss << "\tStateMap[" << i << "]:\n";
-        ss << "\t\t" << FormatHEX(MapElement.first) << " -> " << info.IndexToName(MapElement.first) << std::endl;
-        ss << "\t\t" << FormatHEX((uint32_t)MapElement.second) << " -> " << info.ObjRefToName(MapElement.second) << std::endl;
-        StateMap.push_back(MapElement);
-    }
+    ReadArray(stream, StateMapSize, StateMap);
+    if (TextOutput)
+        ss << FormatNameMap("StateMap", StateMap, info);
     StateSize = (unsigned)stream.tellg() - (unsigned)StateOffset;
     return ss.str();
 }
@@ -540,123 +608,102 @@ std::string UClass::Deserialize(std::istream& stream, UPKInfo& info)
     /// check for bad data
     if ((unsigned)stream.tellg() > info.GetExportEntry(ThisRef).SerialOffset + info.GetExportEntry(ThisRef).SerialSize)
         return ss.str();
-    ss << "UClass:\n";
     FlagsOffset = stream.tellg();
     stream.read(reinterpret_cast<char*>(&ClassFlags), sizeof(ClassFlags));
-    ss << "\tClassFlags = " << FormatHEX(ClassFlags) << std::endl;
-    ss << FormatClassFlags(ClassFlags);
     stream.read(reinterpret_cast<char*>(&WithinRef), sizeof(WithinRef));
-    ss << "\tWithinRef = " << FormatHEX((uint32_t)WithinRef) << " -> " << info.ObjRefToName(WithinRef) << std::endl;
     stream.read(reinterpret_cast<char*>(&ConfigNameIdx), sizeof(ConfigNameIdx));
-    ss << "\tConfigNameIdx = " << FormatHEX(ConfigNameIdx) << " -> " << info.IndexToName(ConfigNameIdx) << std::endl;
     stream.read(reinterpret_cast<char*>(&NumComponents), sizeof(NumComponents));
-    ss << "\tNumComponents = " << FormatHEX(NumComponents) << " (" << NumComponents << ")" << std::endl;
-    Components.clear();
-    if (NumComponents > info.GetExportEntry(ThisRef).SerialSize) /// bad data malloc error prevention
-        NumComponents = 0;
-    for (unsigned i = 0; i < NumComponents; ++i)
+    if (TextOutput)
     {
-        std::pair<UNameIndex, UObjectReference> MapElement;
-        stream.read(reinterpret_cast<char*>(&MapElement), sizeof(MapElement));
-        ss << "\tComponents[" << i << "]:\n";
-        ss << "\t\t" << FormatHEX(MapElement.first) << " -> " << info.IndexToName(MapElement.first) << std::endl;
-        ss << "\t\t" << FormatHEX((uint32_t)MapElement.second) << " -> " << info.ObjRefToName(MapElement.second) << std::endl;
-        Components.push_back(MapElement);
+        ss << "UClass:\n";
+        ss << "\tClassFlags = " << FormatHEX(ClassFlags) << std::endl;
+        ss << FormatClassFlags(ClassFlags);
+        ss << "\tWithinRef = " << FormatHEX((uint32_t)WithinRef) << " -> " << info.ObjRefToName(WithinRef) << std::endl;
+        ss << "\tConfigNameIdx = " << FormatHEX(ConfigNameIdx) << " -> " << info.IndexToName(ConfigNameIdx) << std::endl;
+        ss << "\tNumComponents = " << FormatHEX(NumComponents) << " (" << NumComponents << ")" << std::endl;
     }
+    if (NumComponents > info.GetExportEntry(ThisRef).SerialSize) /// bad data malloc error prevention
+        NumComponents = 0;
+    ReadArray(stream, NumComponents, Components);
+    if (TextOutput)
+        ss << FormatNameMap("Components", Components, info);
     stream.read(reinterpret_cast<char*>(&NumInterfaces), sizeof(NumInterfaces));
-    ss << "\tNumInterfaces = " << FormatHEX(NumInterfaces) << " (" << NumInterfaces << ")" << std::endl;
-    Interfaces.clear();
+    if (TextOutput)
+        ss << "\tNumInterfaces = " << FormatHEX(NumInterfaces) << " (" << NumInterfaces << ")" << std::endl;
     if (NumInterfaces > info.GetExportEntry(ThisRef).SerialSize) /// bad data malloc error prevention
         NumInterfaces = 0;
-    for (unsigned i = 0; i < NumInterfaces; ++i)
+    ReadArray(stream, NumInterfaces, Interfaces);
+    if (TextOutput)
     {
-        std::pair<UObjectReference, uint32_t> MapElement;
-        stream.read(reinterpret_cast<char*>(&MapElement), sizeof(MapElement));
-        ss << "\tInterfaces[" << i << "]:\n";
-        ss << "\t\t" << FormatHEX((uint32_t)MapElement.first) << " -> " << info.ObjRefToName(MapElement.first) << std::endl;
-        ss << "\t\t" << FormatHEX(MapElement.second) << std::endl;
-        Interfaces.push_back(MapElement);
+        for (unsigned i = 0; i < Interfaces.size(); ++i)
+        {
+            ss << "\tInterfaces[" << i << "]:\n";
+            ss << "\t\t" << FormatHEX((uint32_t)Interfaces[i].first) << " -> " << info.ObjRefToName(Interfaces[i].first) << std::endl;
+            ss << "\t\t" << FormatHEX(Interfaces[i].second) << std::endl;
+        }
     }
     stream.read(reinterpret_cast<char*>(&NumDontSortCategories), sizeof(NumDontSortCategories));
-    ss << "\tNumDontSortCategories = " << FormatHEX(NumDontSortCategories) << " (" << NumDontSortCategories << ")" << std::endl;
-    DontSortCategories.clear();
+    if (TextOutput)
+        ss << "\tNumDontSortCategories = " << FormatHEX(NumDontSortCategories) << " (" << NumDontSortCategories << ")" << std::endl;
     if (NumDontSortCategories > info.GetExportEntry(ThisRef).SerialSize) /// bad data malloc error prevention
         NumDontSortCategories = 0;
-    for (unsigned i = 0; i < NumDontSortCategories; ++i)
-    {
-        UNameIndex Element;
-        stream.read(reinterpret_cast<char*>(&Element), sizeof(Element));
-        ss << "\tDontSortCategories[" << i << "]:\n";
-        ss << "\t\t" << FormatHEX(Element) << " -> " << info.IndexToName(Element) << std::endl;
-        DontSortCategories.push_back(Element);
-    }
+    ReadArray(stream, NumDontSortCategories, DontSortCategories);
+    if (TextOutput)
+        ss << FormatNameArray("DontSortCategories", DontSortCategories, info);
     stream.read(reinterpret_cast<char*>(&NumHideCategories), sizeof(NumHideCategories));
-    ss << "\tNumHideCategories = " << FormatHEX(NumHideCategories) << " (" << NumHideCategories << ")" << std::endl;
-    HideCategories.clear();
+    if (TextOutput)
+        ss << "\tNumHideCategories = " << FormatHEX(NumHideCategories) << " (" << NumHideCategories << ")" << std::endl;
     if (NumHideCategories > info.GetExportEntry(ThisRef).SerialSize) /// bad data malloc error prevention
         NumHideCategories = 0;
-    for (unsigned i = 0; i < NumHideCategories; ++i)
-    {
-        UNameIndex Element;
-        stream.read(reinterpret_cast<char*>(&Element), sizeof(Element));
-        ss << "\tHideCategories[" << i << "]:\n";
-        ss << "\t\t" << FormatHEX(Element) << " -> " << info.IndexToName(Element) << std::endl;
-        HideCategories.push_back(Element);
-    }
+    ReadArray(stream, NumHideCategories, HideCategories);
+    if (TextOutput)
+        ss << FormatNameArray("HideCategories", HideCategories, info);
     stream.read(reinterpret_cast<char*>(&NumAutoExpandCategories), sizeof(NumAutoExpandCategories));
-    ss << "\tNumAutoExpandCategories = " << FormatHEX(NumAutoExpandCategories) << " (" << NumAutoExpandCategories << ")" << std::endl;
-    AutoExpandCategories.clear();
+    if (TextOutput)
+        ss << "\tNumAutoExpandCategories = " << FormatHEX(NumAutoExpandCategories) << " (" << NumAutoExpandCategories << ")" << std::endl;
     if (NumAutoExpandCategories > info.GetExportEntry(ThisRef).SerialSize) /// bad data malloc error prevention
         NumAutoExpandCategories = 0;
-    for (unsigned i = 0; i < NumAutoExpandCategories; ++i)
-    {
-        UNameIndex Element;
-        stream.read(reinterpret_cast<char*>(&Element), sizeof(Element));
-        ss << "\tAutoExpandCategories[" << i << "]:\n";
-        ss << "\t\t" << FormatHEX(Element) << " -> " << info.IndexToName(Element) << std::endl;
-        AutoExpandCategories.push_back(Element);
-    }
+    ReadArray(stream, NumAutoExpandCategories, AutoExpandCategories);
+    if (TextOutput)
+        ss << FormatNameArray("AutoExpandCategories", AutoExpandCategories, info);
     stream.read(reinterpret_cast<char*>(&NumAutoCollapseCategories), sizeof(NumAutoCollapseCategories));
-    ss << "\tNumAutoCollapseCategories = " << FormatHEX(NumAutoCollapseCategories) << " (" << NumAutoCollapseCategories << ")" << std::endl;
-    AutoCollapseCategories.clear();
+    if (TextOutput)
+        ss << "\tNumAutoCollapseCategories = " << FormatHEX(NumAutoCollapseCategories) << " (" << NumAutoCollapseCategories << ")" << std::endl;
     if (NumAutoCollapseCategories > info.GetExportEntry(ThisRef).SerialSize) /// bad data malloc error prevention
         NumAutoCollapseCategories = 0;
-    for (unsigned i = 0; i < NumAutoCollapseCategories; ++i)
-    {
-        UNameIndex Element;
-        stream.read(reinterpret_cast<char*>(&Element), sizeof(Element));
-        ss << "\tAutoCollapseCategories[" << i << "]:\n";
-        ss << "\t\t" << FormatHEX(Element) << " -> " << info.IndexToName(Element) << std::endl;
-        AutoCollapseCategories.push_back(Element);
-    }
+    ReadArray(stream, NumAutoCollapseCategories, AutoCollapseCategories);
+    if (TextOutput)
+        ss << FormatNameArray("AutoCollapseCategories", AutoCollapseCategories, info);
     stream.read(reinterpret_cast<char*>(&ForceScriptOrder), sizeof(ForceScriptOrder));
-    ss << "\tForceScriptOrder = " << FormatHEX(ForceScriptOrder) << std::endl;
     stream.read(reinterpret_cast<char*>(&NumClassGroups), sizeof(NumClassGroups));
-    ss << "\tNumClassGroups = " << FormatHEX(NumClassGroups) << " (" << NumClassGroups << ")" << std::endl;
-    ClassGroups.clear();
-    if (NumClassGroups > info.GetExportEntry(ThisRef).SerialSize) /// bad data malloc error prevention
-        NumClassGroups = 0;
-    for (unsigned i = 0; i < NumClassGroups; ++i)
+    if (TextOutput)
     {
-        UNameIndex Element;
-        stream.read(reinterpret_cast<char*>(&Element), sizeof(Element));
-        ss << "\tClassGroups[" << i << "]:\n";
-        ss << "\t\t" << FormatHEX(Element) << " -> " << info.IndexToName(Element) << std::endl;
-        ClassGroups.push_back(Element);
+        ss << "\tForceScriptOrder = " << FormatHEX(ForceScriptOrder) << std::endl;
+        ss << "\tNumClassGroups = " << FormatHEX(NumClassGroups) << " (" << NumClassGroups << ")" << std::endl;
     }
+    if (NumClassGroups > info.GetExportEntry(ThisRef).SerialSize) /// bad data malloc error prevention
+        NumClassGroups = 0;
+    ReadArray(stream, NumClassGroups, ClassGroups);
+    if (TextOutput)
+        ss << FormatNameArray("ClassGroups", ClassGroups, info);
     stream.read(reinterpret_cast<char*>(&NativeClassNameLength), sizeof(NativeClassNameLength));
-    ss << "\tNativeClassNameLength = " << FormatHEX(NativeClassNameLength) << std::endl;
+    if (TextOutput)
+        ss << "\tNativeClassNameLength = " << FormatHEX(NativeClassNameLength) << std::endl;
     if (NativeClassNameLength > info.GetExportEntry(ThisRef).SerialSize) /// bad data malloc error prevention
         NativeClassNameLength = 0;
     if (NativeClassNameLength > 0)
     {
         getline(stream, NativeClassName, '\0');
-        ss << "\tNativeClassName = " << NativeClassName << std::endl;
+        if (TextOutput)
+            ss << "\tNativeClassName = " << NativeClassName << std::endl;
     }
     stream.read(reinterpret_cast<char*>(&DLLBindName), sizeof(DLLBindName));
-    ss << "\tDLLBindName = " << FormatHEX(DLLBindName) << " -> " << info.IndexToName(DLLBindName) << std::endl;
     stream.read(reinterpret_cast<char*>(&DefaultRef), sizeof(DefaultRef));
-    ss << "\tDefaultRef = " << FormatHEX((uint32_t)DefaultRef) << " -> " << info.ObjRefToName(DefaultRef) << std::endl;
+    if (TextOutput)
+    {
+        ss << "\tDLLBindName = " << FormatHEX(DLLBindName) << " -> " << info.IndexToName(DLLBindName) << std::endl;
+        ss << "\tDefaultRef = " << FormatHEX((uint32_t)DefaultRef) << " -> " << info.ObjRefToName(DefaultRef) << std::endl;
+    }
     return ss.str();
 }
 
@@ -667,13 +714,17 @@ std::string UConst::Deserialize(std::istream& stream, UPKInfo& info)
     /// check for bad data
     if ((unsigned)stream.tellg() > info.GetExportEntry(ThisRef).SerialOffset + info.GetExportEntry(ThisRef).SerialSize)
         return ss.str();
-    ss << "UConst:\n";
     stream.read(reinterpret_cast<char*>(&ValueLength), sizeof(ValueLength));
-    ss << "\tValueLength = " << FormatHEX(ValueLength) << std::endl;
     if (ValueLength > 0)
     {
         getline(stream, Value, '\0');
-        ss << "\tValue = " << Value << std::endl;
+    }
+    if (TextOutput)
+    {
+        ss << "UConst:\n";
+        ss << "\tValueLength = " << FormatHEX(ValueLength) << std::endl;
+        if (ValueLength > 0)
+            ss << "\tValue = " << Value << std::endl;
     }
     return ss.str();
 }
@@ -685,18 +736,21 @@ std::string UEnum::Deserialize(std::istream& stream, UPKInfo& info)
     /// check for bad data
     if ((unsigned)stream.tellg() > info.GetExportEntry(ThisRef).SerialOffset + info.GetExportEntry(ThisRef).SerialSize)
         return ss.str();
-    ss << "UEnum:\n";
     stream.read(reinterpret_cast<char*>(&NumNames), sizeof(NumNames));
-    ss << "\tNumNames = " << FormatHEX(NumNames) << " (" << NumNames << ")" << std::endl;
+    if (TextOutput)
+    {
+        ss << "UEnum:\n";
+        ss << "\tNumNames = " << FormatHEX(NumNames) << " (" << NumNames << ")" << std::endl;
+    }
     Names.clear();
     for (unsigned i = 0; i < NumNames; ++i)
     {
         UNameIndex Element;
         stream.read(reinterpret_cast<char*>(&Element), sizeof(Element));
-        ss << "\tNames[" << i << "]:\n";
-        ss << "\t\t" << FormatHEX(Element) << " -> " << info.IndexToName(Element) << std::endl;
         Names.push_back(Element);
     }
+    if (TextOutput)
+        ss << FormatNameArray("Names", Names, info);
     return ss.str();
 }
 
@@ -707,28 +761,32 @@ std::string UProperty::Deserialize(std::istream& stream, UPKInfo& info)
     /// check for bad data
     if ((unsigned)stream.tellg() > info.GetExportEntry(ThisRef).SerialOffset + info.GetExportEntry(ThisRef).SerialSize)
         return ss.str();
-    ss << "UProperty:\n";
     uint32_t tmpVal;
     stream.read(reinterpret_cast<char*>(&tmpVal), sizeof(tmpVal));
     ArrayDim = tmpVal % (1 << 16);
     ElementSize = tmpVal >> 16;
-    ss << "\tArrayDim = " << FormatHEX(ArrayDim) << " (" << ArrayDim << ")" << std::endl;
-    ss << "\tElementSize = " << FormatHEX(ElementSize) << " (" << ElementSize << ")" << std::endl;
     FlagsOffset = stream.tellg();
     stream.read(reinterpret_cast<char*>(&PropertyFlagsL), sizeof(PropertyFlagsL));
-    ss << "\tPropertyFlagsL = " << FormatHEX(PropertyFlagsL) << std::endl;
-    ss << FormatPropertyFlagsL(PropertyFlagsL);
     stream.read(reinterpret_cast<char*>(&PropertyFlagsH), sizeof(PropertyFlagsH));
-    ss << "\tPropertyFlagsH = " << FormatHEX(PropertyFlagsH) << std::endl;
-    ss << FormatPropertyFlagsH(PropertyFlagsH);
     stream.read(reinterpret_cast<char*>(&CategoryIndex), sizeof(CategoryIndex));
-    ss << "\tCategoryIndex = " << FormatHEX(CategoryIndex) << " -> " << info.IndexToName(CategoryIndex) << std::endl;
     stream.read(reinterpret_cast<char*>(&ArrayEnumRef), sizeof(ArrayEnumRef));
-    ss << "\tArrayEnumRef = " << FormatHEX((uint32_t)ArrayEnumRef) << " -> " << info.ObjRefToName(ArrayEnumRef) << std::endl;
     if (PropertyFlagsL & (uint32_t)UPropertyFlagsL::Net)
     {
         stream.read(reinterpret_cast<char*>(&RepOffset), sizeof(RepOffset));
-        ss << "\tRepOffset = " << FormatHEX(RepOffset) << std::endl;
+    }
+    if (TextOutput)
+    {
+        ss << "UProperty:\n";
+        ss << "\tArrayDim = " << FormatHEX(ArrayDim) << " (" << ArrayDim << ")" << std::endl;
+        ss << "\tElementSize = " << FormatHEX(ElementSize) << " (" << ElementSize << ")" << std::endl;
+        ss << "\tPropertyFlagsL = " << FormatHEX(PropertyFlagsL) << std::endl;
+        ss << FormatPropertyFlagsL(PropertyFlagsL);
+        ss << "\tPropertyFlagsH = " << FormatHEX(PropertyFlagsH) << std::endl;
+        ss << FormatPropertyFlagsH(PropertyFlagsH);
+        ss << "\tCategoryIndex = " << FormatHEX(CategoryIndex) << " -> " << info.IndexToName(CategoryIndex) << std::endl;
+        ss << "\tArrayEnumRef = " << FormatHEX((uint32_t)ArrayEnumRef) << " -> " << info.ObjRefToName(ArrayEnumRef) << std::endl;
+        if (PropertyFlagsL & (uint32_t)UPropertyFlagsL::Net)
+            ss << "\tRepOffset = " << FormatHEX(RepOffset) << std::endl;
     }
     return ss.str();
 }
@@ -740,9 +798,12 @@ std::string UByteProperty::Deserialize(std::istream& stream, UPKInfo& info)
     /// check for bad data
     if ((unsigned)stream.tellg() > info.GetExportEntry(ThisRef).SerialOffset + info.GetExportEntry(ThisRef).SerialSize)
         return ss.str();
-    ss << "UByteProperty:\n";
     stream.read(reinterpret_cast<char*>(&EnumObjRef), sizeof(EnumObjRef));
-    ss << "\tEnumObjRef = " << FormatHEX((uint32_t)EnumObjRef) << " -> " << info.ObjRefToName(EnumObjRef) << std::endl;
+    if (TextOutput)
+    {
+        ss << "UByteProperty:\n";
+        ss << "\tEnumObjRef = " << FormatHEX((uint32_t)EnumObjRef) << " -> " << info.ObjRefToName(EnumObjRef) << std::endl;
+    }
     return ss.str();
 }
 
@@ -753,9 +814,12 @@ std::string UObjectProperty::Deserialize(std::istream& stream, UPKInfo& info)
     /// check for bad data
     if ((unsigned)stream.tellg() > info.GetExportEntry(ThisRef).SerialOffset + info.GetExportEntry(ThisRef).SerialSize)
         return ss.str();
-    ss << "UObjectProperty:\n";
     stream.read(reinterpret_cast<char*>(&OtherObjRef), sizeof(OtherObjRef));
-    ss << "\tOtherObjRef = " << FormatHEX((uint32_t)OtherObjRef) << " -> " << info.ObjRefToName(OtherObjRef) << std::endl;
+    if (TextOutput)
+    {
+        ss << "UObjectProperty:\n";
+        ss << "\tOtherObjRef = " << FormatHEX((uint32_t)OtherObjRef) << " -> " << info.ObjRefToName(OtherObjRef) << std::endl;
+    }
     return ss.str();
 }
 
@@ -766,9 +830,12 @@ std::string UClassProperty::Deserialize(std::istream& stream, UPKInfo& info)
     /// check for bad data
     if ((unsigned)stream.tellg() > info.GetExportEntry(ThisRef).SerialOffset + info.GetExportEntry(ThisRef).SerialSize)
         return ss.str();
-    ss << "UClassProperty:\n";
     stream.read(reinterpret_cast<char*>(&ClassObjRef), sizeof(ClassObjRef));
-    ss << "\tClassObjRef = " << FormatHEX((uint32_t)ClassObjRef) << " -> " << info.ObjRefToName(ClassObjRef) << std::endl;
+    if (TextOutput)
+    {
+        ss << "UClassProperty:\n";
+        ss << "\tClassObjRef = " << FormatHEX((uint32_t)ClassObjRef) << " -> " << info.ObjRefToName(ClassObjRef) << std::endl;
+    }
     return ss.str();
 }
 
@@ -779,9 +846,12 @@ std::string UStructProperty::Deserialize(std::istream& stream, UPKInfo& info)
     /// check for bad data
     if ((unsigned)stream.tellg() > info.GetExportEntry(ThisRef).SerialOffset + info.GetExportEntry(ThisRef).SerialSize)
         return ss.str();
-    ss << "UStructProperty:\n";
     stream.read(reinterpret_cast<char*>(&StructObjRef), sizeof(StructObjRef));
-    ss << "\tStructObjRef = " << FormatHEX((uint32_t)StructObjRef) << " -> " << info.ObjRefToName(StructObjRef) << std::endl;
+    if (TextOutput)
+    {
+        ss << "UStructProperty:\n";
+        ss << "\tStructObjRef = " << FormatHEX((uint32_t)StructObjRef) << " -> " << info.ObjRefToName(StructObjRef) << std::endl;
+    }
     return ss.str();
 }
 
@@ -792,11 +862,14 @@ std::string UFixedArrayProperty::Deserialize(std::istream& stream, UPKInfo& info
     /// check for bad data
     if ((unsigned)stream.tellg() > info.GetExportEntry(ThisRef).SerialOffset + info.GetExportEntry(ThisRef).SerialSize)
         return ss.str();
-    ss << "UFixedArrayProperty:\n";
     stream.read(reinterpret_cast<char*>(&InnerObjRef), sizeof(InnerObjRef));
-    ss << "\tInnerObjRef = " << FormatHEX((uint32_t)InnerObjRef) << " -> " << info.ObjRefToName(InnerObjRef) << std::endl;
     stream.read(reinterpret_cast<char*>(&Count), sizeof(Count));
-    ss << "\tCount = " << FormatHEX(Count) << " (" << Count << ")" << std::endl;
+    if (TextOutput)
+    {
+        ss << "UFixedArrayProperty:\n";
+        ss << "\tInnerObjRef = " << FormatHEX((uint32_t)InnerObjRef) << " -> " << info.ObjRefToName(InnerObjRef) << std::endl;
+        ss << "\tCount = " << FormatHEX(Count) << " (" << Count << ")" << std::endl;
+    }
     return ss.str();
 }
 
@@ -807,9 +880,12 @@ std::string UArrayProperty::Deserialize(std::istream& stream, UPKInfo& info)
     /// check for bad data
     if ((unsigned)stream.tellg() > info.GetExportEntry(ThisRef).SerialOffset + info.GetExportEntry(ThisRef).SerialSize)
         return ss.str();
-    ss << "UArrayProperty:\n";
     stream.read(reinterpret_cast<char*>(&InnerObjRef), sizeof(InnerObjRef));
-    ss << "\tInnerObjRef = " << FormatHEX((uint32_t)InnerObjRef) << " -> " << info.ObjRefToName(InnerObjRef) << std::endl;
+    if (TextOutput)
+    {
+        ss << "UArrayProperty:\n";
+        ss << "\tInnerObjRef = " << FormatHEX((uint32_t)InnerObjRef) << " -> " << info.ObjRefToName(InnerObjRef) << std::endl;
+    }
     return ss.str();
 }
 
@@ -820,11 +896,14 @@ std::string UDelegateProperty::Deserialize(std::istream& stream, UPKInfo& info)
     /// check for bad data
     if ((unsigned)stream.tellg() > info.GetExportEntry(ThisRef).SerialOffset + info.GetExportEntry(ThisRef).SerialSize)
         return ss.str();
-    ss << "UDelegateProperty:\n";
     stream.read(reinterpret_cast<char*>(&FunctionObjRef), sizeof(FunctionObjRef));
-    ss << "\tFunctionObjRef = " << FormatHEX((uint32_t)FunctionObjRef) << " -> " << info.ObjRefToName(FunctionObjRef) << std::endl;
     stream.read(reinterpret_cast<char*>(&DelegateObjRef), sizeof(DelegateObjRef));
-    ss << "\tDelegateObjRef = " << FormatHEX((uint32_t)DelegateObjRef) << " -> " << info.ObjRefToName(DelegateObjRef) << std::endl;
+    if (TextOutput)
+    {
+        ss << "UDelegateProperty:\n";
+        ss << "\tFunctionObjRef = " << FormatHEX((uint32_t)FunctionObjRef) << " -> " << info.ObjRefToName(FunctionObjRef) << std::endl;
+        ss << "\tDelegateObjRef = " << FormatHEX((uint32_t)DelegateObjRef) << " -> " << info.ObjRefToName(DelegateObjRef) << std::endl;
+    }
     return ss.str();
 }
 
@@ -835,9 +914,12 @@ std::string UInterfaceProperty::Deserialize(std::istream& stream, UPKInfo& info)
     /// check for bad data
     if ((unsigned)stream.tellg() > info.GetExportEntry(ThisRef).SerialOffset + info.GetExportEntry(ThisRef).SerialSize)
         return ss.str();
-    ss << "UInterfaceProperty:\n";
     stream.read(reinterpret_cast<char*>(&InterfaceObjRef), sizeof(InterfaceObjRef));
-    ss << "\tInterfaceObjRef = " << FormatHEX((uint32_t)InterfaceObjRef) << " -> " << info.ObjRefToName(InterfaceObjRef) << std::endl;
+    if (TextOutput)
+    {
+        ss << "UInterfaceProperty:\n";
+        ss << "\tInterfaceObjRef = " << FormatHEX((uint32_t)InterfaceObjRef) << " -> " << info.ObjRefToName(InterfaceObjRef) << std::endl;
+    }
     return ss.str();
 }
 
@@ -848,38 +930,49 @@ std::string UMapProperty::Deserialize(std::istream& stream, UPKInfo& info)
     /// check for bad data
     if ((unsigned)stream.tellg() > info.GetExportEntry(ThisRef).SerialOffset + info.GetExportEntry(ThisRef).SerialSize)
         return ss.str();
-    ss << "UMapProperty:\n";
     stream.read(reinterpret_cast<char*>(&KeyObjRef), sizeof(KeyObjRef));
-    ss << "\tKeyObjRef = " << FormatHEX((uint32_t)KeyObjRef) << " -> " << info.ObjRefToName(KeyObjRef) << std::endl;
     stream.read(reinterpret_cast<char*>(&ValueObjRef), sizeof(ValueObjRef));
-    ss << "\tValueObjRef = " << FormatHEX((uint32_t)ValueObjRef) << " -> " << info.ObjRefToName(ValueObjRef) << std::endl;
+    if (TextOutput)
+    {
+        ss << "UMapProperty:\n";
+        ss << "\tKeyObjRef = " << FormatHEX((uint32_t)KeyObjRef) << " -> " << info.ObjRefToName(KeyObjRef) << std::endl;
+        ss << "\tValueObjRef = " << FormatHEX((uint32_t)ValueObjRef) << " -> " << info.ObjRefToName(ValueObjRef) << std::endl;
+    }
     return ss.str();
 }
 
 std::string ULevel::Deserialize(std::istream& stream, UPKInfo& info)
 {
     std::ostringstream ss;
-    UObjectReference A;
+    UObjectReference LevelRef, WorldInfoRef;
     uint32_t NumActors;
     ss << UObject::Deserialize(stream, info);
-    uint32_t pos = ((unsigned)stream.tellg() - info.GetExportEntry(ThisRef).SerialOffset);
-    ss << "ULevel:\n";
-    stream.read(reinterpret_cast<char*>(&A), sizeof(A));
-    ss << "\tLevel object: " << FormatHEX((uint32_t)A) << " -> " << info.ObjRefToName(A) << std::endl;
+    stream.read(reinterpret_cast<char*>(&LevelRef), sizeof(LevelRef));
     stream.read(reinterpret_cast<char*>(&NumActors), sizeof(NumActors));
-    ss << "\tNum actors: " << FormatHEX(NumActors) << " = " << NumActors << std::endl;
-    stream.read(reinterpret_cast<char*>(&A), sizeof(A));
-    ss << "\tWorldInfo object: " << FormatHEX((uint32_t)A) << " -> " << info.ObjRefToName(A) << std::endl;
-    ss << "\tActors:\n";
+    stream.read(reinterpret_cast<char*>(&WorldInfoRef), sizeof(WorldInfoRef));
+    Actors.clear();
     for (unsigned i = 0; i < NumActors; ++i)
     {
+        UObjectReference A;
         stream.read(reinterpret_cast<char*>(&A), sizeof(A));
         Actors.push_back(A);
-        ss << "\t\t" << FormatHEX((char*)&A, sizeof(A)) << "\t//\t" << FormatHEX((uint32_t)A) << " -> " << info.ObjRefToName(A) << std::endl;
     }
-    pos = ((unsigned)stream.tellg() - info.GetExportEntry(ThisRef).SerialOffset);
-    ss << "Stream relative position (debug info): " << FormatHEX(pos) << " (" << pos << ")\n";
-    ss << "Object unknown, can't deserialize!\n";
+    if (TextOutput)
+    {
+        ss << "ULevel:\n";
+        ss << "\tLevel object: " << FormatHEX((uint32_t)LevelRef) << " -> " << info.ObjRefToName(LevelRef) << std::endl;
+        ss << "\tNum actors: " << FormatHEX(NumActors) << " = " << NumActors << std::endl;
+        ss << "\tWorldInfo object: " << FormatHEX((uint32_t)WorldInfoRef) << " -> " << info.ObjRefToName(WorldInfoRef) << std::endl;
+        ss << "\tActors:\n";
+        for (unsigned i = 0; i < Actors.size(); ++i)
+        {
+            UObjectReference A = Actors[i];
+            ss << "\t\t" << FormatHEX((char*)&A, sizeof(A)) << "\t//\t" << FormatHEX((uint32_t)A) << " -> " << info.ObjRefToName(A) << std::endl;
+        }
+        uint32_t pos = ((unsigned)stream.tellg() - info.GetExportEntry(ThisRef).SerialOffset);
+        ss << "Stream relative position (debug info): " << FormatHEX(pos) << " (" << pos << ")\n";
+        ss << "Object unknown, can't deserialize!\n";
+    }
     return ss.str();
 }
 
@@ -889,13 +982,15 @@ std::string UObjectUnknown::Deserialize(std::istream& stream, UPKInfo& info)
     /// prevent crashes while deserializing components
     if (info.GetExportEntry(ThisRef).Type.find("Component") != std::string::npos)
     {
-        ss << "Can't deserialize Components!\n";
+        if (TextOutput)
+            ss << "Can't deserialize Components!\n";
         return ss.str();
     }
     /// prevent crashes while deserializing FX_
     if (info.GetExportEntry(ThisRef).Type.find("BodySetup") != std::string::npos)
     {
-        ss << "Can't deserialize BodySetup!\n";
+        if (TextOutput)
+            ss << "Can't deserialize BodySetup!\n";
         return ss.str();
     }
     /// to be on a safe side: don't deserialize unknown objects
@@ -903,11 +998,15 @@ std::string UObjectUnknown::Deserialize(std::istream& stream, UPKInfo& info)
     {
         ss << UObject::Deserialize(stream, info);
         uint32_t pos = ((unsigned)stream.tellg() - info.GetExportEntry(ThisRef).SerialOffset);
-        ss << "Stream relative position (debug info): " << FormatHEX(pos) << " (" << pos << ")\n";
+        if (TextOutput)
+            ss << "Stream relative position (debug info): " << FormatHEX(pos) << " (" << pos << ")\n";
         if (pos == info.GetExportEntry(ThisRef).SerialSize)
             return ss.str();
     }
-    ss << "UObjectUnknown:\n";
-    ss << "\tObject unknown, can't deserialize!\n";
+    if (TextOutput)
+    {
+        ss << "UObjectUnknown:\n";
+        ss << "\tObject unknown, can't deserialize!\n";
+    }
     return ss.str();
 }
@@ -62,15 +62,16 @@ protected:
 class UDefaultProperty
 {
 public:
-    UDefaultProperty(): Name("None"), Type("None"), OwnerRef(0), TryUnsafe(0), QuickMode(0) {}
+    UDefaultProperty(): Name("None"), Type("None"), OwnerRef(0), TryUnsafe(0), QuickMode(0), TextOutput(1) {}
     ~UDefaultProperty() {}
-    std::string Deserialize(std::istream& stream, UPKInfo& info, UObjectReference owner, bool unsafe = false, bool quick = false);
-    void Init(UObjectReference owner, bool unsafe = false, bool quick = false) { OwnerRef = owner; TryUnsafe = unsafe; QuickMode = quick; }
+    std::string Deserialize(std::istream& stream, UPKInfo& info, UObjectReference owner, bool unsafe = false, bool quick = false, bool text = true);
+    void Init(UObjectReference owner, bool unsafe = false, bool quick = false, bool text = true) { OwnerRef = owner; TryUnsafe = unsafe; QuickMode = quick; TextOutput = text; }
     std::string GetName() { return Name; }
     std::string DeserializeValue(std::istream& stream, UPKInfo& info);
     std::string FindArrayType(std::string ArrName, std::istream& stream, UPKInfo& info);
     std::string GuessArrayType(std::string ArrName);
 protected:
+    std::string ResolveArrayType(const std::string& ArrName, std::istream& stream, UPKInfo& info);
     /// persistent
     UNameIndex NameIdx;
     UNameIndex TypeIdx;
@@ -85,6 +86,7 @@ protected:
     UObjectReference OwnerRef;
     bool TryUnsafe;
     bool QuickMode;
+    bool TextOutput;
 };
 
 class UDefaultPropertiesList
@@ -92,7 +94,7 @@ class UDefaultPropertiesList
 public:
     UDefaultPropertiesList() {}
     ~UDefaultPropertiesList() {}
-    std::string Deserialize(std::istream& stream, UPKInfo& info, UObjectReference owner, bool unsafe = false, bool quick = false);
+    std::string Deserialize(std::istream& stream, UPKInfo& info, UObjectReference owner, bool unsafe = false, bool quick = false, bool text = true);
 protected:
     std::vector<UDefaultProperty> DefaultProperties;
     size_t PropertyOffset;
@@ -103,9 +105,11 @@ protected:
 class UObject
 {
 public:
-    UObject(): Type(GlobalType::UObject), ThisRef(0), FlagsOffset(0), TryUnsafe(0), QuickMode(0) {}
+    UObject(): Type(GlobalType::UObject), ThisRef(0), FlagsOffset(0), TryUnsafe(0), QuickMode(0), TextOutput(1) {}
     virtual ~UObject() {}
     virtual std::string Deserialize(std::istream& stream, UPKInfo& info);
+    /// structured decoding: fills object fields without formatting text output
+    bool Decode(std::istream& stream, UPKInfo& info);
     void SetRef(UObjectReference thisRef) { ThisRef = thisRef; }
     void SetUnsafe(bool val) { TryUnsafe = val; }
     void SetQuickMode(bool val) { QuickMode = val; }
@@ -122,6 +126,7 @@ protected:
     size_t FlagsOffset;
     bool TryUnsafe;
     bool QuickMode;
+    bool TextOutput;
 };
 
 class UObjectNone: public UObject
@@ -1,123 +1,57 @@
 #include "UObjectFactory.h"
 
+/// type names sorted for binary search
+static const struct
+{
+    const char* Name;
+    GlobalType Type;
+} TypeNames[] =
+{
+    {"ArrayProperty",      GlobalType::UArrayProperty},
+    {"BoolProperty",       GlobalType::UBoolProperty},
+    {"ByteProperty",       GlobalType::UByteProperty},
+    {"Class",              GlobalType::UClass},
+    {"ClassProperty",      GlobalType::UClassProperty},
+    {"ComponentProperty",  GlobalType::UComponentProperty},
+    {"Const",              GlobalType::UConst},
+    {"DelegateProperty",   GlobalType::UDelegateProperty},
+    {"Enum",               GlobalType::UEnum},
+    {"Field",              GlobalType::UField},
+    {"FixedArrayProperty", GlobalType::UFixedArrayProperty},
+    {"FloatProperty",      GlobalType::UFloatProperty},
+    {"Function",           GlobalType::UFunction},
+    {"IntProperty",        GlobalType::UIntProperty},
+    {"InterfaceProperty",  GlobalType::UInterfaceProperty},
+    {"Level",              GlobalType::ULevel},
+    {"MapProperty",        GlobalType::UMapProperty},
+    {"NameProperty",       GlobalType::UNameProperty},
+    {"None",               GlobalType::None},
+    {"Object",             GlobalType::UObject},
+    {"ObjectProperty",     GlobalType::UObjectProperty},
+    {"Property",           GlobalType::UProperty},
+    {"ScriptStruct",       GlobalType::UScriptStruct},
+    {"State",              GlobalType::UState},
+    {"StrProperty",        GlobalType::UStrProperty},
+    {"Struct",             GlobalType::UStruct},
+    {"StructProperty",     GlobalType::UStructProperty},
+    {"TextBuffer",         GlobalType::UTextBuffer},
+};
+
 GlobalType UObjectFactory::NameToType(std::string name)
 {
-    if (name == "None")
-    {
-        return GlobalType::None;
-    }
-    else if (name == "Object")
-    {
-        return GlobalType::UObject;
-    }
-    else if (name == "Field")
-    {
-        return GlobalType::UField;
-    }
-	else if (name == "Const")
-    {
-        return GlobalType::UConst;
-    }
-	else if (name == "Enum")
-    {
-        return GlobalType::UEnum;
-    }
-	else if (name == "Property")
-    {
-        return GlobalType::UProperty;
-    }
-	else if (name == "ByteProperty")
-    {
-        return GlobalType::UByteProperty;
-    }
-	else if (name == "IntProperty")
-    {
-        return GlobalType::UIntProperty;
-    }
-	else if (name == "BoolProperty")
-    {
-        return GlobalType::UBoolProperty;
-    }
-	else if (name == "FloatProperty")
-    {
-        return GlobalType::UFloatProperty;
-    }
-	else if (name == "ObjectProperty")
-    {
-        return GlobalType::UObjectProperty;
-    }
-	else if (name == "ClassProperty")
-    {
-        return GlobalType::UClassProperty;
-    }
-	else if (name == "ComponentProperty")
-    {
-        return GlobalType::UComponentProperty;
-    }
-	else if (name == "NameProperty")
-    {
-        return GlobalType::UNameProperty;
-    }
-	else if (name == "StructProperty")
-    {
-        return GlobalType::UStructProperty;
-    }
-	else if (name == "StrProperty")
-    {
-        return GlobalType::UStrProperty;
-    }
-	else if (name == "ArrayProperty")
-    {
-        return GlobalType::UArrayProperty;
-    }
-	else if (name == "FixedArrayProperty")
-    {
-        return GlobalType::UFixedArrayProperty;
-    }
-	else if (name == "DelegateProperty")
-    {
-        return GlobalType::UDelegateProperty;
-    }
-	else if (name == "InterfaceProperty")
-    {
-        return GlobalType::UInterfaceProperty;
-    }
-	else if (name == "MapProperty")
-    {
-        return GlobalType::UMapProperty;
-    }
-	else if (name == "Struct")
-    {
-        return GlobalType::UStruct;
-    }
-	else if (name == "ScriptStruct")
-    {
-        return GlobalType::UScriptStruct;
-    }
-	else if (name == "Function")
-    {
-        return GlobalType::UFunction;
-    }
-	else if (name == "State")
-    {
-        return GlobalType::UState;
-    }
-	else if (name == "Class")
-    {
-        return GlobalType::UClass;
-    }
-	else if (name == "TextBuffer")
-    {
-        return GlobalType::UTextBuffer;
-    }
-	else if (name == "Level")
-    {
-        return GlobalType::ULevel;
-    }
-    else
-    {
-        return GlobalType::UObjectUnknown;
-    }
+    size_t first = 0, last = sizeof(TypeNames) / sizeof(TypeNames[0]);
+    while (first < last)
+    {
+        size_t mid = (first + last) / 2;
+        int cmp = name.compare(TypeNames[mid].Name);
+        if (cmp == 0)
+            return TypeNames[mid].Type;
+        if (cmp > 0)
+            first = mid + 1;
+        else
+            last = mid;
+    }
+    return GlobalType::UObjectUnknown;
 }
 
 UObject* UObjectFactory::Create(std::string name)
@@ -0,0 +1,197 @@
+#include "UPKCompressedImage.h"
+
+#include <algorithm>
+#include <cstring>
+
+bool UPKCompressedImage::Open(const char* filename, const std::vector<FCompressedChunk>& chunks, const std::vector<char>& summary)
+{
+    Close();
+    File.open(filename, std::ios::binary);
+    if (!File.is_open())
+        return false;
+    File.seekg(0, std::ios::end);
+    FileSize = File.tellg();
+    for (unsigned i = 0; i < chunks.size(); ++i)
+    {
+        ChunkState State;
+        State.Chunk = chunks[i];
+        State.HeaderLoaded = false;
+        Chunks.push_back(State);
+    }
+    std::sort(Chunks.begin(), Chunks.end(), [](const ChunkState& a, const ChunkState& b)
+    {
+        return (a.Chunk.UncompressedOffset < b.Chunk.UncompressedOffset);
+    });
+    /// chunks must not overlap summary and each other
+    Size = summary.size();
+    for (unsigned i = 0; i < Chunks.size(); ++i)
+    {
+        const FCompressedChunk& Chunk = Chunks[i].Chunk;
+        if (Chunk.UncompressedOffset < Size || (size_t)Chunk.CompressedOffset + Chunk.CompressedSize > FileSize)
+        {
+            Close();
+            return false;
+        }
+        Size = (size_t)Chunk.UncompressedOffset + Chunk.UncompressedSize;
+    }
+    if (Size == 0)
+    {
+        Close();
+        return false;
+    }
+    /// image memory is not initialized, so only accessed pages are committed
+    Image.reset(new char[Size]);
+    memcpy(Image.get(), summary.data(), summary.size());
+    /// gaps between chunks are never loaded and read as zeros
+    size_t gapOffset = summary.size();
+    for (unsigned i = 0; i < Chunks.size(); ++i)
+    {
+        memset(Image.get() + gapOffset, 0, Chunks[i].Chunk.UncompressedOffset - gapOffset);
+        gapOffset = Chunks[i].Chunk.UncompressedOffset + Chunks[i].Chunk.UncompressedSize;
+    }
+    return true;
+}
+
+void UPKCompressedImage::Close()
+{
+    std::lock_guard<std::mutex> lock(Mutex);
+    if (File.is_open())
+        File.close();
+    File.clear();
+    FileSize = 0;
+    Image.reset();
+    Size = 0;
+    Chunks.clear();
+    CompressedBuf.clear();
+}
+
+bool UPKCompressedImage::Load(size_t offset, size_t size)
+{
+    if (offset > Size || size > Size - offset)
+        return false;
+    for (size_t pos = offset; pos < offset + size; )
+    {
+        pos = LoadAt(pos);
+        if (pos == 0)
+            return false;
+    }
+    return true;
+}
+
+size_t UPKCompressedImage::LoadAt(size_t offset)
+{
+    std::lock_guard<std::mutex> lock(Mutex);
+    if (offset >= Size)
+        return 0;
+    std::vector<ChunkState>::iterator it = std::upper_bound(Chunks.begin(), Chunks.end(), offset,
+        [](size_t off, const ChunkState& State)
+        {
+            return (off < State.Chunk.UncompressedOffset);
+        });
+    size_t nextOffset = (it == Chunks.end() ? Size : it->Chunk.UncompressedOffset);
+    /// summary or gap between chunks
+    if (it == Chunks.begin())
+        return nextOffset;
+    ChunkState& State = *(it - 1);
+    if (offset >= (size_t)State.Chunk.UncompressedOffset + State.Chunk.UncompressedSize)
+        return nextOffset;
+    if (!State.HeaderLoaded && !LoadChunkHeader(State))
+        return 0;
+    size_t blockIdx = std::upper_bound(State.BlockUncompressedOffsets.begin(), State.BlockUncompressedOffsets.end(), offset)
+                      - State.BlockUncompressedOffsets.begin() - 1;
+    if (!LoadBlock(State, blockIdx))
+        return 0;
+    return State.BlockUncompressedOffsets[blockIdx] + State.Header.Blocks[blockIdx].UncompressedSize;
+}
+
+bool UPKCompressedImage::LoadChunkHeader(ChunkState& State)
+{
+    File.clear();
+    File.seekg(State.Chunk.CompressedOffset);
+    if (!LZOReadChunkHeader(File, State.Header) || State.Header.UncompressedSize != State.Chunk.UncompressedSize)
+        return false;
+    size_t compressedOffset = State.Chunk.CompressedOffset + LZOGetChunkHeaderSize(State.Header);
+    if (compressedOffset + State.Header.CompressedSize > FileSize)
+        return false;
+    size_t uncompressedOffset = State.Chunk.UncompressedOffset;
+    for (unsigned i = 0; i < State.Header.Blocks.size(); ++i)
+    {
+        State.BlockCompressedOffsets.push_back(compressedOffset);
+        State.BlockUncompressedOffsets.push_back(uncompressedOffset);
+        compressedOffset += State.Header.Blocks[i].CompressedSize;
+        uncompressedOffset += State.Header.Blocks[i].UncompressedSize;
+    }
+    State.BlockLoaded.assign(State.Header.Blocks.size(), 0);
+    State.HeaderLoaded = true;
+    return true;
+}
+
+bool UPKCompressedImage::LoadBlock(ChunkState& State, size_t blockIdx)
+{
+    if (State.BlockLoaded[blockIdx] != 0)
+        return true;
+    const LZOChunkBlock& Block = State.Header.Blocks[blockIdx];
+    CompressedBuf.resize(Block.CompressedSize);
+    File.clear();
+    File.seekg(State.BlockCompressedOffsets[blockIdx]);
+    File.read(CompressedBuf.data(), CompressedBuf.size());
+    if (!File.good())
+        return false;
+    if (!LZODecompressBlock(CompressedBuf.data(), Block.CompressedSize,
+                            Image.get() + State.BlockUncompressedOffsets[blockIdx], Block.UncompressedSize))
+        return false;
+    State.BlockLoaded[blockIdx] = 1;
+    return true;
+}
+
+UPKCompressedStreamBuf::UPKCompressedStreamBuf(UPKCompressedImage& image): Image(image)
+{
+    /// empty get area: first read loads data
+    char* p = const_cast<char*>(Image.GetData());
+    setg(p, p, p);
+}
+
+UPKCompressedStreamBuf::int_type UPKCompressedStreamBuf::underflow()
+{
+    if (gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+    char* data = const_cast<char*>(Image.GetData());
+    size_t pos = gptr() - data;
+    size_t end = Image.LoadAt(pos);
+    if (end == 0)
+        return traits_type::eof();
+    /// get area covers loaded block only
+    setg(data + pos, data + pos, data + end);
+    return traits_type::to_int_type(*gptr());
+}
+
+UPKCompressedStreamBuf::pos_type UPKCompressedStreamBuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    if (!(which & std::ios_base::in))
+        return pos_type(off_type(-1));
+    off_type base = 0;
+    if (dir == std::ios_base::cur)
+        base = gptr() - Image.GetData();
+    else if (dir == std::ios_base::end)
+        base = Image.GetSize();
+    return seekpos(pos_type(base + off), which);
+}
+
+UPKCompressedStreamBuf::pos_type UPKCompressedStreamBuf::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    off_type off = pos;
+    if (!(which & std::ios_base::in) || off < 0 || off > (off_type)Image.GetSize())
+        return pos_type(off_type(-1));
+    char* p = const_cast<char*>(Image.GetData()) + off;
+    /// keep current get area if new position is inside it
+    if (p >= eback() && p <= egptr())
+        setg(eback(), p, egptr());
+    else
+        setg(p, p, p);
+    return pos;
+}
+
+UPKCompressedStream::UPKCompressedStream(UPKCompressedImage& image): std::istream(nullptr), Buf(image)
+{
+    rdbuf(&Buf);
+}
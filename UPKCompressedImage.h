@@ -0,0 +1,80 @@
+#ifndef UPKCOMPRESSEDIMAGE_H
+#define UPKCOMPRESSEDIMAGE_H
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+
+#include "UPKInfo.h"
+#include "LZOCodec.h"
+
+/// lazily decompressed image of a LZO compressed package
+/// image has the same layout as the package, decompressed by DecompressLZO:
+/// uncompressed summary followed by chunk data at their uncompressed offsets
+/// chunk headers and data blocks are read and decompressed on first access only,
+/// so memory and I/O costs depend on the amount of data actually accessed
+class UPKCompressedImage
+{
+public:
+    UPKCompressedImage(): FileSize(0), Size(0) {}
+    ~UPKCompressedImage() {}
+    /// summary is the serialized uncompressed package summary
+    bool Open(const char* filename, const std::vector<FCompressedChunk>& chunks, const std::vector<char>& summary);
+    void Close();
+    bool IsOpen() { return (Image != nullptr); }
+    size_t GetSize() { return Size; }
+    /// decompress [offset, offset + size) range if needed, returns false on errors
+    bool Load(size_t offset, size_t size);
+    /// decompress the block containing offset if needed
+    /// returns end of the loaded range, containing offset, or 0 on errors
+    size_t LoadAt(size_t offset);
+    /// image data, only loaded ranges are valid
+    const char* GetData() { return Image.get(); }
+private:
+    struct ChunkState
+    {
+        FCompressedChunk Chunk;
+        bool HeaderLoaded;
+        LZOChunkHeader Header;
+        std::vector<size_t> BlockCompressedOffsets;     /// file offsets
+        std::vector<size_t> BlockUncompressedOffsets;   /// image offsets
+        std::vector<char> BlockLoaded;
+    };
+    UPKCompressedImage(const UPKCompressedImage&);
+    UPKCompressedImage& operator=(const UPKCompressedImage&);
+    bool LoadChunkHeader(ChunkState& State);
+    bool LoadBlock(ChunkState& State, size_t blockIdx);
+    std::ifstream File;
+    size_t FileSize;
+    std::unique_ptr<char[]> Image;
+    size_t Size;
+    std::vector<ChunkState> Chunks;             /// sorted by uncompressed offset
+    std::vector<char> CompressedBuf;
+    std::mutex Mutex;
+};
+
+/// read-only seekable stream buffer over a compressed image
+/// data blocks are decompressed as the stream reaches them
+class UPKCompressedStreamBuf: public std::streambuf
+{
+public:
+    UPKCompressedStreamBuf(UPKCompressedImage& image);
+protected:
+    int_type underflow();
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::in);
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in);
+private:
+    UPKCompressedImage& Image;
+};
+
+/// input stream over a compressed image
+class UPKCompressedStream: public std::istream
+{
+public:
+    UPKCompressedStream(UPKCompressedImage& image);
+private:
+    UPKCompressedStreamBuf Buf;
+};
+
+#endif // UPKCOMPRESSEDIMAGE_H
@@ -1,10 +1,14 @@
 #include "UPKInfo.h"
+#include "HexCodec.h"
 
 #include <cstdio>
 #include <sstream>
 #include <cstring>
+#include <algorithm>
+#include <unordered_set>
+#include <set>
 
-UPKInfo::UPKInfo(std::istream& stream): Summary(), NoneIdx(0), ReadError(UPKReadErrors::NoErrors), Compressed(false), CompressedChunk(false)
+UPKInfo::UPKInfo(std::istream& stream): Summary(), NoneIdx(0), ReadError(UPKReadErrors::NoErrors), Compressed(false), CompressedChunk(false), OffsetLookupValid(false)
 {
     Read(stream);
 }
@@ -54,7 +58,9 @@ bool UPKInfo::ReadCompressedHeader(std::istream& stream)
 
 bool UPKInfo::Read(std::istream& stream)
 {
+    ClearArrayInnerTypes();
     CompressedHeader = FCompressedChunkHeader{};
+    ReadError = UPKReadErrors::NoErrors;
     if (!stream.good())
     {
         ReadError = UPKReadErrors::FileError;
@@ -146,19 +152,7 @@ bool UPKInfo::Read(std::istream& stream)
     for (unsigned i = 0; i < Summary.NameCount; ++i)
     {
         FNameEntry EntryToRead;
-        EntryToRead.EntryOffset = stream.tellg();
-        stream.read(reinterpret_cast<char*>(&EntryToRead.NameLength), 4);
-        if (EntryToRead.NameLength > 0)
-        {
-            getline(stream, EntryToRead.Name, '\0');
-        }
-        else
-        {
-            EntryToRead.Name = "";
-        }
-        stream.read(reinterpret_cast<char*>(&EntryToRead.NameFlagsL), 4);
-        stream.read(reinterpret_cast<char*>(&EntryToRead.NameFlagsH), 4);
-        EntryToRead.EntrySize = (unsigned)stream.tellg() - EntryToRead.EntryOffset;
+        ReadNameEntry(stream, EntryToRead);
         NameTable.push_back(EntryToRead);
         if (EntryToRead.Name == "None")
             NoneIdx = i;
@@ -169,12 +163,7 @@ bool UPKInfo::Read(std::istream& stream)
     for (unsigned i = 0; i < Summary.ImportCount; ++i)
     {
         FObjectImport EntryToRead;
-        EntryToRead.EntryOffset = stream.tellg();
-        stream.read(reinterpret_cast<char*>(&EntryToRead.PackageIdx), sizeof(EntryToRead.PackageIdx));
-        stream.read(reinterpret_cast<char*>(&EntryToRead.TypeIdx), sizeof(EntryToRead.TypeIdx));
-        stream.read(reinterpret_cast<char*>(&EntryToRead.OwnerRef), sizeof(EntryToRead.OwnerRef));
-        stream.read(reinterpret_cast<char*>(&EntryToRead.NameIdx), sizeof(EntryToRead.NameIdx));
-        EntryToRead.EntrySize = (unsigned)stream.tellg() - EntryToRead.EntryOffset;
+        ReadImportEntry(stream, EntryToRead);
         ImportTable.push_back(EntryToRead);
     }
     ExportTable.clear();
@@ -183,26 +172,7 @@ bool UPKInfo::Read(std::istream& stream)
     for (unsigned i = 0; i < Summary.ExportCount; ++i)
     {
         FObjectExport EntryToRead;
-        EntryToRead.EntryOffset = stream.tellg();
-        stream.read(reinterpret_cast<char*>(&EntryToRead.TypeRef), sizeof(EntryToRead.TypeRef));
-        stream.read(reinterpret_cast<char*>(&EntryToRead.ParentClassRef), sizeof(EntryToRead.ParentClassRef));
-        stream.read(reinterpret_cast<char*>(&EntryToRead.OwnerRef), sizeof(EntryToRead.OwnerRef));
-        stream.read(reinterpret_cast<char*>(&EntryToRead.NameIdx), sizeof(EntryToRead.NameIdx));
-        stream.read(reinterpret_cast<char*>(&EntryToRead.ArchetypeRef), sizeof(EntryToRead.ArchetypeRef));
-        stream.read(reinterpret_cast<char*>(&EntryToRead.ObjectFlagsH), sizeof(EntryToRead.ObjectFlagsH));
-        stream.read(reinterpret_cast<char*>(&EntryToRead.ObjectFlagsL), sizeof(EntryToRead.ObjectFlagsL));
-        stream.read(reinterpret_cast<char*>(&EntryToRead.SerialSize), sizeof(EntryToRead.SerialSize));
-        stream.read(reinterpret_cast<char*>(&EntryToRead.SerialOffset), sizeof(EntryToRead.SerialOffset));
-        stream.read(reinterpret_cast<char*>(&EntryToRead.ExportFlags), sizeof(EntryToRead.ExportFlags));
-        stream.read(reinterpret_cast<char*>(&EntryToRead.NetObjectCount), sizeof(EntryToRead.NetObjectCount));
-        stream.read(reinterpret_cast<char*>(&EntryToRead.GUID), sizeof(EntryToRead.GUID));
-        stream.read(reinterpret_cast<char*>(&EntryToRead.Unknown1), sizeof(EntryToRead.Unknown1));
-        EntryToRead.NetObjects.resize(EntryToRead.NetObjectCount);
-        if (EntryToRead.NetObjectCount > 0)
-        {
-            stream.read(reinterpret_cast<char*>(EntryToRead.NetObjects.data()), EntryToRead.NetObjects.size()*4);
-        }
-        EntryToRead.EntrySize = (unsigned)stream.tellg() - EntryToRead.EntryOffset;
+        ReadExportEntry(stream, EntryToRead);
         ExportTable.push_back(EntryToRead);
     }
     DependsBuf.clear();
@@ -217,35 +187,256 @@ bool UPKInfo::Read(std::istream& stream)
         return false;
     }
     /// resolve names
+    /// arena is sized for distinct names and full names of all the objects
+    Strings.Reserve(NameTable.size() + ImportTable.size() + ExportTable.size());
+    for (unsigned i = 1; i < ImportTable.size(); ++i)
+    {
+        ResolveImportEntry(i);
+    }
+    for (unsigned i = 1; i < ExportTable.size(); ++i)
+    {
+        ResolveExportEntry(i);
+    }
+    std::vector<char> ImportResolved(ImportTable.size(), 0);
+    std::vector<char> ExportResolved(ExportTable.size(), 0);
+    ResolveFullNames(ImportResolved, ExportResolved);
+    BuildLookupTables();
+    BuildOffsetLookup();
+    return true;
+}
+
+void UPKInfo::ReadNameEntry(std::istream& stream, FNameEntry& Entry)
+{
+    Entry.EntryOffset = stream.tellg();
+    stream.read(reinterpret_cast<char*>(&Entry.NameLength), 4);
+    if (Entry.NameLength > 0)
+    {
+        getline(stream, Entry.Name, '\0');
+    }
+    else
+    {
+        Entry.Name = "";
+    }
+    stream.read(reinterpret_cast<char*>(&Entry.NameFlagsL), 4);
+    stream.read(reinterpret_cast<char*>(&Entry.NameFlagsH), 4);
+    Entry.EntrySize = (unsigned)stream.tellg() - Entry.EntryOffset;
+}
+
+void UPKInfo::ReadImportEntry(std::istream& stream, FObjectImport& Entry)
+{
+    Entry.EntryOffset = stream.tellg();
+    stream.read(reinterpret_cast<char*>(&Entry.PackageIdx), sizeof(Entry.PackageIdx));
+    stream.read(reinterpret_cast<char*>(&Entry.TypeIdx), sizeof(Entry.TypeIdx));
+    stream.read(reinterpret_cast<char*>(&Entry.OwnerRef), sizeof(Entry.OwnerRef));
+    stream.read(reinterpret_cast<char*>(&Entry.NameIdx), sizeof(Entry.NameIdx));
+    Entry.EntrySize = (unsigned)stream.tellg() - Entry.EntryOffset;
+}
+
+void UPKInfo::ReadExportEntry(std::istream& stream, FObjectExport& Entry)
+{
+    Entry.EntryOffset = stream.tellg();
+    stream.read(reinterpret_cast<char*>(&Entry.TypeRef), sizeof(Entry.TypeRef));
+    stream.read(reinterpret_cast<char*>(&Entry.ParentClassRef), sizeof(Entry.ParentClassRef));
+    stream.read(reinterpret_cast<char*>(&Entry.OwnerRef), sizeof(Entry.OwnerRef));
+    stream.read(reinterpret_cast<char*>(&Entry.NameIdx), sizeof(Entry.NameIdx));
+    stream.read(reinterpret_cast<char*>(&Entry.ArchetypeRef), sizeof(Entry.ArchetypeRef));
+    stream.read(reinterpret_cast<char*>(&Entry.ObjectFlagsH), sizeof(Entry.ObjectFlagsH));
+    stream.read(reinterpret_cast<char*>(&Entry.ObjectFlagsL), sizeof(Entry.ObjectFlagsL));
+    stream.read(reinterpret_cast<char*>(&Entry.SerialSize), sizeof(Entry.SerialSize));
+    stream.read(reinterpret_cast<char*>(&Entry.SerialOffset), sizeof(Entry.SerialOffset));
+    stream.read(reinterpret_cast<char*>(&Entry.ExportFlags), sizeof(Entry.ExportFlags));
+    stream.read(reinterpret_cast<char*>(&Entry.NetObjectCount), sizeof(Entry.NetObjectCount));
+    stream.read(reinterpret_cast<char*>(&Entry.GUID), sizeof(Entry.GUID));
+    stream.read(reinterpret_cast<char*>(&Entry.Unknown1), sizeof(Entry.Unknown1));
+    Entry.NetObjects.resize(Entry.NetObjectCount);
+    if (Entry.NetObjectCount > 0)
+    {
+        stream.read(reinterpret_cast<char*>(Entry.NetObjects.data()), Entry.NetObjects.size()*4);
+    }
+    Entry.EntrySize = (unsigned)stream.tellg() - Entry.EntryOffset;
+}
+
+void UPKInfo::ResolveImportEntry(uint32_t idx)
+{
+    ImportTable[idx].Name = InternName(ImportTable[idx].NameIdx);
+    ImportTable[idx].Type = InternName(ImportTable[idx].TypeIdx);
+    if (ImportTable[idx].Type == "")
+    {
+        ImportTable[idx].Type = Strings.Intern("Class");
+    }
+}
+
+void UPKInfo::ResolveExportEntry(uint32_t idx)
+{
+    ExportTable[idx].Name = InternName(ExportTable[idx].NameIdx);
+    UObjectReference TypeRef = ExportTable[idx].TypeRef;
+    if (TypeRef == 0 || -TypeRef >= (int)ImportTable.size() || TypeRef >= (int)ExportTable.size())
+        ExportTable[idx].Type = UPKString();
+    else
+        ExportTable[idx].Type = InternName(TypeRef > 0 ? ExportTable[TypeRef].NameIdx : ImportTable[-TypeRef].NameIdx);
+    if (ExportTable[idx].Type == "")
+    {
+        ExportTable[idx].Type = Strings.Intern("Class");
+    }
+}
+
+UPKString UPKInfo::InternName(UNameIndex idx)
+{
+    const std::string& Name = GetNameEntry(idx.NameTableIdx).Name;
+    if (idx.Numeric != 0 && Name != "None")
+        return Strings.Intern(IndexToName(idx));
+    /// name table strings are interned once, cached handle is checked
+    /// against the name table, which is changed by header writes
+    uint32_t i = (idx.NameTableIdx < NameTable.size() ? idx.NameTableIdx : NoneIdx);
+    if (i >= NameStrings.size())
+        NameStrings.resize(NameTable.size(), UPKString(nullptr, 0));
+    if (NameStrings[i].data() == nullptr || NameStrings[i] != Name)
+        NameStrings[i] = Strings.Intern(Name);
+    return NameStrings[i];
+}
+
+void UPKInfo::ResolveFullNames(std::vector<char>& ImportResolved, std::vector<char>& ExportResolved)
+{
+    /// owner full names are resolved first and reused by owned objects,
+    /// so each full name is built once by a single append
+    ImportResolved[0] = ExportResolved[0] = 1;
+    auto Resolved = [&](UObjectReference ObjRef) -> char&
+    {
+        return (ObjRef < 0 ? ImportResolved[-ObjRef] : ExportResolved[ObjRef]);
+    };
+    auto IsValidRef = [&](UObjectReference ObjRef)
+    {
+        return (ObjRef < 0 ? (uint32_t)-ObjRef < ImportTable.size() : (uint32_t)ObjRef < ExportTable.size());
+    };
+    std::vector<UObjectReference> Chain;
+    std::string ResolvedName;
+    for (int i = 1 - (int)ImportTable.size(); i < (int)ExportTable.size(); ++i)
+    {
+        UObjectReference ObjRef = i;
+        Chain.clear();
+        /// objects are marked before resolving to stop at owner loops
+        while (IsValidRef(ObjRef) && !Resolved(ObjRef))
+        {
+            Resolved(ObjRef) = 1;
+            Chain.push_back(ObjRef);
+            ObjRef = GetOwnerRef(ObjRef);
+        }
+        for (size_t j = Chain.size(); j > 0; --j)
+        {
+            UObjectReference OwnerRef = GetOwnerRef(Chain[j - 1]);
+            const UPKString& Name = (Chain[j - 1] < 0 ? ImportTable[-Chain[j - 1]].Name : ExportTable[Chain[j - 1]].Name);
+            UPKString& FullName = (Chain[j - 1] < 0 ? ImportTable[-Chain[j - 1]].FullName : ExportTable[Chain[j - 1]].FullName);
+            if (OwnerRef == 0)
+            {
+                FullName = Name;
+                continue;
+            }
+            /// bad owner references are resolved to empty names
+            ResolvedName.clear();
+            if (IsValidRef(OwnerRef))
+                ResolvedName += (OwnerRef < 0 ? ImportTable[-OwnerRef].FullName : ExportTable[OwnerRef].FullName);
+            ResolvedName += '.';
+            ResolvedName += Name;
+            FullName = Strings.Intern(ResolvedName);
+        }
+    }
+}
+
+void UPKInfo::RefreshResolvedNames(const std::vector<uint32_t>& Names, const std::vector<UObjectReference>& Objects)
+{
+    if (Names.empty() && Objects.empty())
+        return;
+    ClearArrayInnerTypes();
+    std::unordered_set<uint32_t> ChangedNames(Names.begin(), Names.end());
+    if (!ChangedNames.empty())
+    {
+        for (unsigned i = 0; i < NameTable.size(); ++i)
+        {
+            if (NameTable[i].Name == "None")
+                NoneIdx = i;
+        }
+    }
+    /// entry states: 0 - unknown, 1 - changed, 2 - unchanged, 3 - being checked
+    std::vector<uint8_t> ImportState(ImportTable.size(), 0);
+    std::vector<uint8_t> ExportState(ExportTable.size(), 0);
+    /// bad references are resolved to the null entry, the same way GetOwnerRef does it
+    auto State = [&](UObjectReference ObjRef) -> uint8_t&
+    {
+        if (ObjRef < 0)
+            return ImportState[(uint32_t)-ObjRef < ImportTable.size() ? -ObjRef : 0];
+        return ExportState[(uint32_t)ObjRef < ExportTable.size() ? ObjRef : 0];
+    };
+    ImportState[0] = ExportState[0] = 2;
+    for (unsigned i = 0; i < Objects.size(); ++i)
+    {
+        if (Objects[i] != 0)
+            State(Objects[i]) = 1;
+    }
+    for (unsigned i = 1; i < ImportTable.size(); ++i)
+    {
+        if (ChangedNames.count(ImportTable[i].NameIdx.NameTableIdx) || ChangedNames.count(ImportTable[i].TypeIdx.NameTableIdx))
+            ImportState[i] = 1;
+    }
+    for (unsigned i = 1; i < ExportTable.size(); ++i)
+    {
+        if (ChangedNames.count(ExportTable[i].NameIdx.NameTableIdx))
+            ExportState[i] = 1;
+    }
+    /// full name changes with any of the owners
+    std::vector<UObjectReference> Chain;
+    auto CheckOwners = [&](UObjectReference ObjRef)
+    {
+        Chain.clear();
+        while (State(ObjRef) == 0)
+        {
+            State(ObjRef) = 3;
+            Chain.push_back(ObjRef);
+            ObjRef = GetOwnerRef(ObjRef);
+        }
+        uint8_t ret = (State(ObjRef) == 1 ? 1 : 2);
+        for (unsigned i = 0; i < Chain.size(); ++i)
+            State(Chain[i]) = ret;
+    };
+    for (unsigned i = 1; i < ImportTable.size(); ++i)
+        CheckOwners(-(int)i);
+    for (unsigned i = 1; i < ExportTable.size(); ++i)
+        CheckOwners(i);
+    bool changed = false;
+    std::vector<char> ImportResolved(ImportTable.size(), 1);
+    std::vector<char> ExportResolved(ExportTable.size(), 1);
     for (unsigned i = 1; i < ImportTable.size(); ++i)
     {
-        ImportTable[i].Name = IndexToName(ImportTable[i].NameIdx);
-        ImportTable[i].FullName = ResolveFullName(-i);
-        ImportTable[i].Type = IndexToName(ImportTable[i].TypeIdx);
-        if (ImportTable[i].Type == "")
+        if (ImportState[i] == 1)
         {
-            ImportTable[i].Type = "Class";
+            ResolveImportEntry(i);
+            ImportResolved[i] = 0;
+            changed = true;
         }
     }
     for (unsigned i = 1; i < ExportTable.size(); ++i)
     {
-        ExportTable[i].Name = IndexToName(ExportTable[i].NameIdx);
-        ExportTable[i].FullName = ResolveFullName(i);
-        ExportTable[i].Type = ObjRefToName(ExportTable[i].TypeRef);
-        if (ExportTable[i].Type == "")
+        /// export type is a name of the class object
+        if (ExportState[i] == 1 || State(ExportTable[i].TypeRef) == 1)
         {
-            ExportTable[i].Type = "Class";
+            ResolveExportEntry(i);
+            ExportResolved[i] = (ExportState[i] == 1 ? 0 : 1);
+            changed = true;
         }
     }
-    return true;
+    ResolveFullNames(ImportResolved, ExportResolved);
+    /// keys of the changed entries may be shared with the other entries,
+    /// so hash tables are rebuilt from already resolved names
+    if (changed || !ChangedNames.empty())
+        BuildLookupTables();
 }
 
 std::string UPKInfo::IndexToName(UNameIndex idx)
 {
+    const std::string& Name = GetNameEntry(idx.NameTableIdx).Name;
+    if (idx.Numeric == 0 || Name == "None")
+        return Name;
     std::ostringstream ss;
-    ss << GetNameEntry(idx.NameTableIdx).Name;
-    if (idx.Numeric > 0 && ss.str() != "None")
-        ss << "_" << int(idx.Numeric - 1);
+    ss << Name << "_" << int(idx.Numeric - 1);
     return ss.str();
 }
 
@@ -268,14 +459,24 @@ std::string UPKInfo::ObjRefToName(UObjectReference ObjRef)
 
 std::string UPKInfo::ResolveFullName(UObjectReference ObjRef)
 {
-    std::string name;
-    name = ObjRefToName(ObjRef);
+    /// collect names from object up to the outermost owner and join them once
+    std::vector<std::string> names(1, ObjRefToName(ObjRef));
+    size_t length = names.back().length();
     UObjectReference next = GetOwnerRef(ObjRef);
-    while (next != 0)
+    while (next != 0 && names.size() <= ImportTable.size() + ExportTable.size())
     {
-        name = ObjRefToName(next) + "." + name;
+        names.push_back(ObjRefToName(next));
+        length += names.back().length() + 1;
         next = GetOwnerRef(next);
     }
+    std::string name;
+    name.reserve(length);
+    for (size_t i = names.size(); i > 0; --i)
+    {
+        name += names[i - 1];
+        if (i > 1)
+            name += ".";
+    }
     return name;
 }
 
@@ -296,66 +497,195 @@ UObjectReference UPKInfo::GetOwnerRef(UObjectReference ObjRef)
     return 0;
 }
 
-int UPKInfo::FindName(std::string name)
+int UPKInfo::FindName(const std::string& name)
 {
-    for (unsigned i = 0; i < NameTable.size(); ++i)
-    {
-        if (NameTable[i].Name == name)
-            return i;
-    }
+    std::unordered_map<std::string, int>::const_iterator it = NameLookup.find(name);
+    if (it != NameLookup.end())
+        return it->second;
     return -1;
 }
 
-UObjectReference UPKInfo::FindObject(std::string FullName, bool isExport)
+UObjectReference UPKInfo::FindObject(const std::string& FullName, bool isExport)
 {
+    std::unordered_map<UPKString, UObjectReference, UPKInternedStringHash>::const_iterator it;
+    /// lookup keys are interned names
+    UPKString Key = Strings.Find(FullName);
+    if (Key.data() == nullptr)
+        return 0;
     /// Import object
     if (isExport == false)
     {
-        for (unsigned i = 1; i < ImportTable.size(); ++i)
-        {
-            if (ImportTable[i].FullName == FullName)
-                return -i;
-        }
+        it = ImportFullNameLookup.find(Key);
+        if (it != ImportFullNameLookup.end())
+            return it->second;
     }
     /// Export object
-    for (unsigned i = 1; i < ExportTable.size(); ++i)
-    {
-        if (ExportTable[i].FullName == FullName)
-            return i;
-    }
+    it = ExportFullNameLookup.find(Key);
+    if (it != ExportFullNameLookup.end())
+        return it->second;
     /// Object not found
     return 0;
 }
 
-UObjectReference UPKInfo::FindObjectByName(std::string Name, bool isExport)
+UObjectReference UPKInfo::FindObjectByName(const std::string& Name, bool isExport)
 {
+    std::unordered_map<UPKString, UObjectReference, UPKInternedStringHash>::const_iterator it;
+    UPKString Key = Strings.Find(Name);
+    if (Key.data() == nullptr)
+        return 0;
     /// Import object
     if (isExport == false)
     {
-        for (unsigned i = 1; i < ImportTable.size(); ++i)
-        {
-            if (ImportTable[i].Name == Name)
-                return -i;
-        }
+        it = ImportNameLookup.find(Key);
+        if (it != ImportNameLookup.end())
+            return it->second;
     }
     /// Export object
-    for (unsigned i = 1; i < ExportTable.size(); ++i)
-    {
-        if (ExportTable[i].Name == Name)
-            return i;
-    }
+    it = ExportNameLookup.find(Key);
+    if (it != ExportNameLookup.end())
+        return it->second;
     /// Object not found
     return 0;
 }
 
+void UPKInfo::BuildLookupTables()
+{
+    NameLookup.clear();
+    ImportFullNameLookup.clear();
+    ExportFullNameLookup.clear();
+    ImportNameLookup.clear();
+    ExportNameLookup.clear();
+    NameLookup.reserve(NameTable.size());
+    ImportFullNameLookup.reserve(ImportTable.size());
+    ImportNameLookup.reserve(ImportTable.size());
+    ExportFullNameLookup.reserve(ExportTable.size());
+    ExportNameLookup.reserve(ExportTable.size());
+    for (unsigned i = 0; i < NameTable.size(); ++i)
+        AddNameLookup(i);
+    for (unsigned i = 1; i < ImportTable.size(); ++i)
+        AddImportLookup(i);
+    for (unsigned i = 1; i < ExportTable.size(); ++i)
+        AddExportLookup(i);
+}
+
+void UPKInfo::AddNameLookup(uint32_t idx)
+{
+    /// emplace does not overwrite existing keys, so the first entry wins
+    NameLookup.emplace(NameTable[idx].Name, idx);
+}
+
+void UPKInfo::AddImportLookup(uint32_t idx)
+{
+    ImportFullNameLookup.emplace(ImportTable[idx].FullName, -(int)idx);
+    ImportNameLookup.emplace(ImportTable[idx].Name, -(int)idx);
+}
+
+void UPKInfo::AddExportLookup(uint32_t idx)
+{
+    ExportFullNameLookup.emplace(ExportTable[idx].FullName, idx);
+    ExportNameLookup.emplace(ExportTable[idx].Name, idx);
+}
+
 UObjectReference UPKInfo::FindObjectByOffset(size_t offset)
 {
+    if (!OffsetLookupValid)
+        BuildOffsetLookup();
+    std::vector<FExportRange>::const_iterator it = std::upper_bound(ExportRanges.begin(), ExportRanges.end(), offset,
+        [](size_t val, const FExportRange& range) { return val < range.Begin; });
+    if (it == ExportRanges.begin())
+        return 0;
+    --it;
+    return (offset < it->End) ? it->ObjRef : 0;
+}
+
+std::vector<UObjectReference> UPKInfo::FindObjectsByOffsets(const std::vector<size_t>& offsets)
+{
+    if (!OffsetLookupValid)
+        BuildOffsetLookup();
+    std::vector<UObjectReference> ret(offsets.size(), 0);
+    /// sort offsets, keeping their original positions
+    std::vector<size_t> order(offsets.size());
+    for (unsigned i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(),
+        [&offsets](size_t a, size_t b) { return offsets[a] < offsets[b]; });
+    /// sweep offsets and ranges simultaneously
+    size_t rangeIdx = 0;
+    for (unsigned i = 0; i < order.size(); ++i)
+    {
+        size_t offset = offsets[order[i]];
+        while (rangeIdx < ExportRanges.size() && ExportRanges[rangeIdx].End <= offset)
+            ++rangeIdx;
+        if (rangeIdx < ExportRanges.size() && ExportRanges[rangeIdx].Begin <= offset)
+            ret[order[i]] = ExportRanges[rangeIdx].ObjRef;
+    }
+    return ret;
+}
+
+bool UPKInfo::FindArrayInnerType(UObjectReference OwnerRef, const std::string& ArrName, std::string& InnerType)
+{
+    std::lock_guard<std::mutex> lock(ArrayInnerTypesMutex);
+    std::map<std::pair<UObjectReference, std::string>, std::string>::const_iterator it = ArrayInnerTypes.find({OwnerRef, ArrName});
+    if (it == ArrayInnerTypes.end())
+        return false;
+    InnerType = it->second;
+    return true;
+}
+
+void UPKInfo::AddArrayInnerType(UObjectReference OwnerRef, const std::string& ArrName, const std::string& InnerType)
+{
+    std::lock_guard<std::mutex> lock(ArrayInnerTypesMutex);
+    ArrayInnerTypes[{OwnerRef, ArrName}] = InnerType;
+}
+
+void UPKInfo::ClearArrayInnerTypes()
+{
+    std::lock_guard<std::mutex> lock(ArrayInnerTypesMutex);
+    ArrayInnerTypes.clear();
+}
+
+void UPKInfo::BuildOffsetLookup()
+{
+    /// split export serial ranges into non-overlapping segments
+    /// each segment belongs to the lowest export index covering it
+    std::vector<std::pair<size_t, UObjectReference>> events;
+    events.reserve(2 * ExportTable.size());
     for (unsigned i = 1; i < ExportTable.size(); ++i)
     {
-        if (offset >= ExportTable[i].SerialOffset && offset < ExportTable[i].SerialOffset + ExportTable[i].SerialSize)
-            return i;
+        if (ExportTable[i].SerialSize == 0)
+            continue;
+        events.push_back({ExportTable[i].SerialOffset, (UObjectReference)i});
+        events.push_back({ExportTable[i].SerialOffset + ExportTable[i].SerialSize, -(UObjectReference)i});
     }
-    return 0;
+    std::sort(events.begin(), events.end(),
+        [](const std::pair<size_t, UObjectReference>& a, const std::pair<size_t, UObjectReference>& b) { return a.first < b.first; });
+    ExportRanges.clear();
+    std::set<UObjectReference> active;
+    for (size_t i = 0; i < events.size(); )
+    {
+        size_t pos = events[i].first;
+        for (; i < events.size() && events[i].first == pos; ++i)
+        {
+            if (events[i].second > 0)
+                active.insert(events[i].second);
+            else
+                active.erase(-events[i].second);
+        }
+        if (active.empty() || i == events.size())
+            continue;
+        UObjectReference owner = *active.begin();
+        if (!ExportRanges.empty() && ExportRanges.back().End == pos && ExportRanges.back().ObjRef == owner)
+        {
+            ExportRanges.back().End = events[i].first;
+            continue;
+        }
+        FExportRange range;
+        range.Begin = pos;
+        range.End = events[i].first;
+        range.ObjRef = owner;
+        ExportRanges.push_back(range);
+    }
+    OffsetLookupValid = true;
 }
 
 const FObjectExport& UPKInfo::GetExportEntry(uint32_t idx)
@@ -522,7 +852,7 @@ std::string UPKInfo::FormatImport(uint32_t idx, bool verbose)
 std::string UPKInfo::FormatExport(uint32_t idx, bool verbose)
 {
     std::ostringstream ss;
-    FObjectExport Entry = GetExportEntry(idx);
+    const FObjectExport& Entry = GetExportEntry(idx);
     ss << FormatHEX((uint32_t)idx) << " (" << idx << ") ( "
        << FormatHEX((char*)&idx, sizeof(idx)) << "): "
        << Entry.Type << "\'"
@@ -610,40 +940,19 @@ std::string FormatHEX(uint32_t L, uint32_t H)
     return std::string(ch);
 }
 
-std::string FormatHEX(std::vector<char> DataChunk)
+std::string FormatHEX(const std::vector<char>& DataChunk)
 {
-    std::string ret;
-    for (unsigned i = 0; i < DataChunk.size(); ++i)
-    {
-        char ch[255];
-        sprintf(ch, "%02X", (uint8_t)DataChunk[i]);
-        ret += std::string(ch) + " ";
-    }
-    return ret;
+    return EncodeHEX(DataChunk.data(), DataChunk.size());
 }
 
 std::string FormatHEX(char* DataChunk, size_t size)
 {
-    std::string ret;
-    for (unsigned i = 0; i < size; ++i)
-    {
-        char ch[255];
-        sprintf(ch, "%02X", (uint8_t)DataChunk[i]);
-        ret += std::string(ch) + " ";
-    }
-    return ret;
+    return EncodeHEX(DataChunk, size);
 }
 
-std::string FormatHEX(std::string DataString)
+std::string FormatHEX(const std::string& DataString)
 {
-    std::string ret;
-    for (unsigned i = 0; i < DataString.size(); ++i)
-    {
-        char ch[255];
-        sprintf(ch, "%02X", (uint8_t)DataString[i]);
-        ret += std::string(ch) + " ";
-    }
-    return ret;
+    return EncodeHEX(DataString.data(), DataString.size());
 }
 
 /// format flags
@@ -8,8 +8,12 @@
 
 #include <vector>
 #include <iostream>
+#include <unordered_map>
+#include <map>
+#include <mutex>
 
 #include "UFlags.h"
+#include "UPKStringArena.h"
 
 enum class UPKReadErrors
 {
@@ -126,9 +130,10 @@ struct FObjectImport
     /// memory
     size_t           EntryOffset;
     size_t           EntrySize;
-    std::string      Name;
-    std::string      FullName;
-    std::string      Type;
+    /// resolved names are stored in the package string arena
+    UPKString        Name;
+    UPKString        FullName;
+    UPKString        Type;
 };
 
 struct FObjectExport
@@ -151,16 +156,25 @@ struct FObjectExport
     /// memory
     size_t           EntryOffset;
     size_t           EntrySize;
-    std::string      Name;
-    std::string      FullName;
-    std::string      Type;
+    /// resolved names are stored in the package string arena
+    UPKString        Name;
+    UPKString        FullName;
+    UPKString        Type;
+};
+
+/// non-overlapping export serial data segment for offset lookups
+struct FExportRange
+{
+    size_t           Begin;
+    size_t           End;
+    UObjectReference ObjRef;
 };
 
 class UPKInfo
 {
     public:
         /// constructors
-        UPKInfo(): Summary(), NoneIdx(0), ReadError(UPKReadErrors::NoErrors), Compressed(false), CompressedChunk(false), LastAccessedExportObjIdx(0) {};
+        UPKInfo(): Summary(), NoneIdx(0), ReadError(UPKReadErrors::NoErrors), Compressed(false), CompressedChunk(false), OffsetLookupValid(false) {};
         UPKInfo(std::istream& stream);
         /// destructor
         ~UPKInfo() {};
@@ -172,10 +186,11 @@ class UPKInfo
         std::string ObjRefToName(UObjectReference ObjRef);
         std::string ResolveFullName(UObjectReference ObjRef);
         UObjectReference GetOwnerRef(UObjectReference ObjRef);
-        int FindName(std::string name);
-        UObjectReference FindObject(std::string FullName, bool isExport = true);
-        UObjectReference FindObjectByName(std::string Name, bool isExport = true);
+        int FindName(const std::string& name);
+        UObjectReference FindObject(const std::string& FullName, bool isExport = true);
+        UObjectReference FindObjectByName(const std::string& Name, bool isExport = true);
         UObjectReference FindObjectByOffset(size_t offset);
+        std::vector<UObjectReference> FindObjectsByOffsets(const std::vector<size_t>& offsets);
         bool IsNoneIdx(UNameIndex idx) { return (idx.NameTableIdx == NoneIdx); }
         /// Getters
         const FPackageFileSummary& GetSummary() { return Summary; }
@@ -188,7 +203,11 @@ class UPKInfo
         bool IsFullyCompressed() { return (Compressed && CompressedChunk); }
         UPKReadErrors GetError() { return ReadError; }
         uint32_t GetCompressionFlags() { return Summary.CompressionFlags; }
-        UObjectReference GetLastAccessedExportObjIdx() { return LastAccessedExportObjIdx; }
+        /// inner types of array default properties: (owner object, array name) -> inner type
+        /// filled by UDefaultProperty::FindArrayType, cleared when package is re-read or changed
+        bool FindArrayInnerType(UObjectReference OwnerRef, const std::string& ArrName, std::string& InnerType);
+        void AddArrayInnerType(UObjectReference OwnerRef, const std::string& ArrName, const std::string& InnerType);
+        void ClearArrayInnerTypes();
         /// format header to text string
         std::string FormatCompressedHeader();
         std::string FormatSummary();
@@ -199,6 +218,29 @@ class UPKInfo
         std::string FormatImport(uint32_t idx, bool verbose = false);
         std::string FormatExport(uint32_t idx, bool verbose = false);
     protected:
+        /// read single table entry at current stream position
+        void ReadNameEntry(std::istream& stream, FNameEntry& Entry);
+        void ReadImportEntry(std::istream& stream, FObjectImport& Entry);
+        void ReadExportEntry(std::istream& stream, FObjectExport& Entry);
+        /// resolve Name and Type of a table entry
+        void ResolveImportEntry(uint32_t idx);
+        void ResolveExportEntry(uint32_t idx);
+        /// name string stored in the arena
+        UPKString InternName(UNameIndex idx);
+        /// resolve full names of the objects not marked as resolved, owners first
+        void ResolveFullNames(std::vector<char>& ImportResolved, std::vector<char>& ExportResolved);
+        /// re-resolve entries affected by in-place changes of name table entries
+        /// and import/export entries (including owned objects) and update lookups
+        void RefreshResolvedNames(const std::vector<uint32_t>& Names, const std::vector<UObjectReference>& Objects);
+        /// hash lookup tables (first entry wins for duplicated names)
+        void BuildLookupTables();
+        void AddNameLookup(uint32_t idx);
+        void AddImportLookup(uint32_t idx);
+        void AddExportLookup(uint32_t idx);
+        /// non-overlapping export segments sorted by offset
+        /// rebuilt on the next offset lookup after invalidation
+        void BuildOffsetLookup();
+        void InvalidateOffsetLookup() { OffsetLookupValid = false; }
         FPackageFileSummary Summary;
         std::vector<FNameEntry> NameTable;
         std::vector<FObjectImport> ImportTable;
@@ -209,7 +251,18 @@ class UPKInfo
         bool Compressed;
         bool CompressedChunk;
         FCompressedChunkHeader CompressedHeader;
-        UObjectReference LastAccessedExportObjIdx;
+        /// storage of resolved import/export names, kept when package is re-read
+        UPKStringArena Strings;
+        std::vector<UPKString> NameStrings;
+        std::unordered_map<std::string, int> NameLookup;
+        std::unordered_map<UPKString, UObjectReference, UPKInternedStringHash> ImportFullNameLookup;
+        std::unordered_map<UPKString, UObjectReference, UPKInternedStringHash> ExportFullNameLookup;
+        std::unordered_map<UPKString, UObjectReference, UPKInternedStringHash> ImportNameLookup;
+        std::unordered_map<UPKString, UObjectReference, UPKInternedStringHash> ExportNameLookup;
+        std::vector<FExportRange> ExportRanges;
+        bool OffsetLookupValid;
+        std::map<std::pair<UObjectReference, std::string>, std::string> ArrayInnerTypes;
+        std::mutex ArrayInnerTypesMutex;
 };
 
 /// helper functions
@@ -220,9 +273,9 @@ std::string FormatHEX(float val);
 std::string FormatHEX(FGuid GUID);
 std::string FormatHEX(UNameIndex NameIndex);
 std::string FormatHEX(uint32_t L, uint32_t H);
-std::string FormatHEX(std::vector<char> DataChunk);
+std::string FormatHEX(const std::vector<char>& DataChunk);
 std::string FormatHEX(char* DataChunk, size_t size);
-std::string FormatHEX(std::string DataString);
+std::string FormatHEX(const std::string& DataString);
 /// format flags
 std::string FormatPackageFlags(uint32_t flags);
 std::string FormatCompressionFlags(uint32_t flags);
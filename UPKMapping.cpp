@@ -0,0 +1,127 @@
+#include "UPKMapping.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+UPKFileMapping::UPKFileMapping(): Data(nullptr), Size(0)
+{
+#ifdef _WIN32
+    FileHandle = INVALID_HANDLE_VALUE;
+    MappingHandle = nullptr;
+#endif
+}
+
+UPKFileMapping::~UPKFileMapping()
+{
+    Close();
+}
+
+bool UPKFileMapping::Open(const char* filename)
+{
+    Close();
+#ifdef _WIN32
+    FileHandle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (FileHandle == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER FileSize;
+    if (!GetFileSizeEx(FileHandle, &FileSize) || FileSize.QuadPart == 0)
+    {
+        Close();
+        return false;
+    }
+    MappingHandle = CreateFileMappingA(FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (MappingHandle == nullptr)
+    {
+        Close();
+        return false;
+    }
+    Data = reinterpret_cast<const char*>(MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (Data == nullptr)
+    {
+        Close();
+        return false;
+    }
+    Size = FileSize.QuadPart;
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    /// mapping stays valid after the descriptor is closed
+    close(fd);
+    if (addr == MAP_FAILED)
+        return false;
+    Data = reinterpret_cast<const char*>(addr);
+    Size = st.st_size;
+#endif
+    return true;
+}
+
+void UPKFileMapping::Close()
+{
+#ifdef _WIN32
+    if (Data != nullptr)
+        UnmapViewOfFile(Data);
+    if (MappingHandle != nullptr)
+        CloseHandle(MappingHandle);
+    if (FileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle(FileHandle);
+    FileHandle = INVALID_HANDLE_VALUE;
+    MappingHandle = nullptr;
+#else
+    if (Data != nullptr)
+        munmap(const_cast<char*>(Data), Size);
+#endif
+    Data = nullptr;
+    Size = 0;
+}
+
+UPKMemoryStreamBuf::UPKMemoryStreamBuf(const char* data, size_t size)
+{
+    /// get area is never written to
+    char* p = const_cast<char*>(data);
+    setg(p, p, p + size);
+}
+
+UPKMemoryStreamBuf::pos_type UPKMemoryStreamBuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    if (!(which & std::ios_base::in))
+        return pos_type(off_type(-1));
+    off_type base = 0;
+    if (dir == std::ios_base::cur)
+        base = gptr() - eback();
+    else if (dir == std::ios_base::end)
+        base = egptr() - eback();
+    return seekpos(pos_type(base + off), which);
+}
+
+UPKMemoryStreamBuf::pos_type UPKMemoryStreamBuf::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    off_type off = pos;
+    if (!(which & std::ios_base::in) || off < 0 || off > egptr() - eback())
+        return pos_type(off_type(-1));
+    setg(eback(), eback() + off, egptr());
+    return pos;
+}
+
+UPKMemoryStream::UPKMemoryStream(const char* data, size_t size): std::istream(nullptr), Buf(data, size)
+{
+    rdbuf(&Buf);
+}
+
+UPKMemoryStream::UPKMemoryStream(UPKDataView view): std::istream(nullptr), Buf(view.Data, view.Size)
+{
+    rdbuf(&Buf);
+}
@@ -0,0 +1,59 @@
+#ifndef UPKMAPPING_H
+#define UPKMAPPING_H
+
+#include <istream>
+#include <streambuf>
+#include <cstddef>
+
+/// non-owning view of a contiguous block of package data
+struct UPKDataView
+{
+    const char* Data;
+    size_t      Size;
+};
+
+/// read-only memory mapping of a whole file
+class UPKFileMapping
+{
+public:
+    UPKFileMapping();
+    ~UPKFileMapping();
+    bool Open(const char* filename);
+    void Close();
+    bool IsOpen() { return (Data != nullptr); }
+    const char* GetData() { return Data; }
+    size_t GetSize() { return Size; }
+private:
+    /// mapping can not be copied
+    UPKFileMapping(const UPKFileMapping&);
+    UPKFileMapping& operator=(const UPKFileMapping&);
+    const char* Data;
+    size_t Size;
+#ifdef _WIN32
+    void* FileHandle;
+    void* MappingHandle;
+#endif
+};
+
+/// read-only seekable stream buffer over a memory block
+/// stream positions are offsets from the beginning of the block
+class UPKMemoryStreamBuf: public std::streambuf
+{
+public:
+    UPKMemoryStreamBuf(const char* data, size_t size);
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::in);
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in);
+};
+
+/// input stream over a memory block: reads data without copying it
+class UPKMemoryStream: public std::istream
+{
+public:
+    UPKMemoryStream(const char* data, size_t size);
+    UPKMemoryStream(UPKDataView view);
+private:
+    UPKMemoryStreamBuf Buf;
+};
+
+#endif // UPKMAPPING_H
@@ -0,0 +1,220 @@
+#include "UPKStringArena.h"
+
+#include <cstring>
+#include <algorithm>
+
+size_t UPKString::find(const char* str, size_t pos) const
+{
+    if (pos > Length)
+        return std::string::npos;
+    const char* end = Data + Length;
+    const char* it = std::search(Data + pos, end, str, str + strlen(str));
+    return (it == end && *str != '\0' ? std::string::npos : it - Data);
+}
+
+static bool Equals(const char* a, size_t alen, const char* b, size_t blen)
+{
+    return (alen == blen && (alen == 0 || a == b || memcmp(a, b, alen) == 0));
+}
+
+bool operator==(const UPKString& a, const UPKString& b)
+{
+    return Equals(a.data(), a.size(), b.data(), b.size());
+}
+
+bool operator==(const UPKString& a, const std::string& b)
+{
+    return Equals(a.data(), a.size(), b.data(), b.size());
+}
+
+bool operator==(const std::string& a, const UPKString& b)
+{
+    return (b == a);
+}
+
+bool operator==(const UPKString& a, const char* b)
+{
+    return Equals(a.data(), a.size(), b, strlen(b));
+}
+
+bool operator==(const char* a, const UPKString& b)
+{
+    return (b == a);
+}
+
+bool operator!=(const UPKString& a, const UPKString& b)
+{
+    return !(a == b);
+}
+
+bool operator!=(const UPKString& a, const std::string& b)
+{
+    return !(a == b);
+}
+
+bool operator!=(const std::string& a, const UPKString& b)
+{
+    return !(b == a);
+}
+
+bool operator!=(const UPKString& a, const char* b)
+{
+    return !(a == b);
+}
+
+bool operator!=(const char* a, const UPKString& b)
+{
+    return !(b == a);
+}
+
+bool operator<(const UPKString& a, const UPKString& b)
+{
+    int cmp = memcmp(a.data(), b.data(), std::min(a.size(), b.size()));
+    return (cmp < 0 || (cmp == 0 && a.size() < b.size()));
+}
+
+std::string operator+(const UPKString& a, const UPKString& b)
+{
+    std::string ret;
+    ret.reserve(a.size() + b.size());
+    ret.append(a.data(), a.size());
+    ret.append(b.data(), b.size());
+    return ret;
+}
+
+std::string operator+(const UPKString& a, const std::string& b)
+{
+    return a + UPKString(b.data(), b.size());
+}
+
+std::string operator+(const std::string& a, const UPKString& b)
+{
+    return UPKString(a.data(), a.size()) + b;
+}
+
+std::string operator+(const UPKString& a, const char* b)
+{
+    return a + UPKString(b, strlen(b));
+}
+
+std::string operator+(const char* a, const UPKString& b)
+{
+    return UPKString(a, strlen(a)) + b;
+}
+
+std::string operator+(const UPKString& a, char b)
+{
+    return a + UPKString(&b, 1);
+}
+
+std::string operator+(char a, const UPKString& b)
+{
+    return UPKString(&a, 1) + b;
+}
+
+std::string& operator+=(std::string& a, const UPKString& b)
+{
+    return a.append(b.data(), b.size());
+}
+
+std::ostream& operator<<(std::ostream& out, const UPKString& str)
+{
+    return out.write(str.data(), str.size());
+}
+
+size_t UPKStringHash::operator()(const UPKString& str) const
+{
+    /// 8 bytes at a time: full names of deeply nested objects are long
+    const char* data = str.data();
+    size_t size = str.size();
+    uint64_t hash = 0xcbf29ce484222325ULL ^ size;
+    uint64_t word = 0;
+    for (; size >= 8; data += 8, size -= 8)
+    {
+        memcpy(&word, data, 8);
+        hash = (hash ^ word) * 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+    word = 0;
+    memcpy(&word, data, size);
+    hash = (hash ^ word) * 0x100000001b3ULL;
+    hash ^= hash >> 29;
+    return (size_t)hash;
+}
+
+void UPKStringArena::Reserve(size_t count)
+{
+    size_t size = 16;
+    while (size < 2 * count)
+        size *= 2;
+    if (size > Slots.size())
+        Rehash(size);
+}
+
+void UPKStringArena::Rehash(size_t size)
+{
+    Slot Empty = { UPKString(nullptr, 0), 0 };
+    std::vector<Slot> OldSlots(size, Empty);
+    OldSlots.swap(Slots);
+    for (size_t i = 0; i < OldSlots.size(); ++i)
+    {
+        if (OldSlots[i].Str.data() == nullptr)
+            continue;
+        size_t pos = OldSlots[i].Hash & (Slots.size() - 1);
+        while (Slots[pos].Str.data() != nullptr)
+            pos = (pos + 1) & (Slots.size() - 1);
+        Slots[pos] = OldSlots[i];
+    }
+}
+
+UPKString UPKStringArena::Find(const char* data, size_t length) const
+{
+    UPKString str(data, length);
+    if (Slots.empty())
+        return UPKString(nullptr, 0);
+    size_t hash = UPKStringHash()(str);
+    for (size_t pos = hash & (Slots.size() - 1); Slots[pos].Str.data() != nullptr; pos = (pos + 1) & (Slots.size() - 1))
+    {
+        if (Slots[pos].Hash == hash && Slots[pos].Str == str)
+            return Slots[pos].Str;
+    }
+    return UPKString(nullptr, 0);
+}
+
+UPKString UPKStringArena::Intern(const char* data, size_t length)
+{
+    UPKString str(data, length);
+    if (2 * (Count + 1) > Slots.size())
+        Rehash(Slots.empty() ? 16 : 2 * Slots.size());
+    size_t hash = UPKStringHash()(str);
+    size_t pos = hash & (Slots.size() - 1);
+    for (; Slots[pos].Str.data() != nullptr; pos = (pos + 1) & (Slots.size() - 1))
+    {
+        if (Slots[pos].Hash == hash && Slots[pos].Str == str)
+            return Slots[pos].Str;
+    }
+    /// long strings get their own blocks, current block is kept
+    char* dest = nullptr;
+    if (length + 1 > BlockSize / 4)
+    {
+        Blocks.emplace_back(new char[length + 1]);
+        dest = Blocks.back().get();
+    }
+    else
+    {
+        if (BlockUsed + length + 1 > BlockSize)
+        {
+            Blocks.emplace_back(new char[BlockSize]);
+            Block = Blocks.back().get();
+            BlockUsed = 0;
+        }
+        dest = Block + BlockUsed;
+        BlockUsed += length + 1;
+    }
+    memcpy(dest, data, length);
+    dest[length] = '\0';
+    Slots[pos].Str = UPKString(dest, length);
+    Slots[pos].Hash = hash;
+    ++Count;
+    return Slots[pos].Str;
+}
@@ -0,0 +1,100 @@
+#ifndef UPKSTRINGARENA_H
+#define UPKSTRINGARENA_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <iostream>
+#include <cstddef>
+#include <cstdint>
+
+/// read-only handle of a string stored in UPKStringArena
+/// compared, concatenated and printed as std::string and converted to it implicitly
+/// handle is valid while the arena, which owns the string, exists
+class UPKString
+{
+public:
+    UPKString(): Data(""), Length(0) {}
+    UPKString(const char* data, size_t length): Data(data), Length(length) {}
+    const char* c_str() const { return Data; }
+    const char* data() const { return Data; }
+    size_t size() const { return Length; }
+    size_t length() const { return Length; }
+    bool empty() const { return (Length == 0); }
+    char operator[](size_t pos) const { return Data[pos]; }
+    /// position of str or std::string::npos
+    size_t find(const char* str, size_t pos = 0) const;
+    std::string str() const { return std::string(Data, Length); }
+    operator std::string() const { return str(); }
+private:
+    const char* Data;
+    size_t Length;
+};
+
+bool operator==(const UPKString& a, const UPKString& b);
+bool operator==(const UPKString& a, const std::string& b);
+bool operator==(const std::string& a, const UPKString& b);
+bool operator==(const UPKString& a, const char* b);
+bool operator==(const char* a, const UPKString& b);
+bool operator!=(const UPKString& a, const UPKString& b);
+bool operator!=(const UPKString& a, const std::string& b);
+bool operator!=(const std::string& a, const UPKString& b);
+bool operator!=(const UPKString& a, const char* b);
+bool operator!=(const char* a, const UPKString& b);
+bool operator<(const UPKString& a, const UPKString& b);
+std::string operator+(const UPKString& a, const UPKString& b);
+std::string operator+(const UPKString& a, const std::string& b);
+std::string operator+(const std::string& a, const UPKString& b);
+std::string operator+(const UPKString& a, const char* b);
+std::string operator+(const char* a, const UPKString& b);
+std::string operator+(const UPKString& a, char b);
+std::string operator+(char a, const UPKString& b);
+std::string& operator+=(std::string& a, const UPKString& b);
+std::ostream& operator<<(std::ostream& out, const UPKString& str);
+
+/// FNV based hash of string data
+struct UPKStringHash
+{
+    size_t operator()(const UPKString& str) const;
+};
+
+/// hash of interned string: strings of the same arena are equal only if they share data
+struct UPKInternedStringHash
+{
+    size_t operator()(const UPKString& str) const { return std::hash<const char*>()(str.data()); }
+};
+
+/// append-only storage of interned strings: each distinct string is stored once,
+/// zero-terminated, in large blocks
+/// strings are never removed, so handles stay valid and re-read names are reused
+class UPKStringArena
+{
+public:
+    UPKStringArena(): Block(nullptr), BlockUsed(BlockSize), Count(0) {}
+    /// find stored string or store a new one
+    UPKString Intern(const char* data, size_t length);
+    UPKString Intern(const std::string& str) { return Intern(str.data(), str.size()); }
+    UPKString Intern(const UPKString& str) { return Intern(str.data(), str.size()); }
+    /// find stored string, returns handle with null data if string is not stored
+    UPKString Find(const char* data, size_t length) const;
+    UPKString Find(const std::string& str) const { return Find(str.data(), str.size()); }
+    /// prepare for the given number of distinct strings
+    void Reserve(size_t count);
+private:
+    /// open addressing hash table slot, empty slots have no data
+    struct Slot
+    {
+        UPKString Str;
+        size_t Hash;
+    };
+    void Rehash(size_t size);
+    static const size_t BlockSize = 0x10000;
+    std::vector<std::unique_ptr<char[]>> Blocks;
+    char* Block;                    /// current block for short strings
+    size_t BlockUsed;
+    std::vector<Slot> Slots;        /// power of two size, at most half full
+    size_t Count;
+};
+
+#endif // UPKSTRINGARENA_H
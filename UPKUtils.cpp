@@ -1,14 +1,44 @@
 #include "UPKUtils.h"
+#include "DataSearch.h"
+#include "ModPlan.h"
 
+#include <cstdio>
 #include <cstring>
 #include <sstream>
+#include <algorithm>
+#include <iterator>
+
+#ifdef _WIN32
+/// keep std::min and std::max usable
+#define NOMINMAX
+#include <windows.h>
+#endif
 
 uint8_t PatchUPKhash [] = {0x7A, 0xA0, 0x56, 0xC9,
                            0x60, 0x5F, 0x7B, 0x31,
                            0x72, 0x5D, 0x4B, 0xC4,
                            0x7C, 0xD2, 0x4D, 0xD9 };
 
-UPKUtils::UPKUtils(const char* filename)
+static void SerializeSummary(FPackageFileSummary Summary, std::ostream& ss);
+
+/// buffer size for moving serialized data
+static const size_t ShiftBufferSize = 1024 * 1024;
+/// block size for searching package data
+static const size_t SearchBlockSize = 1024 * 1024;
+
+/// replace file "to" with file "from" in a single step: if the program is interrupted,
+/// "to" is either the old file or the new one
+static bool ReplaceFileAtomically(const char* from, const char* to)
+{
+#ifdef _WIN32
+    /// rename can not replace existing files on Windows
+    return (MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0);
+#else
+    return (std::rename(from, to) == 0);
+#endif
+}
+
+UPKUtils::UPKUtils(const char* filename): HeaderBatchActive(false), WriteBuffering(false), TransactionActive(false), UndoRecords(nullptr)
 {
     if (UPKUtils::Read(filename) == false && UPKFile.is_open())
     {
@@ -18,7 +48,14 @@ UPKUtils::UPKUtils(const char* filename)
 
 bool UPKUtils::Read(const char* filename)
 {
+    /// undo records belong to the package they were recorded for
+    SetUndoRecords(nullptr);
+    DiscardTransaction();
+    FlushWrites();
     UPKFileName = filename;
+    HeaderBatchActive = false;
+    Mapping.Close();
+    CompressedImage.Close();
     if (UPKFile.is_open())
     {
         UPKFile.close();
@@ -27,6 +64,28 @@ bool UPKUtils::Read(const char* filename)
     UPKFile.open(UPKFileName, std::ios::binary | std::ios::in | std::ios::out);
     if (!UPKFile.is_open())
         return false;
+    if (!RecoverCommit())
+        return false;
+    return UPKUtils::Reload();
+}
+
+bool UPKUtils::ReadMapped(const char* filename)
+{
+    DiscardTransaction();
+    FlushWrites();
+    UPKFileName = filename;
+    HeaderBatchActive = false;
+    CompressedImage.Close();
+    if (UPKFile.is_open())
+    {
+        UPKFile.close();
+        UPKFile.clear();
+    }
+    if (!Mapping.Open(filename))
+    {
+        ReadError = UPKReadErrors::FileError;
+        return false;
+    }
     return UPKUtils::Reload();
 }
 
@@ -34,11 +93,92 @@ bool UPKUtils::Reload()
 {
     if (!IsLoaded())
         return false;
-    UPKFile.clear();
-    UPKFile.seekg(0, std::ios::end);
-    UPKFileSize = UPKFile.tellg();
-    UPKFile.seekg(0);
-    return UPKInfo::Read(UPKFile);
+    /// buffered writes stay in memory, package is read through them
+    if (IsCompressedMode())
+    {
+        FPackageFileSummary CompressedSummary = Summary;
+        UPKFileSize = CompressedImage.GetSize();
+        UPKCompressedStream stream(CompressedImage);
+        if (!UPKInfo::Read(stream))
+            return false;
+        /// keep compression info of the package file
+        Summary.PackageFlags = CompressedSummary.PackageFlags;
+        Summary.CompressionFlags = CompressedSummary.CompressionFlags;
+        Summary.NumCompressedChunks = CompressedSummary.NumCompressedChunks;
+        Summary.CompressedChunks = CompressedSummary.CompressedChunks;
+        Compressed = true;
+        return true;
+    }
+    bool ret = false;
+    if (IsMapped())
+    {
+        UPKFileSize = Mapping.GetSize();
+        UPKMemoryStream stream(Mapping.GetData(), Mapping.GetSize());
+        ret = UPKInfo::Read(stream);
+    }
+    else
+    {
+        UPKFile.clear();
+        UPKFile.seekg(0, std::ios::end);
+        UPKFileSize = UPKFile.tellg();
+        UPKFile.seekg(0);
+        if (PendingWrites.empty())
+        {
+            ret = UPKInfo::Read(UPKFile);
+        }
+        else
+        {
+            UPKOverlayStreamBuf Buf(*this);
+            std::istream stream(&Buf);
+            ret = UPKInfo::Read(stream);
+            UPKFile.clear();
+        }
+    }
+    if (ret == false && ReadError == UPKReadErrors::IsCompressed &&
+        Summary.CompressionFlags == (uint32_t)UCompressionFlags::LZO)
+    {
+        return ReadCompressed();
+    }
+    return ret;
+}
+
+bool UPKUtils::ReadCompressed()
+{
+    /// image starts with uncompressed summary, the same as in decompressed package
+    FPackageFileSummary UncompressedSummary = Summary;
+    UncompressedSummary.PackageFlags &= ~(uint32_t)UPackageFlags::Compressed;
+    UncompressedSummary.CompressionFlags = 0;
+    UncompressedSummary.NumCompressedChunks = 0;
+    UncompressedSummary.CompressedChunks.clear();
+    std::stringstream ss;
+    SerializeSummary(UncompressedSummary, ss);
+    std::string summaryStr = ss.str();
+    std::vector<char> summaryData(summaryStr.begin(), summaryStr.end());
+    Mapping.Close();
+    if (UPKFile.is_open())
+    {
+        UPKFile.close();
+        UPKFile.clear();
+    }
+    if (!CompressedImage.Open(UPKFileName.c_str(), Summary.CompressedChunks, summaryData))
+        return false;
+    if (!UPKUtils::Reload())
+    {
+        CompressedImage.Close();
+        return false;
+    }
+    return true;
+}
+
+const char* UPKUtils::GetReadOnlyData(size_t offset, size_t size)
+{
+    if (offset > UPKFileSize || size > UPKFileSize - offset)
+        return nullptr;
+    if (IsMapped())
+        return Mapping.GetData() + offset;
+    if (IsCompressedMode() && CompressedImage.Load(offset, size))
+        return CompressedImage.GetData() + offset;
+    return nullptr;
 }
 
 std::vector<char> UPKUtils::GetExportData(uint32_t idx)
@@ -46,13 +186,35 @@ std::vector<char> UPKUtils::GetExportData(uint32_t idx)
     std::vector<char> data;
     if (idx < 1 || idx >= ExportTable.size())
         return data;
+    if (IsReadOnly())
+    {
+        UPKDataView view = GetExportDataView(idx);
+        data.assign(view.Data, view.Data + view.Size);
+        return data;
+    }
     data.resize(ExportTable[idx].SerialSize);
-    UPKFile.seekg(ExportTable[idx].SerialOffset);
-    UPKFile.read(data.data(), data.size());
-    LastAccessedExportObjIdx = idx;
+    ReadData(ExportTable[idx].SerialOffset, data.data(), data.size());
     return data;
 }
 
+UPKDataView UPKUtils::GetExportDataView(uint32_t idx)
+{
+    UPKDataView view = {nullptr, 0};
+    if (!IsReadOnly() || idx < 1 || idx >= ExportTable.size())
+        return view;
+    /// clip bad entries to package data
+    size_t offset = ExportTable[idx].SerialOffset;
+    if (offset >= UPKFileSize)
+        return view;
+    size_t size = std::min<size_t>(ExportTable[idx].SerialSize, UPKFileSize - offset);
+    const char* data = GetReadOnlyData(offset, size);
+    if (data == nullptr)
+        return view;
+    view.Data = data;
+    view.Size = size;
+    return view;
+}
+
 void UPKUtils::SaveExportData(uint32_t idx)
 {
     if (idx < 1 || idx >= ExportTable.size())
@@ -66,14 +228,19 @@ void UPKUtils::SaveExportData(uint32_t idx)
 /// relatively safe behavior (old realization)
 bool UPKUtils::MoveExportData(uint32_t idx, uint32_t newObjectSize)
 {
+    if (IsReadOnly())
+        return false;
     if (idx < 1 || idx >= ExportTable.size())
         return false;
+    if (!BeginFileWrite())
+        return false;
     std::vector<char> data = GetExportData(idx);
     UPKFile.seekg(0, std::ios::end);
     uint32_t newObjectOffset = UPKFile.tellg();
     bool isFunction = (ExportTable[idx].Type == "Function");
     if (newObjectSize > ExportTable[idx].SerialSize)
     {
+        RecordUndo(ExportTable[idx].EntryOffset + sizeof(uint32_t)*8, sizeof(newObjectSize));
         UPKFile.seekp(ExportTable[idx].EntryOffset + sizeof(uint32_t)*8);
         UPKFile.write(reinterpret_cast<char*>(&newObjectSize), sizeof(newObjectSize));
         unsigned int diffSize = newObjectSize - data.size();
@@ -101,6 +268,8 @@ bool UPKUtils::MoveExportData(uint32_t idx, uint32_t newObjectSize)
             data = newData;
         }
     }
+    RecordUndo(ExportTable[idx].EntryOffset + sizeof(uint32_t)*9, sizeof(newObjectOffset));
+    RecordUndo(newObjectOffset, data.size() + 16 + sizeof(uint32_t)*2);
     UPKFile.seekp(ExportTable[idx].EntryOffset + sizeof(uint32_t)*9);
     UPKFile.write(reinterpret_cast<char*>(&newObjectOffset), sizeof(newObjectOffset));
     UPKFile.seekp(newObjectOffset);
@@ -109,29 +278,33 @@ bool UPKUtils::MoveExportData(uint32_t idx, uint32_t newObjectSize)
     UPKFile.write(reinterpret_cast<char*>(&PatchUPKhash[0]), 16);
     UPKFile.write(reinterpret_cast<char*>(&ExportTable[idx].SerialSize), sizeof(ExportTable[idx].SerialSize));
     UPKFile.write(reinterpret_cast<char*>(&ExportTable[idx].SerialOffset), sizeof(ExportTable[idx].SerialOffset));
-    /// reload package
-    UPKUtils::Reload();
+    /// update export table entry
+    if (newObjectSize > ExportTable[idx].SerialSize)
+        ExportTable[idx].SerialSize = newObjectSize;
+    ExportTable[idx].SerialOffset = newObjectOffset;
+    RefreshFileSize();
+    InvalidateOffsetLookup();
     return true;
 }
 
 bool UPKUtils::UndoMoveExportData(uint32_t idx)
 {
+    if (IsReadOnly())
+        return false;
     if (idx < 1 || idx >= ExportTable.size())
         return false;
-    UPKFile.seekg(ExportTable[idx].SerialOffset + ExportTable[idx].SerialSize);
-    uint8_t readHash [16];
-    UPKFile.read(reinterpret_cast<char*>(&readHash[0]), 16);
-    if (memcmp(readHash, PatchUPKhash, 16) != 0)
-        return false;
-    uint32_t oldObjectFileSize, oldObjectOffset;
-    UPKFile.read(reinterpret_cast<char*>(&oldObjectFileSize), sizeof(oldObjectFileSize));
-    UPKFile.read(reinterpret_cast<char*>(&oldObjectOffset), sizeof(oldObjectOffset));
-    UPKFile.seekp(ExportTable[idx].EntryOffset + sizeof(uint32_t)*8);
-    UPKFile.write(reinterpret_cast<char*>(&oldObjectFileSize), sizeof(oldObjectFileSize));
-    UPKFile.write(reinterpret_cast<char*>(&oldObjectOffset), sizeof(oldObjectOffset));
-    /// reload package
-    UPKUtils::Reload();
-    return true;
+    /// hash + old size + old offset
+    std::vector<char> backupInfo(16 + sizeof(uint32_t)*2);
+    UPKFile.clear();
+    if (!ReadData(ExportTable[idx].SerialOffset + ExportTable[idx].SerialSize, backupInfo.data(), backupInfo.size()))
+    {
+        UPKFile.clear();
+        return false;
+    }
+    if (memcmp(backupInfo.data(), PatchUPKhash, 16) != 0)
+        return false;
+    /// export table entry is updated by header refresh
+    return WriteData(ExportTable[idx].EntryOffset + sizeof(uint32_t)*8, std::vector<char>(backupInfo.begin() + 16, backupInfo.end()));
 }
 
 std::vector<char> UPKUtils::GetResizedDataChunk(uint32_t idx, int newObjectSize, int resizeAt)
@@ -167,8 +340,12 @@ std::vector<char> UPKUtils::GetResizedDataChunk(uint32_t idx, int newObjectSize,
 
 bool UPKUtils::MoveResizeObject(uint32_t idx, int newObjectSize, int resizeAt)
 {
+    if (IsReadOnly())
+        return false;
     if (idx < 1 || idx >= ExportTable.size())
         return false;
+    if (!BeginFileWrite())
+        return false;
     std::vector<char> data = GetResizedDataChunk(idx, newObjectSize, resizeAt);
     /// move write pointer to the end of file
     UPKFile.seekg(0, std::ios::end);
@@ -177,10 +354,13 @@ bool UPKUtils::MoveResizeObject(uint32_t idx, int newObjectSize, int resizeAt)
     if (ExportTable[idx].SerialSize != data.size())
     {
         /// write new SerialSize to ExportTable entry
+        RecordUndo(ExportTable[idx].EntryOffset + sizeof(uint32_t)*8, sizeof(newObjectSize));
         UPKFile.seekp(ExportTable[idx].EntryOffset + sizeof(uint32_t)*8);
         UPKFile.write(reinterpret_cast<char*>(&newObjectSize), sizeof(newObjectSize));
     }
     /// write new SerialOffset to ExportTable entry
+    RecordUndo(ExportTable[idx].EntryOffset + sizeof(uint32_t)*9, sizeof(newObjectOffset));
+    RecordUndo(newObjectOffset, data.size() + 16 + sizeof(uint32_t)*2);
     UPKFile.seekp(ExportTable[idx].EntryOffset + sizeof(uint32_t)*9);
     UPKFile.write(reinterpret_cast<char*>(&newObjectOffset), sizeof(newObjectOffset));
     /// write new SerialData
@@ -193,8 +373,11 @@ bool UPKUtils::MoveResizeObject(uint32_t idx, int newObjectSize, int resizeAt)
     UPKFile.write(reinterpret_cast<char*>(&PatchUPKhash[0]), 16);
     UPKFile.write(reinterpret_cast<char*>(&ExportTable[idx].SerialSize), sizeof(ExportTable[idx].SerialSize));
     UPKFile.write(reinterpret_cast<char*>(&ExportTable[idx].SerialOffset), sizeof(ExportTable[idx].SerialOffset));
-    /// reload package
-    UPKUtils::Reload();
+    /// update export table entry
+    ExportTable[idx].SerialSize = data.size();
+    ExportTable[idx].SerialOffset = newObjectOffset;
+    RefreshFileSize();
+    InvalidateOffsetLookup();
     return true;
 }
 
@@ -218,19 +401,83 @@ std::string UPKUtils::Deserialize(UObjectReference ObjRef, bool TryUnsafe, bool
     }
     if (Obj == nullptr)
         return "Can't create object of given type!\n";
-    std::string res;
-    UPKFile.seekg(ExportTable[ObjRef].SerialOffset);
+    std::string res = DeserializeObject(Obj, ObjRef, TryUnsafe, QuickMode);
+    delete Obj;
+    return res;
+}
+
+std::string UPKUtils::DeserializeObject(UObject* Obj, UObjectReference ObjRef, bool TryUnsafe, bool QuickMode)
+{
     Obj->SetRef(ObjRef);
     Obj->SetUnsafe(TryUnsafe);
     Obj->SetQuickMode(QuickMode);
-    res = Obj->Deserialize(UPKFile, *dynamic_cast<UPKInfo*>(this));
-    delete Obj;
+    if (IsMapped())
+    {
+        /// each call gets its own stream, so mapped package can be read by several threads
+        UPKMemoryStream stream(Mapping.GetData(), Mapping.GetSize());
+        stream.seekg(ExportTable[ObjRef].SerialOffset);
+        return Obj->Deserialize(stream, *dynamic_cast<UPKInfo*>(this));
+    }
+    if (IsCompressedMode())
+    {
+        /// compressed image is thread-safe too
+        UPKCompressedStream stream(CompressedImage);
+        stream.seekg(ExportTable[ObjRef].SerialOffset);
+        return Obj->Deserialize(stream, *dynamic_cast<UPKInfo*>(this));
+    }
+    if (PendingWrites.empty())
+    {
+        UPKFile.seekg(ExportTable[ObjRef].SerialOffset);
+        return Obj->Deserialize(UPKFile, *dynamic_cast<UPKInfo*>(this));
+    }
+    /// buffered writes are read from memory, package file is not written to
+    UPKOverlayStreamBuf Buf(*this);
+    std::istream stream(&Buf);
+    stream.seekg(ExportTable[ObjRef].SerialOffset);
+    std::string res = Obj->Deserialize(stream, *dynamic_cast<UPKInfo*>(this));
+    UPKFile.clear();
     return res;
 }
 
+bool UPKUtils::DecodeObject(UObject* Obj, UObjectReference ObjRef, bool TryUnsafe, bool QuickMode)
+{
+    if (Obj == nullptr || ObjRef < 1 || ObjRef >= (int)ExportTable.size())
+        return false;
+    Obj->SetRef(ObjRef);
+    Obj->SetUnsafe(TryUnsafe);
+    Obj->SetQuickMode(QuickMode);
+    if (IsMapped())
+    {
+        UPKMemoryStream stream(Mapping.GetData(), Mapping.GetSize());
+        stream.seekg(ExportTable[ObjRef].SerialOffset);
+        return Obj->Decode(stream, *dynamic_cast<UPKInfo*>(this));
+    }
+    if (IsCompressedMode())
+    {
+        UPKCompressedStream stream(CompressedImage);
+        stream.seekg(ExportTable[ObjRef].SerialOffset);
+        return Obj->Decode(stream, *dynamic_cast<UPKInfo*>(this));
+    }
+    bool result = false;
+    if (PendingWrites.empty())
+    {
+        UPKFile.seekg(ExportTable[ObjRef].SerialOffset);
+        result = Obj->Decode(UPKFile, *dynamic_cast<UPKInfo*>(this));
+    }
+    else
+    {
+        UPKOverlayStreamBuf Buf(*this);
+        std::istream stream(&Buf);
+        stream.seekg(ExportTable[ObjRef].SerialOffset);
+        result = Obj->Decode(stream, *dynamic_cast<UPKInfo*>(this));
+    }
+    UPKFile.clear();
+    return result;
+}
+
 bool UPKUtils::CheckValidFileOffset(size_t offset)
 {
-    if (IsLoaded() == false)
+    if (IsLoaded() == false || IsReadOnly())
     {
         return false;
     }
@@ -240,58 +487,489 @@ bool UPKUtils::CheckValidFileOffset(size_t offset)
 
 bool UPKUtils::WriteExportData(uint32_t idx, std::vector<char> data, std::vector<char> *backupData)
 {
+    if (IsReadOnly())
+        return false;
     if (idx < 1 || idx >= ExportTable.size())
         return false;
     if (!IsLoaded())
         return false;
     if (ExportTable[idx].SerialSize != data.size())
         return false;
-    if (backupData != nullptr)
-    {
-        backupData->clear();
-        backupData->resize(data.size());
-        UPKFile.seekg(ExportTable[idx].SerialOffset);
-        UPKFile.read(backupData->data(), backupData->size());
-    }
-    UPKFile.seekp(ExportTable[idx].SerialOffset);
-    UPKFile.write(data.data(), data.size());
-    return true;
+    return WriteData(ExportTable[idx].SerialOffset, data, backupData);
 }
 
 bool UPKUtils::WriteNameTableName(uint32_t idx, std::string name)
 {
+    if (IsReadOnly())
+        return false;
     if (idx < 1 || idx >= NameTable.size())
         return false;
     if (!IsLoaded())
         return false;
     if ((unsigned)(NameTable[idx].NameLength - 1) != name.length())
         return false;
-    UPKFile.seekp(NameTable[idx].EntryOffset + sizeof(NameTable[idx].NameLength));
-    UPKFile.write(name.c_str(), name.length());
-    /// reload package
-    UPKUtils::Reload();
-    return true;
+    /// header refresh updates name and all the entries, which use it
+    return WriteData(NameTable[idx].EntryOffset + sizeof(NameTable[idx].NameLength), std::vector<char>(name.begin(), name.end()));
 }
 
 bool UPKUtils::WriteData(size_t offset, std::vector<char> data, std::vector<char> *backupData)
 {
     if (!CheckValidFileOffset(offset))
         return false;
+    /// writes, which do not change package size, are buffered in transactions
+    /// serialized data writes are buffered with write buffering
+    bool isBuffered = (offset + data.size() <= UPKFileSize && (TransactionActive || (WriteBuffering && offset >= Summary.SerialOffset)));
+    if (!isBuffered && !BeginFileWrite())
+    {
+        return false;
+    }
     if (backupData != nullptr)
     {
         backupData->clear();
         backupData->resize(data.size());
-        UPKFile.seekg(offset);
-        UPKFile.read(backupData->data(), backupData->size());
+        ReadData(offset, backupData->data(), backupData->size());
+    }
+    RecordUndo(offset, data.size());
+    /// written data may change array properties
+    ClearArrayInnerTypes();
+    if (isBuffered)
+    {
+        AddPendingWrite(offset, data);
+        if (offset < Summary.SerialOffset)
+            return RefreshHeader(offset, data.size());
+        return true;
     }
     UPKFile.seekp(offset);
     UPKFile.write(data.data(), data.size());
+    if (offset + data.size() > UPKFileSize)
+    {
+        RefreshFileSize();
+    }
     /// if changed header
     if (offset < Summary.SerialOffset)
     {
-        /// reload package
+        return RefreshHeader(offset, data.size());
+    }
+    return true;
+}
+
+bool UPKUtils::ReadData(size_t offset, char* data, size_t size)
+{
+    UPKFile.seekg(offset);
+    UPKFile.read(data, size);
+    bool ret = UPKFile.good();
+    /// put buffered data over file data
+    std::map<size_t, std::vector<char>>::iterator it = PendingWrites.upper_bound(offset);
+    if (it != PendingWrites.begin())
+        --it;
+    for (; it != PendingWrites.end() && it->first < offset + size; ++it)
+    {
+        size_t beg = std::max(it->first, offset);
+        size_t end = std::min(it->first + it->second.size(), offset + size);
+        if (beg < end)
+            memcpy(data + (beg - offset), it->second.data() + (beg - it->first), end - beg);
+    }
+    return ret;
+}
+
+/// chunk size is small: objects are read one by one
+const size_t OverlayChunkSize = 4096;
+
+UPKOverlayStreamBuf::UPKOverlayStreamBuf(UPKUtils& package): Package(package), BufferOffset(0)
+{
+    setg(nullptr, nullptr, nullptr);
+}
+
+UPKOverlayStreamBuf::int_type UPKOverlayStreamBuf::underflow()
+{
+    size_t pos = BufferOffset + (gptr() - eback());
+    if (pos >= Package.UPKFileSize)
+        return traits_type::eof();
+    Buffer.resize(std::min(OverlayChunkSize, Package.UPKFileSize - pos));
+    bool ret = Package.ReadData(pos, Buffer.data(), Buffer.size());
+    Package.UPKFile.clear();
+    if (!ret)
+    {
+        setg(nullptr, nullptr, nullptr);
+        BufferOffset = pos;
+        return traits_type::eof();
+    }
+    BufferOffset = pos;
+    setg(Buffer.data(), Buffer.data(), Buffer.data() + Buffer.size());
+    return traits_type::to_int_type(*gptr());
+}
+
+UPKOverlayStreamBuf::pos_type UPKOverlayStreamBuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    if (!(which & std::ios_base::in))
+        return pos_type(off_type(-1));
+    off_type base = 0;
+    if (dir == std::ios_base::cur)
+        base = BufferOffset + (gptr() - eback());
+    else if (dir == std::ios_base::end)
+        base = Package.UPKFileSize;
+    return seekpos(pos_type(base + off), which);
+}
+
+UPKOverlayStreamBuf::pos_type UPKOverlayStreamBuf::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    off_type off = pos;
+    if (!(which & std::ios_base::in) || off < 0 || (size_t)off > Package.UPKFileSize)
+        return pos_type(off_type(-1));
+    /// position inside current chunk: no re-reading
+    if ((size_t)off >= BufferOffset && (size_t)off < BufferOffset + (egptr() - eback()))
+    {
+        setg(eback(), eback() + (off - BufferOffset), egptr());
+    }
+    else
+    {
+        BufferOffset = off;
+        setg(nullptr, nullptr, nullptr);
+    }
+    return pos;
+}
+
+void UPKUtils::AddPendingWrite(size_t offset, const std::vector<char>& data)
+{
+    size_t beg = offset, end = offset + data.size();
+    /// find overlapping and adjacent extents
+    std::map<size_t, std::vector<char>>::iterator first = PendingWrites.upper_bound(offset);
+    if (first != PendingWrites.begin())
+    {
+        std::map<size_t, std::vector<char>>::iterator prev = std::prev(first);
+        if (prev->first + prev->second.size() >= offset)
+            first = prev;
+    }
+    std::map<size_t, std::vector<char>>::iterator last = first;
+    for (; last != PendingWrites.end() && last->first <= end; ++last)
+    {
+        beg = std::min(beg, last->first);
+        end = std::max(end, last->first + last->second.size());
+    }
+    /// new data is inside or at the end of existing extent: update it in place
+    if (first != last && std::next(first) == last && first->first == beg)
+    {
+        first->second.resize(end - beg);
+        memcpy(first->second.data() + (offset - beg), data.data(), data.size());
+        return;
+    }
+    /// merge all the extents into new one
+    std::vector<char> merged(end - beg);
+    for (std::map<size_t, std::vector<char>>::iterator it = first; it != last; ++it)
+        memcpy(merged.data() + (it->first - beg), it->second.data(), it->second.size());
+    memcpy(merged.data() + (offset - beg), data.data(), data.size());
+    PendingWrites.erase(first, last);
+    PendingWrites[beg].swap(merged);
+}
+
+bool UPKUtils::FlushWrites()
+{
+    if (PendingWrites.empty())
+        return true;
+    if (!PrepareWorkingCopy())
+        return false;
+    /// extents are sorted by offset, so package is written in one pass
+    UPKFile.clear();
+    for (std::map<size_t, std::vector<char>>::iterator it = PendingWrites.begin(); it != PendingWrites.end(); ++it)
+    {
+        UPKFile.seekp(it->first);
+        UPKFile.write(it->second.data(), it->second.size());
+    }
+    UPKFile.flush();
+    PendingWrites.clear();
+    return UPKFile.good();
+}
+
+bool UPKUtils::BeginFileWrite()
+{
+    return (FlushWrites() && PrepareWorkingCopy());
+}
+
+bool UPKUtils::BeginTransaction()
+{
+    if (IsReadOnly() || !IsLoaded() || TransactionActive)
+        return false;
+    if (!FlushWrites())
+        return false;
+    TransactionActive = true;
+    PackageFileName = "";
+    return true;
+}
+
+bool UPKUtils::PrepareWorkingCopy()
+{
+    if (!TransactionActive || PackageFileName != "")
+        return true;
+    std::string CopyFileName = UPKFileName + ".tmp";
+    {
+        std::ifstream in(UPKFileName.c_str(), std::ios::binary);
+        std::ofstream out(CopyFileName.c_str(), std::ios::binary | std::ios::trunc);
+        if (in.good() && out.good())
+            out << in.rdbuf();
+        if (!in.good() || !out.good())
+        {
+            out.close();
+            std::remove(CopyFileName.c_str());
+            return false;
+        }
+    }
+    /// package file stays unchanged until commit
+    UPKFile.close();
+    UPKFile.clear();
+    UPKFile.open(CopyFileName.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+    if (!UPKFile.is_open())
+    {
+        std::remove(CopyFileName.c_str());
+        UPKFile.clear();
+        UPKFile.open(UPKFileName.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+        return false;
+    }
+    PackageFileName = UPKFileName;
+    UPKFileName = CopyFileName;
+    return true;
+}
+
+bool UPKUtils::CommitTransaction()
+{
+    if (!TransactionActive)
+        return false;
+    /// nothing was changed
+    if (PackageFileName == "" && PendingWrites.empty())
+    {
+        TransactionActive = false;
+        return true;
+    }
+    /// package size was not changed: buffered writes go to package in place
+    if (PackageFileName == "")
+    {
+        bool ret = CommitInPlace();
+        TransactionActive = false;
+        PendingWrites.clear();
         UPKUtils::Reload();
+        return ret;
+    }
+    /// buffered writes go to the working copy, which replaces package in one step
+    bool ret = FlushWrites();
+    TransactionActive = false;
+    UPKFile.close();
+    UPKFile.clear();
+    if (ret)
+        ret = ReplaceFileAtomically(UPKFileName.c_str(), PackageFileName.c_str());
+    if (!ret)
+        std::remove(UPKFileName.c_str());
+    UPKFileName = PackageFileName;
+    PackageFileName = "";
+    UPKFile.open(UPKFileName.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+    if (!ret)
+    {
+        UPKUtils::Reload();
+        return false;
+    }
+    return UPKFile.is_open();
+}
+
+/// original data of changed extents are saved to rollback journal (package file name + .journal)
+/// before extents are written, journal is removed after that
+/// journal is written to a temporary file first, so existing journal is always complete
+bool UPKUtils::CommitInPlace()
+{
+    UndoJournal Journal;
+    FUndoPackage& Package = Journal.AddPackage(UPKFileName);
+    Package.FileSize = UPKFileSize;
+    UPKFile.clear();
+    for (std::map<size_t, std::vector<char>>::iterator it = PendingWrites.begin(); it != PendingWrites.end(); ++it)
+    {
+        Package.Records.push_back(FUndoRecord());
+        FUndoRecord& Record = Package.Records.back();
+        Record.Offset = it->first;
+        Record.Size = it->second.size();
+        Record.Data.resize(it->second.size());
+        UPKFile.seekg(it->first);
+        UPKFile.read(Record.Data.data(), Record.Data.size());
+    }
+    if (!UPKFile.good())
+    {
+        UPKFile.clear();
+        return false;
+    }
+    std::string JournalFileName = UPKFileName + ".journal";
+    std::string TmpJournalFileName = JournalFileName + ".tmp";
+    if (!Journal.Write(TmpJournalFileName.c_str()) ||
+        !ReplaceFileAtomically(TmpJournalFileName.c_str(), JournalFileName.c_str()))
+    {
+        std::remove(TmpJournalFileName.c_str());
+        return false;
+    }
+    /// extents are sorted by offset, so package is written in one pass
+    for (std::map<size_t, std::vector<char>>::iterator it = PendingWrites.begin(); it != PendingWrites.end(); ++it)
+    {
+        UPKFile.seekp(it->first);
+        UPKFile.write(it->second.data(), it->second.size());
+    }
+    UPKFile.flush();
+    if (!UPKFile.good())
+    {
+        /// put original data back
+        UPKFile.clear();
+        RecoverCommit();
+        return false;
+    }
+    std::remove(JournalFileName.c_str());
+    return true;
+}
+
+/// restore package data from rollback journal left by interrupted commit
+bool UPKUtils::RecoverCommit()
+{
+    std::string JournalFileName = UPKFileName + ".journal";
+    if (!std::ifstream(JournalFileName.c_str()).good())
+        return true;
+    UndoJournal Journal;
+    if (!Journal.Read(JournalFileName.c_str()) || Journal.GetPackages().size() != 1)
+        return false;
+    const FUndoPackage& Package = Journal.GetPackages().begin()->second;
+    UPKFile.clear();
+    UPKFile.seekg(0, std::ios::end);
+    if ((uint64_t)UPKFile.tellg() != Package.FileSize)
+        return false;
+    for (unsigned i = 0; i < Package.Records.size(); ++i)
+    {
+        UPKFile.seekp(Package.Records[i].Offset);
+        UPKFile.write(Package.Records[i].Data.data(), Package.Records[i].Data.size());
+    }
+    UPKFile.flush();
+    if (!UPKFile.good())
+        return false;
+    std::remove(JournalFileName.c_str());
+    return true;
+}
+
+bool UPKUtils::RollbackTransaction()
+{
+    if (!TransactionActive)
+        return false;
+    DiscardTransaction();
+    return UPKUtils::Reload();
+}
+
+void UPKUtils::DiscardTransaction()
+{
+    if (!TransactionActive)
+        return;
+    TransactionActive = false;
+    HeaderBatchActive = false;
+    PendingWrites.clear();
+    if (PackageFileName == "")
+        return;
+    UPKFile.close();
+    UPKFile.clear();
+    std::remove(UPKFileName.c_str());
+    UPKFileName = PackageFileName;
+    PackageFileName = "";
+    UPKFile.open(UPKFileName.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+}
+
+void UPKUtils::RefreshFileSize()
+{
+    UPKFile.clear();
+    UPKFile.seekg(0, std::ios::end);
+    UPKFileSize = UPKFile.tellg();
+}
+
+/// first entry, which ends after offset (entries are sorted by offset)
+template<typename T>
+static size_t FindEntryAfter(const std::vector<T>& Table, size_t first, size_t offset)
+{
+    return std::partition_point(Table.begin() + first, Table.end(),
+        [offset](const T& Entry) { return Entry.EntryOffset + Entry.EntrySize <= offset; }) - Table.begin();
+}
+
+bool UPKUtils::RefreshHeader(size_t offset, size_t size)
+{
+    /// summary defines the layout of the whole header
+    if (offset < Summary.NameOffset)
+        return UPKUtils::Reload();
+    size_t end = offset + size;
+    std::vector<uint32_t> ChangedNames;
+    std::vector<UObjectReference> ChangedObjects;
+    bool changedExports = false;
+    /// buffered header writes are read from memory
+    UPKOverlayStreamBuf Buf(*this);
+    std::istream overlay(&Buf);
+    std::istream& in = (PendingWrites.empty() ? static_cast<std::istream&>(UPKFile) : overlay);
+    UPKFile.clear();
+    for (size_t i = FindEntryAfter(NameTable, 0, offset); i < NameTable.size() && NameTable[i].EntryOffset < end; ++i)
+    {
+        FNameEntry Entry;
+        in.seekg(NameTable[i].EntryOffset);
+        ReadNameEntry(in, Entry);
+        /// changed entry size shifts the rest of the header
+        if (!in.good() || Entry.EntrySize != NameTable[i].EntrySize)
+            return UPKUtils::Reload();
+        NameTable[i] = Entry;
+        ChangedNames.push_back(i);
+    }
+    for (size_t i = FindEntryAfter(ImportTable, 1, offset); i < ImportTable.size() && ImportTable[i].EntryOffset < end; ++i)
+    {
+        FObjectImport Entry;
+        in.seekg(ImportTable[i].EntryOffset);
+        ReadImportEntry(in, Entry);
+        if (!in.good() || Entry.EntrySize != ImportTable[i].EntrySize)
+            return UPKUtils::Reload();
+        FObjectImport& Old = ImportTable[i];
+        if (Entry.NameIdx.NameTableIdx != Old.NameIdx.NameTableIdx || Entry.NameIdx.Numeric != Old.NameIdx.Numeric ||
+            Entry.TypeIdx.NameTableIdx != Old.TypeIdx.NameTableIdx || Entry.TypeIdx.Numeric != Old.TypeIdx.Numeric ||
+            Entry.OwnerRef != Old.OwnerRef)
+        {
+            ChangedObjects.push_back(-(int)i);
+        }
+        else
+        {
+            Entry.Name = Old.Name;
+            Entry.FullName = Old.FullName;
+            Entry.Type = Old.Type;
+        }
+        Old = Entry;
+    }
+    for (size_t i = FindEntryAfter(ExportTable, 1, offset); i < ExportTable.size() && ExportTable[i].EntryOffset < end; ++i)
+    {
+        FObjectExport Entry;
+        in.seekg(ExportTable[i].EntryOffset);
+        ReadExportEntry(in, Entry);
+        if (!in.good() || Entry.EntrySize != ExportTable[i].EntrySize)
+            return UPKUtils::Reload();
+        FObjectExport& Old = ExportTable[i];
+        if (Entry.NameIdx.NameTableIdx != Old.NameIdx.NameTableIdx || Entry.NameIdx.Numeric != Old.NameIdx.Numeric ||
+            Entry.TypeRef != Old.TypeRef || Entry.OwnerRef != Old.OwnerRef)
+        {
+            ChangedObjects.push_back(i);
+        }
+        else
+        {
+            Entry.Name = Old.Name;
+            Entry.FullName = Old.FullName;
+            Entry.Type = Old.Type;
+        }
+        Old = Entry;
+        changedExports = true;
+    }
+    /// depends table follows export table
+    size_t dependsOffset = ExportTable.back().EntryOffset + ExportTable.back().EntrySize;
+    if (ExportTable.size() < 2)
+        dependsOffset = Summary.ExportOffset;
+    if (DependsBuf.size() > 0 && end > dependsOffset)
+    {
+        size_t beg = std::max(offset, dependsOffset);
+        size_t len = std::min(end, (size_t)Summary.SerialOffset) - beg;
+        in.seekg(beg);
+        in.read(DependsBuf.data() + (beg - dependsOffset), len);
+        if (!in.good())
+            return UPKUtils::Reload();
     }
+    UPKFile.clear();
+    RefreshResolvedNames(ChangedNames, ChangedObjects);
+    if (changedExports)
+        InvalidateOffsetLookup();
     return true;
 }
 
@@ -310,35 +988,69 @@ size_t UPKUtils::FindDataChunk(std::vector<char> data, size_t beg, size_t limit)
 {
     if (limit != 0 && (limit - beg + 1 < data.size() || limit < beg))
         return 0;
-    size_t offset = 0, idx = beg;
-    bool found = false;
-    std::vector<char> fileBuf((limit == 0 ? UPKFileSize : limit) - beg + 1);
-
-    UPKFile.seekg(beg);
-    UPKFile.read(fileBuf.data(), fileBuf.size());
-
-    char* pFileBuf = fileBuf.data();
-    char* pData = data.data();
-
-    for (char* p = pFileBuf; p != pFileBuf + fileBuf.size() - data.size() + 1; ++p)
+    size_t end = (limit == 0 ? UPKFileSize : std::min(limit + 1, UPKFileSize));
+    if (data.size() < 1 || beg >= end || end - beg < data.size())
+        return 0;
+    DataSearch Search(data);
+    if (IsReadOnly())
+    {
+        /// search package data directly
+        const char* first = GetReadOnlyData(beg, end - beg);
+        if (first == nullptr)
+            return 0;
+        size_t found = Search.Find(first, end - beg);
+        return (found == end - beg ? 0 : beg + found);
+    }
+    /// read package by blocks, overlapping by data size - 1 bytes
+    size_t offset = 0;
+    std::vector<char> fileBuf(std::min(SearchBlockSize + data.size() - 1, end - beg));
+    for (size_t pos = beg; pos + data.size() <= end; pos += SearchBlockSize)
     {
-        if (memcmp(p, pData, data.size()) == 0)
+        size_t len = std::min(fileBuf.size(), end - pos);
+        UPKFile.clear();
+        if (!ReadData(pos, fileBuf.data(), len))
+            break;
+        size_t found = Search.Find(fileBuf.data(), len);
+        if (found != len)
         {
-            found = true;
-            offset = idx;
+            offset = pos + found;
             break;
         }
-        ++idx;
     }
-
-    if (found == false)
-        offset = 0;
-
     UPKFile.clear();
     UPKFile.seekg(0);
     return offset;
 }
 
+std::vector<std::vector<size_t>> UPKUtils::FindDataChunks(const std::vector<std::vector<char>>& data, size_t beg, size_t limit)
+{
+    std::vector<std::vector<size_t>> ret(data.size());
+    size_t end = (limit == 0 ? UPKFileSize : std::min(limit + 1, UPKFileSize));
+    if (beg >= end)
+        return ret;
+    MultiDataSearch Search(data);
+    if (IsReadOnly())
+    {
+        const char* first = GetReadOnlyData(beg, end - beg);
+        if (first != nullptr)
+            Search.Feed(first, end - beg, beg, ret);
+        return ret;
+    }
+    /// search state is kept between blocks, so blocks do not overlap
+    std::vector<char> fileBuf(std::min(SearchBlockSize, end - beg));
+    UPKFile.clear();
+    for (size_t pos = beg; pos < end; pos += fileBuf.size())
+    {
+        size_t len = std::min(fileBuf.size(), end - pos);
+        if (!ReadData(pos, fileBuf.data(), len))
+            break;
+        Search.Feed(fileBuf.data(), len, pos, ret);
+    }
+    UPKFile.clear();
+    UPKFile.seekg(0);
+    return ret;
+}
+
 size_t UPKUtils::GetScriptSize(uint32_t idx)
 {
     if (idx < 1 || idx >= ExportTable.size())
@@ -347,11 +1059,7 @@ size_t UPKUtils::GetScriptSize(uint32_t idx)
     Obj = UObjectFactory::Create(ExportTable[idx].Type);
     if (Obj == nullptr)
         return 0;
-    UPKFile.seekg(ExportTable[idx].SerialOffset);
-    Obj->SetRef(idx);
-    Obj->SetUnsafe(false);
-    Obj->SetQuickMode(true);
-    Obj->Deserialize(UPKFile, *dynamic_cast<UPKInfo*>(this));
+    DecodeObject(Obj, idx);
     if (Obj->IsStructure() == false)
     {
         delete Obj;
@@ -376,11 +1084,7 @@ size_t UPKUtils::GetScriptMemSize(uint32_t idx)
     Obj = UObjectFactory::Create(ExportTable[idx].Type);
     if (Obj == nullptr)
         return 0;
-    UPKFile.seekg(ExportTable[idx].SerialOffset);
-    Obj->SetRef(idx);
-    Obj->SetUnsafe(false);
-    Obj->SetQuickMode(true);
-    Obj->Deserialize(UPKFile, *dynamic_cast<UPKInfo*>(this));
+    DecodeObject(Obj, idx);
     if (Obj->IsStructure() == false)
     {
         delete Obj;
@@ -405,11 +1109,7 @@ size_t UPKUtils::GetScriptRelOffset(uint32_t idx)
     Obj = UObjectFactory::Create(ExportTable[idx].Type);
     if (Obj == nullptr)
         return 0;
-    UPKFile.seekg(ExportTable[idx].SerialOffset);
-    Obj->SetRef(idx);
-    Obj->SetUnsafe(false);
-    Obj->SetQuickMode(true);
-    Obj->Deserialize(UPKFile, *dynamic_cast<UPKInfo*>(this));
+    DecodeObject(Obj, idx);
     if (Obj->IsStructure() == false)
     {
         delete Obj;
@@ -428,12 +1128,16 @@ size_t UPKUtils::GetScriptRelOffset(uint32_t idx)
 
 bool UPKUtils::ResizeInPlace(uint32_t idx, int newObjectSize, int resizeAt)
 {
+    if (IsReadOnly())
+        return false;
     if (!UPKFile.good())
     {
         return false;
     }
     if (idx < 1 || idx >= ExportTable.size())
         return false;
+    if (!BeginFileWrite())
+        return false;
     std::vector<char> data = GetResizedDataChunk(idx, newObjectSize, resizeAt);
     int diffSize = data.size() - ExportTable[idx].SerialSize;
     /// increase offsets
@@ -458,6 +1162,10 @@ bool UPKUtils::ResizeInPlace(uint32_t idx, int newObjectSize, int resizeAt)
     {
         UPKFile.read(serializedDataAfterIdx.data(), serializedDataAfterIdx.size());
     }
+    /// header size is not changed, object data are replaced
+    RecordUndo(0, Summary.SerialOffset);
+    RecordUndo(ExportTable[idx].SerialOffset, data.size(), ExportTable[idx].SerialSize);
+    ClearArrayInnerTypes();
     /// save new serial size
     ExportTable[idx].SerialSize = newObjectSize;
     /// serialize header
@@ -479,96 +1187,104 @@ bool UPKUtils::ResizeInPlace(uint32_t idx, int newObjectSize, int resizeAt)
     {
         UPKFile.write(serializedDataAfterIdx.data(), serializedDataAfterIdx.size());
     }
-    /// reload package
-    UPKUtils::Read(UPKFileName.c_str());
+    /// header in memory is already up to date, reopen package for reading and writing
+    UPKFile.close();
+    UPKFile.clear();
+    UPKFile.open(UPKFileName.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+    if (!UPKFile.is_open())
+        return false;
+    RefreshFileSize();
+    InvalidateOffsetLookup();
     return true;
 }
 
 bool UPKUtils::AddNameEntry(FNameEntry Entry)
 {
+    if (IsReadOnly())
+        return false;
     if (!UPKFile.good())
     {
         return false;
     }
-    size_t oldSerialOffset = Summary.SerialOffset;
+    /// single entry is added as a batch of one
+    if (!HeaderBatchActive)
+    {
+        if (!BeginHeaderBatch())
+            return false;
+        if (!AddNameEntry(Entry))
+        {
+            DiscardHeaderBatch();
+            return false;
+        }
+        return CommitHeaderBatch();
+    }
     /// increase header size
     Summary.HeaderSize += Entry.EntrySize;
     /// add entry
     ++Summary.NameCount;
     NameTable.push_back(Entry);
-    /// increase offsets
+    AddNameLookup(NameTable.size() - 1);
+    /// increase offsets (export serial offsets are increased on commit)
     Summary.ImportOffset += Entry.EntrySize;
     Summary.ExportOffset += Entry.EntrySize;
     Summary.DependsOffset += Entry.EntrySize;
     Summary.SerialOffset += Entry.EntrySize;
-    for (unsigned i = 1; i <= Summary.ExportCount; ++i)
-    {
-        ExportTable[i].SerialOffset += Entry.EntrySize;
-    }
-    /// backup serialized export data into memory
-    UPKFile.clear();
-    UPKFile.seekg(oldSerialOffset);
-    std::vector<char> serializedData(UPKFileSize - oldSerialOffset);
-    UPKFile.read(serializedData.data(), serializedData.size());
-    /// rewrite package
-    UPKFile.seekp(0);
-    /// serialize header
-    std::vector<char> serializedHeader = SerializeHeader();
-    /// write serialized header
-    UPKFile.write(serializedHeader.data(), serializedHeader.size());
-    /// write serialized export data
-    UPKFile.write(serializedData.data(), serializedData.size());
-    /// reload package
-    UPKUtils::Reload();
     return true;
 }
 
 bool UPKUtils::AddImportEntry(FObjectImport Entry)
 {
+    if (IsReadOnly())
+        return false;
     if (!UPKFile.good())
     {
         return false;
     }
-    size_t oldSerialOffset = Summary.SerialOffset;
+    /// single entry is added as a batch of one
+    if (!HeaderBatchActive)
+    {
+        if (!BeginHeaderBatch())
+            return false;
+        if (!AddImportEntry(Entry))
+        {
+            DiscardHeaderBatch();
+            return false;
+        }
+        return CommitHeaderBatch();
+    }
     /// increase header size
     Summary.HeaderSize += Entry.EntrySize;
     /// add entry
     ++Summary.ImportCount;
     ImportTable.push_back(Entry);
-    /// increase offsets
+    AddImportLookup(ImportTable.size() - 1);
+    /// increase offsets (export serial offsets are increased on commit)
     Summary.ExportOffset += Entry.EntrySize;
     Summary.DependsOffset += Entry.EntrySize;
     Summary.SerialOffset += Entry.EntrySize;
-    for (unsigned i = 1; i <= Summary.ExportCount; ++i)
-    {
-        ExportTable[i].SerialOffset += Entry.EntrySize;
-    }
-    /// backup serialized export data into memory
-    UPKFile.clear();
-    UPKFile.seekg(oldSerialOffset);
-    std::vector<char> serializedData(UPKFileSize - oldSerialOffset);
-    UPKFile.read(serializedData.data(), serializedData.size());
-    /// rewrite package
-    UPKFile.seekp(0);
-    /// serialize header
-    std::vector<char> serializedHeader = SerializeHeader();
-    /// write serialized header
-    UPKFile.write(serializedHeader.data(), serializedHeader.size());
-    /// write serialized export data
-    UPKFile.write(serializedData.data(), serializedData.size());
-    /// reload package
-    UPKUtils::Reload();
     return true;
 }
 
 bool UPKUtils::AddExportEntry(FObjectExport Entry)
 {
+    if (IsReadOnly())
+        return false;
     if (!UPKFile.good())
     {
         return false;
     }
-    unsigned oldExportCount = Summary.ExportCount;
-    size_t oldSerialOffset = Summary.SerialOffset;
+    /// single entry is added as a batch of one
+    if (!HeaderBatchActive)
+    {
+        if (!BeginHeaderBatch())
+            return false;
+        if (!AddExportEntry(Entry))
+        {
+            DiscardHeaderBatch();
+            return false;
+        }
+        return CommitHeaderBatch();
+    }
     /// increase header size
     Summary.HeaderSize += Entry.EntrySize;
     /// add entry
@@ -577,57 +1293,324 @@ bool UPKUtils::AddExportEntry(FObjectExport Entry)
     {
         Entry.SerialSize = 16;
     }
-    Entry.SerialOffset = UPKFileSize + Entry.EntrySize;
+    /// serial offset is set on commit, when the new header size is known
+    Entry.SerialOffset = 0;
     ExportTable.push_back(Entry);
-    /// increase offsets
+    AddExportLookup(ExportTable.size() - 1);
+    /// increase offsets (export serial offsets are increased on commit)
     Summary.DependsOffset += Entry.EntrySize;
     Summary.SerialOffset += Entry.EntrySize;
-    for (unsigned i = 1; i <= oldExportCount; ++i)
+    return true;
+}
+
+bool UPKUtils::BeginHeaderBatch()
+{
+    if (IsReadOnly() || !IsLoaded() || HeaderBatchActive)
+        return false;
+    HeaderBatchActive = true;
+    BatchOldSerialOffset = Summary.SerialOffset;
+    BatchOldExportCount = Summary.ExportCount;
+    BatchOldSummary = Summary;
+    return true;
+}
+
+void UPKUtils::DiscardHeaderBatch()
+{
+    if (!HeaderBatchActive)
+        return;
+    HeaderBatchActive = false;
+    RestoreHeaderTables();
+}
+
+void UPKUtils::RestoreHeaderTables()
+{
+    Summary = BatchOldSummary;
+    /// import and export tables start with null object
+    NameTable.erase(NameTable.begin() + Summary.NameCount, NameTable.end());
+    ImportTable.erase(ImportTable.begin() + Summary.ImportCount + 1, ImportTable.end());
+    ExportTable.erase(ExportTable.begin() + Summary.ExportCount + 1, ExportTable.end());
+    BuildLookupTables();
+    InvalidateOffsetLookup();
+}
+
+bool UPKUtils::CommitHeaderBatch()
+{
+    if (!HeaderBatchActive)
+        return false;
+    HeaderBatchActive = false;
+    if (IsReadOnly() || !IsLoaded() || !BeginFileWrite())
+    {
+        RestoreHeaderTables();
+        return false;
+    }
+    size_t shift = Summary.SerialOffset - BatchOldSerialOffset;
+    /// nothing was added
+    if (shift == 0)
+        return true;
+    /// shift old export objects data
+    for (unsigned i = 1; i <= BatchOldExportCount; ++i)
     {
-        ExportTable[i].SerialOffset += Entry.EntrySize;
+        ExportTable[i].SerialOffset += shift;
+    }
+    /// new export objects data are written to the end of the package
+    size_t newDataOffset = UPKFileSize + shift;
+    for (unsigned i = BatchOldExportCount + 1; i <= Summary.ExportCount; ++i)
+    {
+        ExportTable[i].SerialOffset = newDataOffset;
+        newDataOffset += ExportTable[i].SerialSize;
+    }
+    /// new header replaces old one and moves serialized data, new objects data are appended
+    RecordUndo(0, Summary.SerialOffset, BatchOldSerialOffset);
+    RecordUndo(UPKFileSize + shift, newDataOffset - UPKFileSize - shift, 0);
+    /// move serialized export data to make room for the new header
+    /// package file is changed from here on: on errors tables are re-read from it
+    if (!ShiftSerializedData(BatchOldSerialOffset, shift))
+    {
+        UPKUtils::Reload();
+        return false;
     }
-    /// backup serialized export data into memory
-    UPKFile.clear();
-    UPKFile.seekg(oldSerialOffset);
-    std::vector<char> serializedData(UPKFileSize - oldSerialOffset);
-    UPKFile.read(serializedData.data(), serializedData.size());
-    /// rewrite package
-    UPKFile.seekp(0);
     /// serialize header
     std::vector<char> serializedHeader = SerializeHeader();
     /// write serialized header
+    UPKFile.seekp(0);
     UPKFile.write(serializedHeader.data(), serializedHeader.size());
-    /// write serialized export data
-    UPKFile.write(serializedData.data(), serializedData.size());
     /// write new export serialized data
-    std::vector<char> serializedEntry(Entry.SerialSize);
-    UObjectReference PrevObjRef = oldExportCount;
-    memcpy(serializedEntry.data(), reinterpret_cast<char*>(&PrevObjRef), sizeof(PrevObjRef));
-    memcpy(serializedEntry.data() + sizeof(PrevObjRef), reinterpret_cast<char*>(&NoneIdx), sizeof(NoneIdx));
-    UPKFile.write(serializedEntry.data(), serializedEntry.size());
+    UPKFile.seekp(UPKFileSize + shift);
+    for (unsigned i = BatchOldExportCount + 1; i <= Summary.ExportCount; ++i)
+    {
+        std::vector<char> serializedEntry(ExportTable[i].SerialSize);
+        UObjectReference PrevObjRef = i - 1;
+        memcpy(serializedEntry.data(), reinterpret_cast<char*>(&PrevObjRef), sizeof(PrevObjRef));
+        memcpy(serializedEntry.data() + sizeof(PrevObjRef), reinterpret_cast<char*>(&NoneIdx), sizeof(NoneIdx));
+        UPKFile.write(serializedEntry.data(), serializedEntry.size());
+    }
+    UPKFile.flush();
+    if (!UPKFile.good())
+    {
+        UPKUtils::Reload();
+        return false;
+    }
+    uint32_t oldExportCount = BatchOldExportCount;
     /// reload package
     UPKUtils::Reload();
-    /// link export object to owner
-    LinkChild(Entry.OwnerRef, Summary.ExportCount);
+    /// link new export objects to owners
+    for (unsigned i = oldExportCount + 1; i <= Summary.ExportCount; ++i)
+    {
+        LinkChild(ExportTable[i].OwnerRef, i);
+    }
     return true;
 }
 
+/// moves [offset, UPKFileSize) data to offset + shift
+/// data are moved from the tail with a fixed size buffer, so moved regions can overlap
+bool UPKUtils::ShiftSerializedData(size_t offset, size_t shift)
+{
+    UPKFile.clear();
+    std::vector<char> buf(std::min(ShiftBufferSize, UPKFileSize - offset));
+    for (size_t end = UPKFileSize; end > offset; )
+    {
+        size_t size = std::min(buf.size(), end - offset);
+        UPKFile.seekg(end - size);
+        UPKFile.read(buf.data(), size);
+        UPKFile.seekp(end - size + shift);
+        UPKFile.write(buf.data(), size);
+        end -= size;
+    }
+    return UPKFile.good();
+}
+
+void UPKUtils::RecordUndo(size_t offset, size_t size, size_t oldSize)
+{
+    if (UndoRecords == nullptr)
+        return;
+    /// data beyond the end of file are appended, they have no original data
+    oldSize = std::min(oldSize, UPKFileSize - std::min(offset, UPKFileSize));
+    UndoRecords->push_back(FUndoRecord());
+    FUndoRecord& Record = UndoRecords->back();
+    Record.Offset = offset;
+    Record.Size = size;
+    Record.Data.resize(oldSize);
+    UPKFile.clear();
+    if (oldSize > 0)
+        ReadData(offset, Record.Data.data(), oldSize);
+}
+
+void UPKUtils::SetUndoRecords(std::vector<FUndoRecord>* Records)
+{
+    if (UndoRecords != nullptr && UndoRecords != Records)
+        HashUndoRecords(*UndoRecords);
+    UndoRecords = Records;
+}
+
+bool UPKUtils::ReadUndoRanges(const std::vector<FUndoRecord>& Records, std::map<size_t, std::vector<char>>& Ranges, bool& isResized)
+{
+    Ranges.clear();
+    isResized = false;
+    std::vector<std::pair<size_t, size_t>> Changed;
+    for (unsigned i = 0; i < Records.size(); ++i)
+    {
+        if (Records[i].Size != Records[i].Data.size())
+            isResized = true;
+        Changed.push_back({Records[i].Offset, Records[i].Offset + Records[i].Size});
+    }
+    UPKFile.clear();
+    if (isResized)
+    {
+        Ranges[0].resize(UPKFileSize);
+        bool ret = ReadData(0, Ranges[0].data(), UPKFileSize);
+        UPKFile.clear();
+        return ret;
+    }
+    /// merged changed ranges in offset order
+    std::sort(Changed.begin(), Changed.end());
+    for (size_t i = 0; i < Changed.size(); )
+    {
+        size_t beg = Changed[i].first, end = Changed[i].second;
+        for (++i; i < Changed.size() && Changed[i].first <= end; ++i)
+            end = std::max(end, Changed[i].second);
+        if (end > UPKFileSize)
+            return false;
+        std::vector<char>& data = Ranges[beg];
+        data.resize(end - beg);
+        if (!ReadData(beg, data.data(), data.size()))
+        {
+            UPKFile.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+/// undo changes in memory, starting from the last one
+/// Hashes get hashes of the changed data before each change is undone
+static bool UndoRanges(std::map<size_t, std::vector<char>>& Ranges, const std::vector<FUndoRecord>& Records, std::vector<uint64_t>& Hashes)
+{
+    Hashes.assign(Records.size(), 0);
+    for (size_t i = Records.size(); i > 0; --i)
+    {
+        const FUndoRecord& Record = Records[i - 1];
+        std::map<size_t, std::vector<char>>::iterator it = Ranges.upper_bound(Record.Offset);
+        if (it == Ranges.begin())
+            return false;
+        --it;
+        std::vector<char>& data = it->second;
+        size_t offset = Record.Offset - it->first;
+        if (offset > data.size() || Record.Size > data.size() - offset)
+            return false;
+        Hashes[i - 1] = HashData(data.data() + offset, Record.Size);
+        if (Record.Size == Record.Data.size())
+        {
+            memcpy(data.data() + offset, Record.Data.data(), Record.Size);
+        }
+        else
+        {
+            data.erase(data.begin() + offset, data.begin() + offset + Record.Size);
+            data.insert(data.begin() + offset, Record.Data.begin(), Record.Data.end());
+        }
+    }
+    return true;
+}
+
+bool UPKUtils::HashUndoRecords(std::vector<FUndoRecord>& Records)
+{
+    std::map<size_t, std::vector<char>> Ranges;
+    std::vector<uint64_t> Hashes;
+    bool isResized = false;
+    if (!ReadUndoRanges(Records, Ranges, isResized) || !UndoRanges(Ranges, Records, Hashes))
+        return false;
+    for (unsigned i = 0; i < Records.size(); ++i)
+        Records[i].Hash = Hashes[i];
+    return true;
+}
+
+bool UPKUtils::CheckUndoChanges(const std::vector<FUndoRecord>& Records)
+{
+    std::map<size_t, std::vector<char>> Ranges;
+    bool isResized = false;
+    return (ReadUndoRanges(Records, Ranges, isResized) && CheckUndoRanges(Ranges, Records));
+}
+
+bool UPKUtils::CheckUndoRanges(std::map<size_t, std::vector<char>>& Ranges, const std::vector<FUndoRecord>& Records)
+{
+    std::vector<uint64_t> Hashes;
+    if (!UndoRanges(Ranges, Records, Hashes))
+        return false;
+    for (unsigned i = 0; i < Records.size(); ++i)
+    {
+        if (Hashes[i] != Records[i].Hash)
+            return false;
+    }
+    return true;
+}
+
+bool UPKUtils::UndoChanges(const std::vector<FUndoRecord>& Records)
+{
+    if (IsReadOnly() || !IsLoaded() || TransactionActive || HeaderBatchActive)
+        return false;
+    /// package data (buffered writes included) are checked to be in the state the changes
+    /// left them in before anything is written
+    std::map<size_t, std::vector<char>> Ranges;
+    bool isResized = false;
+    if (!ReadUndoRanges(Records, Ranges, isResized) || !CheckUndoRanges(Ranges, Records))
+        return false;
+    if (isResized)
+    {
+        /// restored package is written to working copy, which replaces package in one step
+        std::vector<char>& data = Ranges[0];
+        std::string CopyFileName = UPKFileName + ".tmp";
+        std::ofstream out(CopyFileName.c_str(), std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size());
+        out.close();
+        bool ret = out.good();
+        if (ret)
+        {
+            UPKFile.close();
+            UPKFile.clear();
+            ret = ReplaceFileAtomically(CopyFileName.c_str(), UPKFileName.c_str());
+            UPKFile.open(UPKFileName.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+        }
+        if (!ret)
+            std::remove(CopyFileName.c_str());
+        if (!ret || !UPKFile.is_open())
+            return false;
+        /// restored package already includes buffered writes
+        PendingWrites.clear();
+    }
+    else if (WriteBuffering)
+    {
+        /// restored data replace buffered writes, changes are not written to package
+        for (std::map<size_t, std::vector<char>>::iterator it = Ranges.begin(); it != Ranges.end(); ++it)
+            AddPendingWrite(it->first, it->second);
+    }
+    else
+    {
+        /// only changed ranges are written, in offset order
+        for (std::map<size_t, std::vector<char>>::iterator it = Ranges.begin(); it != Ranges.end(); ++it)
+        {
+            UPKFile.seekp(it->first);
+            UPKFile.write(it->second.data(), it->second.size());
+        }
+        UPKFile.flush();
+        if (!UPKFile.good())
+            return false;
+    }
+    return UPKUtils::Reload();
+}
+
 bool UPKUtils::LinkChild(UObjectReference OwnerRef, UObjectReference ChildRef)
 {
+    if (IsReadOnly())
+        return false;
     if (OwnerRef < 1 || OwnerRef >= (int)ExportTable.size())
         return false;
     UObject* Obj;
-    /// deserialize owner object to get first child
+    /// decode owner object to get first child
     Obj = UObjectFactory::Create(ExportTable[OwnerRef].Type);
     if (Obj == nullptr || Obj->IsStructure() == false)
     {
         return false;
     }
-    UPKFile.seekg(ExportTable[OwnerRef].SerialOffset);
-    Obj->SetRef(OwnerRef);
-    Obj->SetUnsafe(false);
-    Obj->SetQuickMode(true);
-    Obj->Deserialize(UPKFile, *dynamic_cast<UPKInfo*>(this));
+    DecodeObject(Obj, OwnerRef);
     UStruct* StructObj = dynamic_cast<UStruct*>(Obj);
     if (StructObj == nullptr)
     {
@@ -639,10 +1622,9 @@ bool UPKUtils::LinkChild(UObjectReference OwnerRef, UObjectReference ChildRef)
     if (FirstChildRef == 0)
     {
         /// link child to owner
-        UPKFile.seekg(StructObj->GetFirstChildRefOffset());
-        UPKFile.write(reinterpret_cast<char*>(&ChildRef), sizeof(ChildRef));
+        size_t FirstChildRefOffset = StructObj->GetFirstChildRefOffset();
         delete Obj;
-        return true;
+        return WriteData(FirstChildRefOffset, std::vector<char>(reinterpret_cast<char*>(&ChildRef), reinterpret_cast<char*>(&ChildRef) + sizeof(ChildRef)));
     }
     delete Obj;
     /// find last child
@@ -655,11 +1637,7 @@ bool UPKUtils::LinkChild(UObjectReference OwnerRef, UObjectReference ChildRef)
         {
             return false;
         }
-        UPKFile.seekg(ExportTable[NextRef].SerialOffset);
-        Obj->SetRef(NextRef);
-        Obj->SetUnsafe(false);
-        Obj->SetQuickMode(true);
-        Obj->Deserialize(UPKFile, *dynamic_cast<UPKInfo*>(this));
+        DecodeObject(Obj, NextRef);
         UField* FieldObj = dynamic_cast<UField*>(Obj);
         if (FieldObj == nullptr)
         {
@@ -672,9 +1650,7 @@ bool UPKUtils::LinkChild(UObjectReference OwnerRef, UObjectReference ChildRef)
 
     }
     /// link new child to last child
-    UPKFile.seekg(LastRefOffset);
-    UPKFile.write(reinterpret_cast<char*>(&ChildRef), sizeof(ChildRef));
-    return true;
+    return WriteData(LastRefOffset, std::vector<char>(reinterpret_cast<char*>(&ChildRef), reinterpret_cast<char*>(&ChildRef) + sizeof(ChildRef)));
 }
 
 bool UPKUtils::Deserialize(FNameEntry& entry, std::vector<char>& data)
@@ -719,16 +1695,16 @@ bool UPKUtils::Deserialize(FObjectImport& entry, std::vector<char>& data)
     ss.read(reinterpret_cast<char*>(&entry.NameIdx), sizeof(entry.NameIdx));
     /// memory variables
     entry.EntrySize = data.size();
-    entry.Name = IndexToName(entry.NameIdx);
+    entry.Name = InternName(entry.NameIdx);
     entry.FullName = entry.Name;
     if (entry.OwnerRef != 0)
     {
-        entry.FullName = ResolveFullName(entry.OwnerRef) + "." + entry.Name;
+        entry.FullName = Strings.Intern(ResolveFullName(entry.OwnerRef) + "." + entry.Name);
     }
-    entry.Type = IndexToName(entry.TypeIdx);
+    entry.Type = Strings.Intern(IndexToName(entry.TypeIdx));
     if (entry.Type == "")
     {
-        entry.Type = "Class";
+        entry.Type = Strings.Intern("Class");
     }
     return true;
 }
@@ -765,23 +1741,22 @@ bool UPKUtils::Deserialize(FObjectExport& entry, std::vector<char>& data)
     }
     /// memory variables
     entry.EntrySize = data.size();
-    entry.Name = IndexToName(entry.NameIdx);
+    entry.Name = InternName(entry.NameIdx);
     entry.FullName = entry.Name;
     if (entry.OwnerRef != 0)
     {
-        entry.FullName = ResolveFullName(entry.OwnerRef) + "." + entry.Name;
+        entry.FullName = Strings.Intern(ResolveFullName(entry.OwnerRef) + "." + entry.Name);
     }
-    entry.Type = ObjRefToName(entry.TypeRef);
+    entry.Type = Strings.Intern(ObjRefToName(entry.TypeRef));
     if (entry.Type == "")
     {
-        entry.Type = "Class";
+        entry.Type = Strings.Intern("Class");
     }
     return true;
 }
 
-std::vector<char> UPKUtils::SerializeHeader()
+static void SerializeSummary(FPackageFileSummary Summary, std::ostream& ss)
 {
-    std::stringstream ss;
     ss.write(reinterpret_cast<char*>(&Summary.Signature), 4);
     int32_t Ver = (Summary.LicenseeVersion << 16) + Summary.Version;
     ss.write(reinterpret_cast<char*>(&Ver), 4);
@@ -828,44 +1803,50 @@ std::vector<char> UPKUtils::SerializeHeader()
     {
         ss.write(Summary.UnknownDataChunk.data(), Summary.UnknownDataChunk.size());
     }
+}
+
+std::vector<char> UPKUtils::SerializeHeader()
+{
+    std::stringstream ss;
+    SerializeSummary(Summary, ss);
     for (unsigned i = 0; i < Summary.NameCount; ++i)
     {
-        FNameEntry Entry = NameTable[i];
-        ss.write(reinterpret_cast<char*>(&Entry.NameLength), 4);
+        const FNameEntry& Entry = NameTable[i];
+        ss.write(reinterpret_cast<const char*>(&Entry.NameLength), 4);
         if (Entry.NameLength > 0)
         {
             ss.write(Entry.Name.c_str(), Entry.NameLength);
         }
-        ss.write(reinterpret_cast<char*>(&Entry.NameFlagsL), 4);
-        ss.write(reinterpret_cast<char*>(&Entry.NameFlagsH), 4);
+        ss.write(reinterpret_cast<const char*>(&Entry.NameFlagsL), 4);
+        ss.write(reinterpret_cast<const char*>(&Entry.NameFlagsH), 4);
     }
     for (unsigned i = 1; i <= Summary.ImportCount; ++i)
     {
-        FObjectImport Entry = ImportTable[i];
-        ss.write(reinterpret_cast<char*>(&Entry.PackageIdx), sizeof(Entry.PackageIdx));
-        ss.write(reinterpret_cast<char*>(&Entry.TypeIdx), sizeof(Entry.TypeIdx));
-        ss.write(reinterpret_cast<char*>(&Entry.OwnerRef), sizeof(Entry.OwnerRef));
-        ss.write(reinterpret_cast<char*>(&Entry.NameIdx), sizeof(Entry.NameIdx));
+        const FObjectImport& Entry = ImportTable[i];
+        ss.write(reinterpret_cast<const char*>(&Entry.PackageIdx), sizeof(Entry.PackageIdx));
+        ss.write(reinterpret_cast<const char*>(&Entry.TypeIdx), sizeof(Entry.TypeIdx));
+        ss.write(reinterpret_cast<const char*>(&Entry.OwnerRef), sizeof(Entry.OwnerRef));
+        ss.write(reinterpret_cast<const char*>(&Entry.NameIdx), sizeof(Entry.NameIdx));
     }
     for (unsigned i = 1; i <= Summary.ExportCount; ++i)
     {
-        FObjectExport Entry = ExportTable[i];
-        ss.write(reinterpret_cast<char*>(&Entry.TypeRef), sizeof(Entry.TypeRef));
-        ss.write(reinterpret_cast<char*>(&Entry.ParentClassRef), sizeof(Entry.ParentClassRef));
-        ss.write(reinterpret_cast<char*>(&Entry.OwnerRef), sizeof(Entry.OwnerRef));
-        ss.write(reinterpret_cast<char*>(&Entry.NameIdx), sizeof(Entry.NameIdx));
-        ss.write(reinterpret_cast<char*>(&Entry.ArchetypeRef), sizeof(Entry.ArchetypeRef));
-        ss.write(reinterpret_cast<char*>(&Entry.ObjectFlagsH), sizeof(Entry.ObjectFlagsH));
-        ss.write(reinterpret_cast<char*>(&Entry.ObjectFlagsL), sizeof(Entry.ObjectFlagsL));
-        ss.write(reinterpret_cast<char*>(&Entry.SerialSize), sizeof(Entry.SerialSize));
-        ss.write(reinterpret_cast<char*>(&Entry.SerialOffset), sizeof(Entry.SerialOffset));
-        ss.write(reinterpret_cast<char*>(&Entry.ExportFlags), sizeof(Entry.ExportFlags));
-        ss.write(reinterpret_cast<char*>(&Entry.NetObjectCount), sizeof(Entry.NetObjectCount));
-        ss.write(reinterpret_cast<char*>(&Entry.GUID), sizeof(Entry.GUID));
-        ss.write(reinterpret_cast<char*>(&Entry.Unknown1), sizeof(Entry.Unknown1));
+        const FObjectExport& Entry = ExportTable[i];
+        ss.write(reinterpret_cast<const char*>(&Entry.TypeRef), sizeof(Entry.TypeRef));
+        ss.write(reinterpret_cast<const char*>(&Entry.ParentClassRef), sizeof(Entry.ParentClassRef));
+        ss.write(reinterpret_cast<const char*>(&Entry.OwnerRef), sizeof(Entry.OwnerRef));
+        ss.write(reinterpret_cast<const char*>(&Entry.NameIdx), sizeof(Entry.NameIdx));
+        ss.write(reinterpret_cast<const char*>(&Entry.ArchetypeRef), sizeof(Entry.ArchetypeRef));
+        ss.write(reinterpret_cast<const char*>(&Entry.ObjectFlagsH), sizeof(Entry.ObjectFlagsH));
+        ss.write(reinterpret_cast<const char*>(&Entry.ObjectFlagsL), sizeof(Entry.ObjectFlagsL));
+        ss.write(reinterpret_cast<const char*>(&Entry.SerialSize), sizeof(Entry.SerialSize));
+        ss.write(reinterpret_cast<const char*>(&Entry.SerialOffset), sizeof(Entry.SerialOffset));
+        ss.write(reinterpret_cast<const char*>(&Entry.ExportFlags), sizeof(Entry.ExportFlags));
+        ss.write(reinterpret_cast<const char*>(&Entry.NetObjectCount), sizeof(Entry.NetObjectCount));
+        ss.write(reinterpret_cast<const char*>(&Entry.GUID), sizeof(Entry.GUID));
+        ss.write(reinterpret_cast<const char*>(&Entry.Unknown1), sizeof(Entry.Unknown1));
         if (Entry.NetObjectCount > 0)
         {
-            ss.write(reinterpret_cast<char*>(Entry.NetObjects.data()), Entry.NetObjects.size()*4);
+            ss.write(reinterpret_cast<const char*>(Entry.NetObjects.data()), Entry.NetObjects.size()*4);
         }
     }
     if (DependsBuf.size() > 0)
@@ -3,21 +3,54 @@
 
 #include "UPKInfo.h"
 #include "UObjectFactory.h"
+#include "UPKMapping.h"
+#include "UPKCompressedImage.h"
+#include "UndoJournal.h"
 #include <fstream>
+#include <map>
+
+class UPKUtils;
+
+/// read-only stream buffer over package file with buffered writes put over file data
+/// stream positions are file offsets, file is read in small chunks
+class UPKOverlayStreamBuf: public std::streambuf
+{
+public:
+    UPKOverlayStreamBuf(UPKUtils& package);
+protected:
+    int_type underflow();
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::in);
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in);
+private:
+    UPKUtils& Package;
+    size_t BufferOffset;
+    std::vector<char> Buffer;
+};
 
 class UPKUtils: public UPKInfo
 {
 public:
-    UPKUtils() {}
-    ~UPKUtils() {}
+    UPKUtils(): HeaderBatchActive(false), WriteBuffering(false), TransactionActive(false), UndoRecords(nullptr) {}
+    ~UPKUtils() { DiscardTransaction(); FlushWrites(); }
     UPKUtils(const char* filename);
     /// Read package header
     bool Read(const char* filename);
     bool Reload();
-    bool IsLoaded() { return (UPKFile.is_open() && UPKFile.good()); };
+    /// Read package header from read-only memory mapped file
+    /// all the write functions fail in mapped mode
+    bool ReadMapped(const char* filename);
+    bool IsMapped() { return Mapping.IsOpen(); }
+    /// LZO compressed packages are opened by Read and ReadMapped in read-only
+    /// compressed mode: data are decompressed on access, all the write functions fail
+    bool IsCompressedMode() { return CompressedImage.IsOpen(); }
+    bool IsReadOnly() { return (IsMapped() || IsCompressedMode()); }
+    bool IsLoaded() { return (IsReadOnly() || (UPKFile.is_open() && UPKFile.good())); };
     size_t GetFileSize() { return UPKFileSize; }
     /// Extract serialized data
     std::vector<char> GetExportData(uint32_t idx);
+    /// Zero-copy access to serialized data (read-only modes only, empty view otherwise)
+    /// package state is not changed, so views can be taken by several threads
+    UPKDataView GetExportDataView(uint32_t idx);
     void SaveExportData(uint32_t idx);
     size_t GetScriptSize(uint32_t idx);
     size_t GetScriptMemSize(uint32_t idx);
@@ -37,12 +70,46 @@ public:
     bool Deserialize(FNameEntry& entry, std::vector<char>& data);
     bool Deserialize(FObjectImport& entry, std::vector<char>& data);
     bool Deserialize(FObjectExport& entry, std::vector<char>& data);
+    /// Decode object fields without text output, Obj type must match object type
+    bool DecodeObject(UObject* Obj, UObjectReference ObjRef, bool TryUnsafe = false, bool QuickMode = true);
     /// Write data
     bool CheckValidFileOffset(size_t offset);
     bool WriteExportData(uint32_t idx, std::vector<char> data, std::vector<char> *backupData = nullptr);
     bool WriteNameTableName(uint32_t idx, std::string name);
     bool WriteData(size_t offset, std::vector<char> data, std::vector<char> *backupData = nullptr);
+    /// Buffered writes: WriteData calls, which change serialized data only, are kept in memory
+    /// as sorted non-overlapping extents and are written to package by FlushWrites in one pass
+    /// all the read functions see buffered data, other write functions flush buffer first
+    void SetWriteBuffering(bool val) { FlushWrites(); WriteBuffering = val; }
+    bool IsWriteBuffering() { return WriteBuffering; }
+    bool FlushWrites();
+    /// Transactions: package file is not changed until CommitTransaction
+    /// writes, which do not change package size, are buffered as with SetWriteBuffering,
+    /// header writes included; if package size is changed, a working copy of package is made
+    /// (package file name + ".tmp"), on commit buffered writes go to working copy, which
+    /// replaces package file in one step, otherwise they are written to package in place
+    /// with original data saved to rollback journal (package file name + ".journal") first
+    /// RollbackTransaction discards all the changes and reloads package
+    bool BeginTransaction();
+    bool CommitTransaction();
+    bool RollbackTransaction();
+    bool IsTransactionActive() { return TransactionActive; }
+    /// Undo journal: original data of each change are appended to Records before the change
+    /// is made (buffered writes included), nullptr switches journaling off
+    /// switching records (or reading another package) hashes changed data of the previous ones
+    void SetUndoRecords(std::vector<FUndoRecord>* Records);
+    /// set hashes of changed data to check the package is in the state the changes left it in
+    bool HashUndoRecords(std::vector<FUndoRecord>& Records);
+    /// package is in the state the changes left it in (record hashes match)
+    bool CheckUndoChanges(const std::vector<FUndoRecord>& Records);
+    /// undo recorded changes in reverse order, package must be in the state after the changes
+    /// changed data only are written in place (or buffered with write buffering), resized package
+    /// is written to working copy (package file name + ".tmp"), which replaces package file
+    bool UndoChanges(const std::vector<FUndoRecord>& Records);
     size_t FindDataChunk(std::vector<char> data, size_t beg = 0, size_t limit = 0);
+    /// find all (including overlapping) occurrences of several data chunks in [beg, limit] range in one pass
+    /// unlike FindDataChunk, offsets are returned as is (0 is a valid offset)
+    std::vector<std::vector<size_t>> FindDataChunks(const std::vector<std::vector<char>>& data, size_t beg = 0, size_t limit = 0);
     std::vector<char> GetBulkData(size_t offset, std::vector<char> data);
     /// UPK serialization
     std::vector<char> SerializeHeader();
@@ -51,13 +118,63 @@ public:
     bool AddImportEntry(FObjectImport Entry);
     bool AddExportEntry(FObjectExport Entry);
     bool LinkChild(UObjectReference OwnerRef, UObjectReference ChildRef);
+    /// Batched header additions: Add*Entry calls between BeginHeaderBatch and
+    /// CommitHeaderBatch update in-memory tables only, package is rewritten
+    /// and reloaded once on commit and new export objects are linked after that
+    /// failed commit restores in-memory tables (or re-reads them, if package file was changed)
+    bool BeginHeaderBatch();
+    bool CommitHeaderBatch();
+    /// drop uncommitted additions and restore in-memory tables
+    void DiscardHeaderBatch();
+    bool IsHeaderBatchActive() { return HeaderBatchActive; }
     /*
     bool ResizeInPlace(UObjectReference ObjRef, uint32_t newObjectSize);
     */
 private:
+    friend class UPKOverlayStreamBuf;
+    bool ReadCompressed();
+    const char* GetReadOnlyData(size_t offset, size_t size);
+    /// read package data, including buffered writes
+    bool ReadData(size_t offset, char* data, size_t size);
+    void AddPendingWrite(size_t offset, const std::vector<char>& data);
+    /// flush buffered writes and make working copy before writing to file
+    bool BeginFileWrite();
+    bool PrepareWorkingCopy();
+    /// write buffered extents of a transaction, which did not change package size, to package
+    bool CommitInPlace();
+    /// undo partially written commit, if package has rollback journal
+    bool RecoverCommit();
+    void DiscardTransaction();
+    bool ShiftSerializedData(size_t offset, size_t shift);
+    /// restore summary and tables saved by BeginHeaderBatch
+    void RestoreHeaderTables();
+    /// record original data before replacing [offset, offset + oldSize) with size bytes
+    void RecordUndo(size_t offset, size_t size, size_t oldSize);
+    void RecordUndo(size_t offset, size_t size) { RecordUndo(offset, size, size); }
+    /// package data changed by undo records: merged record ranges or, if package size
+    /// was changed, the whole package
+    bool ReadUndoRanges(const std::vector<FUndoRecord>& Records, std::map<size_t, std::vector<char>>& Ranges, bool& isResized);
+    /// undo records in Ranges, checking record hashes
+    bool CheckUndoRanges(std::map<size_t, std::vector<char>>& Ranges, const std::vector<FUndoRecord>& Records);
+    /// in-memory header update after writes, instead of full reload
+    void RefreshFileSize();
+    bool RefreshHeader(size_t offset, size_t size);
+    std::string DeserializeObject(UObject* Obj, UObjectReference ObjRef, bool TryUnsafe, bool QuickMode);
     std::string UPKFileName;
     std::fstream UPKFile;
     size_t UPKFileSize;
+    UPKFileMapping Mapping;
+    UPKCompressedImage CompressedImage;
+    bool HeaderBatchActive;
+    size_t BatchOldSerialOffset;
+    uint32_t BatchOldExportCount;
+    FPackageFileSummary BatchOldSummary;
+    bool WriteBuffering;
+    std::map<size_t, std::vector<char>> PendingWrites;
+    bool TransactionActive;
+    /// package file name, while UPKFileName is its working copy
+    std::string PackageFileName;
+    std::vector<FUndoRecord>* UndoRecords;
 };
 
 #endif // UPKUTILS_H
@@ -1,8 +1,66 @@
 #include <sstream>
 #include <map>
+#include <vector>
+#include <algorithm>
 #include "UToken.h"
 #include "UTokenFactory.h"
 
+/// free token memory blocks by size in 8 byte steps
+class UTokenPool
+{
+public:
+    ~UTokenPool()
+    {
+        for (unsigned i = 0; i < NumSizes; ++i)
+        {
+            for (unsigned j = 0; j < FreeBlocks[i].size(); ++j)
+                ::operator delete(FreeBlocks[i][j]);
+        }
+    }
+    void* Allocate(size_t size)
+    {
+        size_t idx = (size + 7) / 8;
+        if (idx >= NumSizes)
+            return ::operator new(size);
+        if (FreeBlocks[idx].empty())
+            return ::operator new(idx * 8);
+        void* ptr = FreeBlocks[idx].back();
+        FreeBlocks[idx].pop_back();
+        return ptr;
+    }
+    void Free(void* ptr, size_t size)
+    {
+        size_t idx = (size + 7) / 8;
+        if (idx >= NumSizes)
+            ::operator delete(ptr);
+        else
+            FreeBlocks[idx].push_back(ptr);
+    }
+private:
+    static const size_t NumSizes = 32;
+    std::vector<void*> FreeBlocks[NumSizes];
+};
+
+static thread_local UTokenPool TokenPool;
+
+/// references of the script being decoded by CollectReferences, text output is skipped
+/// while it is set
+static thread_local std::vector<UScriptReference>* CollectedRefs = nullptr;
+
+/// owner of the script being decoded by UScriptCode::Deserialize
+static thread_local UObjectReference ScriptOwnerRef = 0;
+
+void* UScriptToken::operator new(size_t size)
+{
+    return TokenPool.Allocate(size);
+}
+
+void UScriptToken::operator delete(void* ptr, size_t size)
+{
+    if (ptr != nullptr)
+        TokenPool.Free(ptr, size);
+}
+
 std::string MakeIndents(int indents)
 {
     if (indents <= 0)
@@ -33,22 +91,65 @@ std::string CopyPositionsComment(std::string str)
     return str.substr(pos, len);
 }
 
+/// decoded expression: offsets, indentation and formatted text
+struct UScriptLine
+{
+    uint16_t MemOffset;
+    uint16_t SerialOffset;
+    int Indents;
+    std::string Text;
+};
+
+/// appends "0x%04X" formatted value
+static void AppendHEX(std::string& out, uint16_t val)
+{
+    static const char Digits[] = "0123456789ABCDEF";
+    char buf[6] = {'0', 'x', Digits[(val >> 12) & 0xF], Digits[(val >> 8) & 0xF], Digits[(val >> 4) & 0xF], Digits[val & 0xF]};
+    out.append(buf, sizeof(buf));
+}
+
+/// "/*(0xMMMM/0xSSSS)*/ "
+static const size_t PositionsCommentSize = 20;
+
+static void AppendPositionsComment(std::string& out, const UScriptLine& Line)
+{
+    out.append("/*(");
+    AppendHEX(out, Line.MemOffset);
+    out.push_back('/');
+    AppendHEX(out, Line.SerialOffset);
+    out.append(")*/ ");
+}
+
+static void AppendLabel(std::string& out, uint16_t MemOffset)
+{
+    out.append("[#label_");
+    AppendHEX(out, MemOffset);
+    out.append("]\n");
+}
+
 std::string UScriptCode::Deserialize(std::istream& stream, UPKInfo& info)
 {
-    std::map<uint16_t, std::string> ExprMap;
+    ScriptOwnerRef = OwnerRef;
+    /// first pass: decode expressions and jump labels
+    std::vector<UScriptLine> Lines;
     std::map<uint16_t, int> JumpMap;
     int numIndents = 0;
     while (stream.good())
     {
         UScriptExpression ScrExpr;
         std::string ExprResult = ScrExpr.Deserialize(stream, info);
-        if (JumpMap.count(MemorySize) > 0) /// reached jump label - remove indentation(s)
+        std::map<uint16_t, int>::iterator jt = JumpMap.find(MemorySize);
+        if (jt != JumpMap.end()) /// reached jump label - remove indentation(s)
         {
-            numIndents -= JumpMap[MemorySize];
-            JumpMap[MemorySize] = 0;
+            numIndents -= jt->second;
+            jt->second = 0;
         }
-        ExprMap[MemorySize] = "/*(" + FormatHEX(MemorySize) + "/" + FormatHEX(SerialSize) + ")*/ "
-                            + MakeIndents(numIndents) + ExprResult + "\n";
+        /// expression without memory size is replaced by the next one
+        if (!Lines.empty() && Lines.back().MemOffset == MemorySize)
+        {
+            Lines.pop_back();
+        }
+        Lines.push_back({MemorySize, SerialSize, numIndents, std::move(ExprResult)});
         if (ScrExpr.IsJump() && ScrExpr.GetJumpOffset() != 0xFFFF) /// save jump labels
         {
             if (ScrExpr.GetJumpOffset() > MemorySize) /// add indentations
@@ -64,21 +165,78 @@ std::string UScriptCode::Deserialize(std::istream& stream, UPKInfo& info)
             break;
         }
     }
-    for (std::map<uint16_t, int>::iterator it = JumpMap.begin(); it != JumpMap.end(); ++it)
+    ScriptOwnerRef = 0;
+    JumpMap.erase(0xFFFF);
+    /// second pass: format lines and labels into one buffer
+    size_t size = JumpMap.size() * (PositionsCommentSize + 16);
+    for (unsigned i = 0; i < Lines.size(); ++i)
+    {
+        size += PositionsCommentSize + std::max(Lines[i].Indents, 0) + Lines[i].Text.size() + 1;
+    }
+    std::string result;
+    result.reserve(size);
+    std::map<uint16_t, int>::iterator label = JumpMap.begin();
+    for (unsigned i = 0; i < Lines.size(); ++i)
     {
-        if (it->first != 0xFFFF)
+        const UScriptLine& Line = Lines[i];
+        /// labels, which point inside expressions or beyond the end of script
+        for (; label != JumpMap.end() && label->first < Line.MemOffset; ++label)
+        {
+            AppendLabel(result, label->first);
+        }
+        if (label != JumpMap.end() && label->first == Line.MemOffset)
         {
-            ExprMap[it->first] = CopyPositionsComment(ExprMap[it->first])
-            + MakeIndents(CountIndents(ExprMap[it->first]))
-            + "[#label_" + FormatHEX(it->first) + "]\n" + ExprMap[it->first];
+            /// label copies positions comment and indentation of the labeled line
+            if (Line.Text.find('\t') == std::string::npos && Line.Text.find("*/") == std::string::npos)
+            {
+                AppendPositionsComment(result, Line);
+                result.append(std::max(Line.Indents, 0), '\t');
+            }
+            else
+            {
+                std::string str;
+                AppendPositionsComment(str, Line);
+                str += MakeIndents(Line.Indents) + Line.Text + "\n";
+                result += CopyPositionsComment(str) + MakeIndents(CountIndents(str));
+            }
+            AppendLabel(result, label->first);
+            ++label;
         }
+        AppendPositionsComment(result, Line);
+        result.append(std::max(Line.Indents, 0), '\t');
+        result.append(Line.Text);
+        result.push_back('\n');
     }
-    std::stringstream result;
-    for (std::map<uint16_t, std::string>::iterator it = ExprMap.begin(); it != ExprMap.end(); ++it)
+    for (; label != JumpMap.end(); ++label)
     {
-        result << it->second;
+        AppendLabel(result, label->first);
     }
-    return result.str();
+    return result;
+}
+
+bool UScriptCode::CollectReferences(std::istream& stream, UPKInfo& info, std::vector<UScriptReference>& Refs)
+{
+    CollectedRefs = &Refs;
+    bool FoundEOS = false;
+    while (stream.good())
+    {
+        UScriptExpression ScrExpr;
+        ScrExpr.Deserialize(stream, info);
+        /// unknown token: the rest of the script can not be decoded
+        if (ScrExpr.GetSerialSize() == 0)
+        {
+            break;
+        }
+        SerialSize += ScrExpr.GetSerialSize();
+        MemorySize += ScrExpr.GetMemorySize();
+        if (ScrExpr.IsEOS())
+        {
+            FoundEOS = true;
+            break;
+        }
+    }
+    CollectedRefs = nullptr;
+    return FoundEOS;
 }
 
 std::string UScriptExpression::Deserialize(std::istream& stream, UPKInfo& info)
@@ -114,6 +272,10 @@ std::string UScriptToken::Deserialize(std::istream& stream, UPKInfo& info)
 {
     SerialSize += 1;
     MemorySize += 1;
+    if (CollectedRefs != nullptr)
+    {
+        return std::string();
+    }
     return FormatType();
 }
 
@@ -121,28 +283,53 @@ std::string UScriptToken::DeserializeObjRef(std::istream& stream, UPKInfo& info)
 {
     SerialSize += 4;
     MemorySize += 8;
-    return FormatObjRef(ReadObjRef(stream), info);
+    UObjectReference ObjRef = ReadObjRef(stream);
+    if (CollectedRefs != nullptr)
+    {
+        if (ObjRef != 0)
+        {
+            CollectedRefs->push_back({Type, false, ObjRef, {0, 0}});
+        }
+        return std::string();
+    }
+    return FormatObjRef(ObjRef, info);
 }
 
 std::string UScriptToken::DeserializeNameIndex(std::istream& stream, UPKInfo& info)
 {
     SerialSize += 8;
     MemorySize += 8;
-    return FormatNameIndex(ReadNameIndex(stream), info);
+    UNameIndex NameIdx = ReadNameIndex(stream);
+    if (CollectedRefs != nullptr)
+    {
+        CollectedRefs->push_back({Type, true, 0, NameIdx});
+        return std::string();
+    }
+    return FormatNameIndex(NameIdx, info);
 }
 
 std::string UScriptToken::DeserializeByte(std::istream& stream, UPKInfo& info)
 {
     SerialSize += 1;
     MemorySize += 1;
-    return FormatByte(ReadByte(stream));
+    uint8_t Value = ReadByte(stream);
+    if (CollectedRefs != nullptr)
+    {
+        return std::string();
+    }
+    return FormatByte(Value);
 }
 
 std::string UScriptToken::DeserializeShort(std::istream& stream, UPKInfo& info)
 {
     SerialSize += 2;
     MemorySize += 2;
-    return FormatShort(ReadShort(stream));
+    uint16_t Value = ReadShort(stream);
+    if (CollectedRefs != nullptr)
+    {
+        return std::string();
+    }
+    return FormatShort(Value);
 }
 
 std::string UScriptToken::DeserializeMemoryOffset(std::istream& stream, UPKInfo& info)
@@ -150,6 +337,10 @@ std::string UScriptToken::DeserializeMemoryOffset(std::istream& stream, UPKInfo&
     SerialSize += 2;
     MemorySize += 2;
     JumpOffset = ReadShort(stream);
+    if (CollectedRefs != nullptr)
+    {
+        return std::string();
+    }
     if (JumpOffset != 0xFFFF)
     {
         return FormatMemOffset(JumpOffset);
@@ -161,28 +352,48 @@ std::string UScriptToken::DeserializeMemorySize(std::istream& stream, UPKInfo& i
 {
     SerialSize += 2;
     MemorySize += 2;
-    return FormatMemSize(ReadShort(stream));
+    uint16_t Value = ReadShort(stream);
+    if (CollectedRefs != nullptr)
+    {
+        return std::string();
+    }
+    return FormatMemSize(Value);
 }
 
 std::string UScriptToken::DeserializeInt(std::istream& stream, UPKInfo& info)
 {
     SerialSize += 4;
     MemorySize += 4;
-    return FormatInt(ReadInt(stream));
+    int32_t Value = ReadInt(stream);
+    if (CollectedRefs != nullptr)
+    {
+        return std::string();
+    }
+    return FormatInt(Value);
 }
 
 std::string UScriptToken::DeserializeUInt(std::istream& stream, UPKInfo& info)
 {
     SerialSize += 4;
     MemorySize += 4;
-    return FormatUInt(ReadUInt(stream));
+    uint32_t Value = ReadUInt(stream);
+    if (CollectedRefs != nullptr)
+    {
+        return std::string();
+    }
+    return FormatUInt(Value);
 }
 
 std::string UScriptToken::DeserializeFloat(std::istream& stream, UPKInfo& info)
 {
     SerialSize += 4;
     MemorySize += 4;
-    return FormatFloat(ReadFloat(stream));
+    float Value = ReadFloat(stream);
+    if (CollectedRefs != nullptr)
+    {
+        return std::string();
+    }
+    return FormatFloat(Value);
 }
 
 std::string UScriptToken::DeserializeString(std::istream& stream, UPKInfo& info)
@@ -191,6 +402,10 @@ std::string UScriptToken::DeserializeString(std::istream& stream, UPKInfo& info)
     getline(stream, Str, '\0');
     SerialSize += Str.length() + 1;
     MemorySize += Str.length() + 1;
+    if (CollectedRefs != nullptr)
+    {
+        return std::string();
+    }
     return FormatString(Str);
 }
 
@@ -268,8 +483,8 @@ std::string UScriptToken::FormatObjRef(UObjectReference ObjRef, UPKInfo& info)
             }
             else
             {
-                bool IsLocal = (info.GetLastAccessedExportObjIdx() == info.GetExportEntry(ObjRef).OwnerRef && info.GetExportEntry(ObjRef).OwnerRef != 0);
-                bool IsMember = (info.GetExportEntry(info.GetLastAccessedExportObjIdx()).OwnerRef == info.GetExportEntry(ObjRef).OwnerRef && info.GetExportEntry(ObjRef).OwnerRef != 0);
+                bool IsLocal = (ScriptOwnerRef == info.GetExportEntry(ObjRef).OwnerRef && info.GetExportEntry(ObjRef).OwnerRef != 0);
+                bool IsMember = (info.GetExportEntry(ScriptOwnerRef).OwnerRef == info.GetExportEntry(ObjRef).OwnerRef && info.GetExportEntry(ObjRef).OwnerRef != 0);
                 if (IsLocal)
                 {
                     result << "<." << info.GetExportEntry(ObjRef).Name << "> ";
@@ -177,12 +177,28 @@ protected:
     uint16_t JumpOffset;
 };
 
+/// object or name referenced by script token
+struct UScriptReference
+{
+    UToken Type;                /// token, which made the reference
+    bool IsName;                /// NameIdx is referenced, ObjRef is referenced otherwise
+    UObjectReference ObjRef;
+    UNameIndex NameIdx;
+};
+
 class UScriptCode : public UScriptBase
 {
 public:
-    UScriptCode() {}
+    /// OwnerRef is Function or State export, which owns the script: its local variables
+    /// and members of its class are formatted with short names
+    UScriptCode(UObjectReference ownerRef = 0): OwnerRef(ownerRef) {}
     ~UScriptCode() {}
     std::string Deserialize(std::istream& stream, UPKInfo& info);
+    /// decode script without text output, non-null object and all name references
+    /// are appended to Refs, returns false if end of script was not reached
+    bool CollectReferences(std::istream& stream, UPKInfo& info, std::vector<UScriptReference>& Refs);
+private:
+    UObjectReference OwnerRef;
 };
 
 class UScriptExpression : public UScriptBase
@@ -203,6 +219,9 @@ class UScriptToken : public UScriptBase
 public:
     UScriptToken(): FoundSkip(false) {}
     virtual ~UScriptToken() {}
+    /// tokens live only while being deserialized, memory is re-used via per-thread pool
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr, size_t size);
     std::string Deserialize(std::istream& stream, UPKInfo& info);
     std::string DeserializeObjRef(std::istream& stream, UPKInfo& info);
     std::string DeserializeNameIndex(std::istream& stream, UPKInfo& info);
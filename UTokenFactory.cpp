@@ -1,361 +1,143 @@
 #include "UTokenFactory.h"
 
+typedef UScriptToken* (*UTokenCreator)(UToken Type);
+
+template<typename T>
+static UScriptToken* CreateToken(UToken Type)
+{
+    return new T;
+}
+
+/// tokens, which keep their type (several token codes share one class)
+template<typename T>
+static UScriptToken* CreateTypedToken(UToken Type)
+{
+    return new T(Type);
+}
+
+/// creators indexed by token code
+static const UTokenCreator TokenCreators[] =
+{
+    &CreateToken<ULocalVariableToken>,                    /// LocalVariable
+    &CreateToken<UInstanceVariableToken>,                 /// InstanceVariable
+    &CreateToken<UDefaultVariableToken>,                  /// DefaultVariable
+    &CreateToken<UStateVariableToken>,                    /// StateVariable
+    &CreateToken<UReturnToken>,                           /// Return
+    &CreateToken<USwitchToken>,                           /// Switch
+    &CreateToken<UJumpToken>,                             /// Jump
+    &CreateToken<UJumpIfNotToken>,                        /// JumpIfNot
+    &CreateToken<UStopToken>,                             /// Stop
+    &CreateToken<UAssertToken>,                           /// Assert
+    &CreateToken<UCaseToken>,                             /// Case
+    &CreateToken<UNothingToken>,                          /// Nothing
+    &CreateToken<ULabelTableToken>,                       /// LabelTable
+    &CreateToken<UGotoLabelToken>,                        /// GotoLabel
+    &CreateToken<UEatStringToken>,                        /// EatString
+    &CreateToken<ULetToken>,                              /// Let
+    &CreateToken<UDynArrayElementToken>,                  /// DynArrayElement
+    &CreateToken<UNewToken>,                              /// New
+    &CreateToken<UClassContextToken>,                     /// ClassContext
+    &CreateToken<UMetaCastToken>,                         /// MetaCast
+    &CreateToken<ULetBoolToken>,                          /// LetBool
+    &CreateToken<UEndParmValueToken>,                     /// EndParmValue
+    &CreateToken<UEndFunctionParmsToken>,                 /// EndFunctionParms
+    &CreateToken<USelfToken>,                             /// Self
+    &CreateToken<USkipToken>,                             /// Skip
+    &CreateToken<UContextToken>,                          /// Context
+    &CreateToken<UArrayElementToken>,                     /// ArrayElement
+    &CreateToken<UVirtualFunctionToken>,                  /// VirtualFunction
+    &CreateToken<UFinalFunctionToken>,                    /// FinalFunction
+    &CreateToken<UIntConstToken>,                         /// IntConst
+    &CreateToken<UFloatConstToken>,                       /// FloatConst
+    &CreateToken<UStringConstToken>,                      /// StringConst
+    &CreateToken<UObjectConstToken>,                      /// ObjectConst
+    &CreateToken<UNameConstToken>,                        /// NameConst
+    &CreateToken<URotatorConstToken>,                     /// RotatorConst
+    &CreateToken<UVectorConstToken>,                      /// VectorConst
+    &CreateToken<UByteConstToken>,                        /// ByteConst
+    &CreateToken<UIntZeroToken>,                          /// IntZero
+    &CreateToken<UIntOneToken>,                           /// IntOne
+    &CreateToken<UTrueToken>,                             /// True
+    &CreateToken<UFalseToken>,                            /// False
+    &CreateToken<UNativeParmToken>,                       /// NativeParm
+    &CreateToken<UNoObjectToken>,                         /// NoObject
+    &CreateTypedToken<UUnknownDeprecatedToken>,           /// UnknownDeprecated
+    &CreateToken<UIntConstByteToken>,                     /// IntConstByte
+    &CreateToken<UBoolVariableToken>,                     /// BoolVariable
+    &CreateToken<UDynamicCastToken>,                      /// DynamicCast
+    &CreateToken<UIteratorToken>,                         /// Iterator
+    &CreateToken<UIteratorPopToken>,                      /// IteratorPop
+    &CreateToken<UIteratorNextToken>,                     /// IteratorNext
+    &CreateToken<UStructCmpEqToken>,                      /// StructCmpEq
+    &CreateToken<UStructCmpNeToken>,                      /// StructCmpNe
+    &CreateToken<UUniStringConstToken>,                   /// UniStringConst
+    &CreateToken<UStructMemberToken>,                     /// StructMember
+    &CreateToken<UDynArrayLenToken>,                      /// DynArrayLen
+    &CreateToken<UGlobalFunctionToken>,                   /// GlobalFunction
+    &CreateToken<UPrimitiveCastToken>,                    /// PrimitiveCast
+    &CreateToken<UDynArrayInsertToken>,                   /// DynArrayInsert
+    &CreateToken<UReturnNothingToken>,                    /// ReturnNothing
+    &CreateToken<UDelegateCmpEqToken>,                    /// DelegateCmpEq
+    &CreateToken<UDelegateCmpNeToken>,                    /// DelegateCmpNe
+    &CreateToken<UDelegateFunctionCmpEqToken>,            /// DelegateFunctionCmpEq
+    &CreateToken<UDelegateFunctionCmpNeToken>,            /// DelegateFunctionCmpNE
+    &CreateToken<UNoDelegateToken>,                       /// NoDelegate
+    &CreateToken<UDynArrayRemoveToken>,                   /// DynArrayRemove
+    &CreateToken<UDebugInfoToken>,                        /// DebugInfo
+    &CreateToken<UDelegateFunctionToken>,                 /// DelegateFunction
+    &CreateToken<UDelegatePropertyToken>,                 /// DelegateProperty
+    &CreateToken<ULetDelegateToken>,                      /// LetDelegate
+    &CreateToken<UTernaryConditionToken>,                 /// TernaryCondition
+    &CreateToken<UDynArrFindToken>,                       /// DynArrFind
+    &CreateToken<UDynArrayFindStructToken>,               /// DynArrayFindStruct
+    &CreateToken<UOutVariableToken>,                      /// OutVariable
+    &CreateToken<UDefaultParmValueToken>,                 /// DefaultParmValue
+    &CreateToken<UNoParmToken>,                           /// NoParm
+    &CreateToken<UInstanceDelegateToken>,                 /// InstanceDelegate
+    &CreateTypedToken<UUnknownDynamicVariableToken>,      /// UnknownDynamicVariable1
+    &CreateTypedToken<UUnknownDynamicVariableToken>,      /// UnknownDynamicVariable2
+    &CreateTypedToken<UUnknownDynamicVariableToken>,      /// UnknownDynamicVariable3
+    &CreateTypedToken<UUnknownDynamicVariableToken>,      /// UnknownDynamicVariable4
+    &CreateTypedToken<UUnknownDynamicVariableToken>,      /// UnknownDynamicVariable5
+    &CreateToken<UInterfaceContextToken>,                 /// InterfaceContext
+    &CreateToken<UInterfaceCastToken>,                    /// InterfaceCast
+    &CreateToken<UEndOfScriptToken>,                      /// EndOfScript
+    &CreateToken<UDynArrAddToken>,                        /// DynArrAdd
+    &CreateToken<UDynArrAddItemToken>,                    /// DynArrAddItem
+    &CreateToken<UDynArrRemoveItemToken>,                 /// DynArrRemoveItem
+    &CreateToken<UDynArrInsertItemToken>,                 /// DynArrInsertItem
+    &CreateToken<UDynArrIteratorToken>,                   /// DynArrIterator
+    &CreateToken<UDynArrSortToken>,                       /// DynArrSort
+    &CreateTypedToken<UUnknownFilterEditorOnlyToken>,     /// UnknownFilterEditorOnly1
+    &CreateTypedToken<UUnknownFilterEditorOnlyToken>,     /// UnknownFilterEditorOnly2
+    &CreateTypedToken<UUnknownFilterEditorOnlyToken>,     /// UnknownFilterEditorOnly3
+    &CreateTypedToken<UUnknownFilterEditorOnlyToken>,     /// UnknownFilterEditorOnly4
+    &CreateTypedToken<UUnknownFilterEditorOnlyToken>,     /// UnknownFilterEditorOnly5
+    &CreateTypedToken<UUnknownFilterEditorOnlyToken>,     /// UnknownFilterEditorOnly6
+    &CreateTypedToken<UNativeFunctionToken>,              /// ExtendedNative
+    &CreateTypedToken<UNativeFunctionToken>,              /// NativeFunction1
+    &CreateTypedToken<UNativeFunctionToken>,              /// NativeFunction2
+    &CreateTypedToken<UNativeFunctionToken>,              /// NativeFunction3
+    &CreateTypedToken<UNativeFunctionToken>,              /// NativeFunction4
+    &CreateTypedToken<UNativeFunctionToken>,              /// NativeFunction5
+    &CreateTypedToken<UNativeFunctionToken>,              /// NativeFunction6
+    &CreateTypedToken<UNativeFunctionToken>,              /// NativeFunction7
+    &CreateTypedToken<UNativeFunctionToken>,              /// NativeFunction8
+    &CreateTypedToken<UNativeFunctionToken>,              /// NativeFunction9
+    &CreateTypedToken<UNativeFunctionToken>,              /// NativeFunctionA
+    &CreateTypedToken<UNativeFunctionToken>,              /// NativeFunctionB
+    &CreateTypedToken<UNativeFunctionToken>,              /// NativeFunctionC
+    &CreateTypedToken<UNativeFunctionToken>,              /// NativeFunctionD
+    &CreateTypedToken<UNativeFunctionToken>,              /// NativeFunctionE
+    &CreateTypedToken<UNativeFunctionToken>,              /// NativeFunctionF
+};
+
 UScriptToken* UTokenFactory::Create(UToken Type)
 {
-	if (Type == UToken::LocalVariable)
-	{
-		return new ULocalVariableToken;
-	}
-	else if (Type == UToken::InstanceVariable)
-	{
-		return new UInstanceVariableToken;
-	}
-	else if (Type == UToken::DefaultVariable)
-	{
-		return new UDefaultVariableToken;
-	}
-	else if (Type == UToken::StateVariable)
-	{
-		return new UStateVariableToken;
-	}
-	else if (Type == UToken::Return)
-	{
-		return new UReturnToken;
-	}
-	else if (Type == UToken::Switch)
-	{
-		return new USwitchToken;
-	}
-	else if (Type == UToken::Jump)
-	{
-		return new UJumpToken;
-	}
-	else if (Type == UToken::JumpIfNot)
-	{
-		return new UJumpIfNotToken;
-	}
-	else if (Type == UToken::Stop)
-	{
-		return new UStopToken;
-	}
-	else if (Type == UToken::Assert)
-	{
-		return new UAssertToken;
-	}
-	else if (Type == UToken::Case)
-	{
-		return new UCaseToken;
-	}
-	else if (Type == UToken::Nothing)
-	{
-		return new UNothingToken;
-	}
-	else if (Type == UToken::LabelTable)
-	{
-		return new ULabelTableToken;
-	}
-	else if (Type == UToken::GotoLabel)
-	{
-		return new UGotoLabelToken;
-	}
-	else if (Type == UToken::EatString)
-	{
-		return new UEatStringToken;
-	}
-	else if (Type == UToken::Let)
-	{
-		return new ULetToken;
-	}
-	else if (Type == UToken::DynArrayElement)
-	{
-		return new UDynArrayElementToken;
-	}
-	else if (Type == UToken::New)
-	{
-		return new UNewToken;
-	}
-	else if (Type == UToken::ClassContext)
-	{
-		return new UClassContextToken;
-	}
-	else if (Type == UToken::MetaCast)
-	{
-		return new UMetaCastToken;
-	}
-	else if (Type == UToken::LetBool)
-	{
-		return new ULetBoolToken;
-	}
-	else if (Type == UToken::EndParmValue)
-	{
-		return new UEndParmValueToken;
-	}
-	else if (Type == UToken::EndFunctionParms)
-	{
-		return new UEndFunctionParmsToken;
-	}
-	else if (Type == UToken::Self)
-	{
-		return new USelfToken;
-	}
-	else if (Type == UToken::Skip)
-	{
-		return new USkipToken;
-	}
-	else if (Type == UToken::Context)
-	{
-		return new UContextToken;
-	}
-	else if (Type == UToken::ArrayElement)
-	{
-		return new UArrayElementToken;
-	}
-	else if (Type == UToken::VirtualFunction)
-	{
-		return new UVirtualFunctionToken;
-	}
-	else if (Type == UToken::FinalFunction)
-	{
-		return new UFinalFunctionToken;
-	}
-	else if (Type == UToken::IntConst)
-	{
-		return new UIntConstToken;
-	}
-	else if (Type == UToken::FloatConst)
-	{
-		return new UFloatConstToken;
-	}
-	else if (Type == UToken::StringConst)
-	{
-		return new UStringConstToken;
-	}
-	else if (Type == UToken::ObjectConst)
-	{
-		return new UObjectConstToken;
-	}
-	else if (Type == UToken::NameConst)
-	{
-		return new UNameConstToken;
-	}
-	else if (Type == UToken::RotatorConst)
-	{
-		return new URotatorConstToken;
-	}
-	else if (Type == UToken::VectorConst)
-	{
-		return new UVectorConstToken;
-	}
-	else if (Type == UToken::ByteConst)
-	{
-		return new UByteConstToken;
-	}
-	else if (Type == UToken::IntZero)
-	{
-		return new UIntZeroToken;
-	}
-	else if (Type == UToken::IntOne)
-	{
-		return new UIntOneToken;
-	}
-	else if (Type == UToken::True)
-	{
-		return new UTrueToken;
-	}
-	else if (Type == UToken::False)
-	{
-		return new UFalseToken;
-	}
-	else if (Type == UToken::NativeParm)
-	{
-		return new UNativeParmToken;
-	}
-	else if (Type == UToken::NoObject)
-	{
-		return new UNoObjectToken;
-	}
-	else if (Type == UToken::UnknownDeprecated)
-	{
-		return new UUnknownDeprecatedToken(Type);
-	}
-	else if (Type == UToken::IntConstByte)
-	{
-		return new UIntConstByteToken;
-	}
-	else if (Type == UToken::BoolVariable)
-	{
-		return new UBoolVariableToken;
-	}
-	else if (Type == UToken::DynamicCast)
-	{
-		return new UDynamicCastToken;
-	}
-	else if (Type == UToken::Iterator)
-	{
-		return new UIteratorToken;
-	}
-	else if (Type == UToken::IteratorPop)
-	{
-		return new UIteratorPopToken;
-	}
-	else if (Type == UToken::IteratorNext)
-	{
-		return new UIteratorNextToken;
-	}
-	else if (Type == UToken::StructCmpEq)
-	{
-		return new UStructCmpEqToken;
-	}
-	else if (Type == UToken::StructCmpNe)
-	{
-		return new UStructCmpNeToken;
-	}
-	else if (Type == UToken::UniStringConst)
-	{
-		return new UUniStringConstToken;
-	}
-	else if (Type == UToken::StructMember)
-	{
-		return new UStructMemberToken;
-	}
-	else if (Type == UToken::DynArrayLen)
-	{
-		return new UDynArrayLenToken;
-	}
-	else if (Type == UToken::GlobalFunction)
-	{
-		return new UGlobalFunctionToken;
-	}
-	else if (Type == UToken::PrimitiveCast)
-	{
-		return new UPrimitiveCastToken;
-	}
-	else if (Type == UToken::DynArrayInsert)
-	{
-		return new UDynArrayInsertToken;
-	}
-	else if (Type == UToken::ReturnNothing)
-	{
-		return new UReturnNothingToken;
-	}
-	else if (Type == UToken::DelegateCmpEq)
-	{
-		return new UDelegateCmpEqToken;
-	}
-	else if (Type == UToken::DelegateCmpNe)
-	{
-		return new UDelegateCmpNeToken;
-	}
-	else if (Type == UToken::DelegateFunctionCmpEq)
-	{
-		return new UDelegateFunctionCmpEqToken;
-	}
-	else if (Type == UToken::DelegateFunctionCmpNE)
-	{
-		return new UDelegateFunctionCmpNeToken;
-	}
-	else if (Type == UToken::NoDelegate)
-	{
-		return new UNoDelegateToken;
-	}
-	else if (Type == UToken::DynArrayRemove)
-	{
-		return new UDynArrayRemoveToken;
-	}
-	else if (Type == UToken::DebugInfo)
-	{
-		return new UDebugInfoToken;
-	}
-	else if (Type == UToken::DelegateFunction)
-	{
-		return new UDelegateFunctionToken;
-	}
-	else if (Type == UToken::DelegateProperty)
-	{
-		return new UDelegatePropertyToken;
-	}
-	else if (Type == UToken::LetDelegate)
-	{
-		return new ULetDelegateToken;
-	}
-	else if (Type == UToken::TernaryCondition)
-	{
-		return new UTernaryConditionToken;
-	}
-	else if (Type == UToken::DynArrFind)
-	{
-		return new UDynArrFindToken;
-	}
-	else if (Type == UToken::DynArrayFindStruct)
-	{
-		return new UDynArrayFindStructToken;
-	}
-	else if (Type == UToken::OutVariable)
-	{
-		return new UOutVariableToken;
-	}
-	else if (Type == UToken::DefaultParmValue)
-	{
-		return new UDefaultParmValueToken;
-	}
-	else if (Type == UToken::NoParm)
-	{
-		return new UNoParmToken;
-	}
-	else if (Type == UToken::InstanceDelegate)
-	{
-		return new UInstanceDelegateToken;
-	}
-	else if (Type >= UToken::UnknownDynamicVariable1 && Type <= UToken::UnknownDynamicVariable5)
-	{
-		return new UUnknownDynamicVariableToken(Type);
-	}
-	else if (Type == UToken::InterfaceContext)
-	{
-		return new UInterfaceContextToken;
-	}
-	else if (Type == UToken::InterfaceCast)
-	{
-		return new UInterfaceCastToken;
-	}
-	else if (Type == UToken::EndOfScript)
-	{
-		return new UEndOfScriptToken;
-	}
-	else if (Type == UToken::DynArrAdd)
-	{
-		return new UDynArrAddToken;
-	}
-	else if (Type == UToken::DynArrAddItem)
-	{
-		return new UDynArrAddItemToken;
-	}
-	else if (Type == UToken::DynArrRemoveItem)
-	{
-		return new UDynArrRemoveItemToken;
-	}
-	else if (Type == UToken::DynArrInsertItem)
-	{
-		return new UDynArrInsertItemToken;
-	}
-	else if (Type == UToken::DynArrIterator)
-	{
-		return new UDynArrIteratorToken;
-	}
-	else if (Type == UToken::DynArrSort)
-	{
-		return new UDynArrSortToken;
-	}
-	else if (Type >= UToken::UnknownFilterEditorOnly1 && Type <= UToken::UnknownFilterEditorOnly6)
-	{
-		return new UUnknownFilterEditorOnlyToken(Type);
-	}
-	else if (Type >= UToken::ExtendedNative && Type <= UToken::NativeFunctionF)
-	{
-		return new UNativeFunctionToken(Type);
-	}
-    else
+    size_t idx = (size_t)Type;
+    if (idx >= sizeof(TokenCreators) / sizeof(TokenCreators[0]))
     {
         return nullptr;
     }
+    return TokenCreators[idx](Type);
 }
@@ -0,0 +1,159 @@
+#include "UndoJournal.h"
+
+#include <fstream>
+#include <cstring>
+
+/// journal file signature and version, journals of other versions are not accepted
+static const char JournalSignature[8] = {'U', 'P', 'K', 'U', 'N', 'D', 'O', 0};
+static const uint32_t JournalVersion = 2;
+
+uint64_t GetChangedFileSize(const FUndoPackage& Package)
+{
+    uint64_t size = Package.FileSize;
+    for (unsigned i = 0; i < Package.Records.size(); ++i)
+    {
+        size += Package.Records[i].Size;
+        size -= Package.Records[i].Data.size();
+    }
+    return size;
+}
+
+static void WriteJournalValue(std::ostream& out, uint32_t val)
+{
+    out.write(reinterpret_cast<char*>(&val), sizeof(val));
+}
+
+static void WriteJournalValue(std::ostream& out, uint64_t val)
+{
+    out.write(reinterpret_cast<char*>(&val), sizeof(val));
+}
+
+static void WriteJournalValue(std::ostream& out, const char* data, size_t size)
+{
+    WriteJournalValue(out, (uint32_t)size);
+    out.write(data, size);
+}
+
+static bool ReadJournalValue(std::istream& in, uint32_t& val)
+{
+    return (bool)in.read(reinterpret_cast<char*>(&val), sizeof(val));
+}
+
+static bool ReadJournalValue(std::istream& in, uint64_t& val)
+{
+    return (bool)in.read(reinterpret_cast<char*>(&val), sizeof(val));
+}
+
+/// data can not be longer than the rest of the file
+template<typename T>
+static bool ReadJournalValue(std::istream& in, std::streampos end, T& data)
+{
+    uint32_t size = 0;
+    if (!ReadJournalValue(in, size) || size > end - in.tellg())
+        return false;
+    data.resize(size);
+    return (size == 0 || (bool)in.read(&data[0], size));
+}
+
+bool UndoJournal::Read(const char* filename)
+{
+    Clear();
+    std::ifstream in(filename, std::ios::binary | std::ios::ate);
+    if (!in)
+        return false;
+    std::streampos end = in.tellg();
+    in.seekg(0);
+    char Signature[sizeof(JournalSignature)];
+    uint32_t Version = 0;
+    if (!in.read(Signature, sizeof(Signature)) || memcmp(Signature, JournalSignature, sizeof(Signature)) != 0)
+        return false;
+    if (!ReadJournalValue(in, Version) || Version != JournalVersion)
+        return false;
+    uint32_t count = 0;
+    bool good = ReadJournalValue(in, count);
+    for (uint32_t i = 0; good && i < count; ++i)
+    {
+        FUndoPackage Package;
+        uint32_t numRecords = 0;
+        good = ReadJournalValue(in, end, Package.UPKName) && ReadJournalValue(in, end, Package.GUID) &&
+               ReadJournalValue(in, Package.FileSize) && ReadJournalValue(in, numRecords);
+        for (uint32_t j = 0; good && j < numRecords; ++j)
+        {
+            FUndoRecord Record;
+            uint64_t Offset = 0, Size = 0;
+            good = ReadJournalValue(in, Offset) && ReadJournalValue(in, Size) &&
+                   ReadJournalValue(in, Record.Hash) && ReadJournalValue(in, end, Record.Data);
+            Record.Offset = Offset;
+            Record.Size = Size;
+            Package.Records.push_back(Record);
+        }
+        Packages[Package.UPKName] = Package;
+    }
+    if (!good)
+    {
+        Clear();
+        return false;
+    }
+    return true;
+}
+
+bool UndoJournal::Write(const char* filename)
+{
+    std::ofstream out(filename, std::ios::binary);
+    if (!out)
+        return false;
+    out.write(JournalSignature, sizeof(JournalSignature));
+    WriteJournalValue(out, JournalVersion);
+    uint32_t count = 0;
+    std::map<std::string, FUndoPackage>::iterator it;
+    for (it = Packages.begin(); it != Packages.end(); ++it)
+    {
+        if (!it->second.Records.empty())
+            ++count;
+    }
+    WriteJournalValue(out, count);
+    /// unchanged packages are not saved
+    for (it = Packages.begin(); it != Packages.end(); ++it)
+    {
+        const FUndoPackage& Package = it->second;
+        if (Package.Records.empty())
+            continue;
+        WriteJournalValue(out, Package.UPKName.data(), Package.UPKName.size());
+        WriteJournalValue(out, Package.GUID.data(), Package.GUID.size());
+        WriteJournalValue(out, Package.FileSize);
+        WriteJournalValue(out, (uint32_t)Package.Records.size());
+        for (unsigned i = 0; i < Package.Records.size(); ++i)
+        {
+            const FUndoRecord& Record = Package.Records[i];
+            WriteJournalValue(out, (uint64_t)Record.Offset);
+            WriteJournalValue(out, (uint64_t)Record.Size);
+            WriteJournalValue(out, Record.Hash);
+            WriteJournalValue(out, Record.Data.data(), Record.Data.size());
+        }
+    }
+    return out.good();
+}
+
+bool UndoJournal::IsEmpty()
+{
+    std::map<std::string, FUndoPackage>::iterator it;
+    for (it = Packages.begin(); it != Packages.end(); ++it)
+    {
+        if (!it->second.Records.empty())
+            return false;
+    }
+    return true;
+}
+
+FUndoPackage& UndoJournal::AddPackage(const std::string& UPKName)
+{
+    std::map<std::string, FUndoPackage>::iterator it = Packages.find(UPKName);
+    if (it == Packages.end())
+    {
+        FUndoPackage Package;
+        Package.UPKName = UPKName;
+        Package.FileSize = 0;
+        it = Packages.insert({UPKName, Package}).first;
+    }
+    return it->second;
+}
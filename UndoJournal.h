@@ -0,0 +1,54 @@
+#ifndef UNDOJOURNAL_H
+#define UNDOJOURNAL_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <cstddef>
+
+/// single package change: Size bytes at Offset replaced original Data
+/// Size and Data size differ for the changes, which resize or move package data:
+/// appended data have no original data, header rewrites replace the whole header
+/// Hash is a hash of the Size bytes, which the change left (as seen by undo, after the
+/// later changes are undone), undo is refused if package data do not match it
+struct FUndoRecord
+{
+    size_t Offset;
+    size_t Size;
+    std::vector<char> Data;
+    uint64_t Hash;
+};
+
+/// changes of a package in order they were made
+struct FUndoPackage
+{
+    std::string UPKName;
+    std::string GUID;
+    uint64_t FileSize;              /// package size before the changes
+    std::vector<FUndoRecord> Records;
+};
+
+/// package size after all the changes
+uint64_t GetChangedFileSize(const FUndoPackage& Package);
+
+/// binary undo journal: original data of all the changes made by a mod script
+/// changes are undone in reverse order, package must be in the state the mod left it in
+class UndoJournal
+{
+public:
+    UndoJournal() {}
+    ~UndoJournal() {}
+    void Clear() { Packages.clear(); }
+    bool Read(const char* filename);
+    bool Write(const char* filename);
+    /// no changes recorded
+    bool IsEmpty();
+    /// find package by name, add new one if not found
+    FUndoPackage& AddPackage(const std::string& UPKName);
+    std::map<std::string, FUndoPackage>& GetPackages() { return Packages; }
+private:
+    std::map<std::string, FUndoPackage> Packages;
+};
+
+#endif // UNDOJOURNAL_H
@@ -2,185 +2,127 @@
 #include <fstream>
 #include <vector>
 #include <string>
-#include "minilzo.h"
+#include <cstdlib>
+#include "../LZOCodec.h"
+#include "../ParallelFor.h"
 
 using namespace std;
 
-#define IN_LEN      (131072u)                              /// max input block size
-#define OUT_LEN     (IN_LEN + IN_LEN / 16 + 64 + 3)        /// max output block size
-
-static unsigned char __LZO_MMODEL in  [ IN_LEN ];          /// input data
-static unsigned char __LZO_MMODEL out [ OUT_LEN ];         /// output data
-
-#define HEAP_ALLOC(var,size) \
-    lzo_align_t __LZO_MMODEL var [ ((size) + (sizeof(lzo_align_t) - 1)) / sizeof(lzo_align_t) ]
-
-static HEAP_ALLOC(wrkmem, LZO1X_1_MEM_COMPRESS);           /// lzo working memory
-
-#define TAG 0x9E2A83C1
-
 int main(int argN, char* argV[])
 {
     cout << "XComLZO Packer/Unpacker" << endl;
 
-    if (argN != 3)
+    unsigned NumThreads = GetNumThreads();
+    vector<string> args;
+    for (int i = 1; i < argN; ++i)
+    {
+        string arg = argV[i];
+        if (arg == "-j" && i + 1 < argN)
+        {
+            NumThreads = GetNumThreads(atoi(argV[++i]));
+        }
+        else if (arg.substr(0, 2) == "-j" && arg.size() > 2)
+        {
+            NumThreads = GetNumThreads(atoi(arg.substr(2).c_str()));
+        }
+        else
+        {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.size() != 2)
     {
-        cerr << "Usage: XComLZO p inputFileName" << endl
-             << "    or XComLZO u inputFileName" << endl
-             << "where p = pack and u = unpack" << endl;
+        cerr << "Usage: XComLZO p inputFileName [-j N]" << endl
+             << "    or XComLZO u inputFileName [-j N]" << endl
+             << "where p = pack and u = unpack" << endl
+             << "and N = number of threads (default: number of CPU cores)" << endl;
         return 1;
     }
 
     bool isPacking = false;
 
-    if (string(argV[1]) == "p" || string(argV[1]) == "P")
+    if (args[0] == "p" || args[0] == "P")
         isPacking = true;
-    else if (string(argV[1]) == "u" || string(argV[1]) == "U")
+    else if (args[0] == "u" || args[0] == "U")
         isPacking = false;
     else
     {
-        cerr << "Unknown option " << argV[1] << endl;
+        cerr << "Unknown option " << args[0] << endl;
         return 1;
     }
 
-    ifstream inFile(argV[2], ios::binary);
+    ifstream inFile(args[1].c_str(), ios::binary);
     if (!inFile.is_open())
     {
-        cerr << "Can't open " << argV[2] << endl;
+        cerr << "Can't open " << args[1] << endl;
         return 1;
     }
 
-    int err;
-    lzo_uint in_len;
-    lzo_uint out_len;
-    lzo_uint new_len;
-
-    if (lzo_init() != LZO_E_OK)
+    if (!LZOInit())
     {
         cout << "LZO library internal error: lzo_init() failed!!!\n";
         return 1;
     }
 
-    lzo_memset(in, 0, IN_LEN);
-
     if (isPacking)
     {
         size_t dataSize = 0;
         inFile.seekg(0, ios::end);
         dataSize = inFile.tellg();
         inFile.seekg(0);
-        vector<unsigned char> dataChunk(dataSize);
-        inFile.read(reinterpret_cast<char*>(dataChunk.data()), dataSize);
-        uint32_t blockSize = IN_LEN;
-        unsigned numBlocks = (dataSize + blockSize - 1) / blockSize;
-        vector<uint32_t> sizes((numBlocks + 1)*2); /// compressed/uncompressed pairs
-        vector<unsigned char> compressedData;
-        sizes[1] = dataSize; /// uncompressed file size
-        for (unsigned i = 1; i < numBlocks; ++i)
-        {
-            sizes[i * 2 + 1] = blockSize; /// block uncompressed sizes, always the same
-        }
-        sizes[numBlocks * 2 + 1] = dataSize - (numBlocks - 1) * blockSize;
-        size_t blockOffset = 0;
-        for (unsigned i = 1; i <= numBlocks; ++i)
+        vector<char> dataChunk(dataSize);
+        inFile.read(dataChunk.data(), dataSize);
+        vector<char> compressedChunk;
+        if (!LZOCompressChunk(dataChunk.data(), dataSize, compressedChunk, NumThreads))
         {
-            in_len = sizes[i * 2 + 1];
-            lzo_memcpy(in, dataChunk.data() + blockOffset, in_len);
-            err = lzo1x_1_compress(in, in_len, out, &out_len, wrkmem);
-            if (err == LZO_E_OK)
-                cout << "compressed " << (unsigned long) in_len << " bytes into "
-                     << (unsigned long) out_len << " bytes\n";
-            else
-            {
-                cout << "LZO library internal error: compression failed!!!\n";
-                return 1;
-            }
-            sizes[i * 2] = out_len; /// block compressed size
-            sizes[0] += out_len; /// overall compressed data size
-            size_t compressedOffset = compressedData.size();
-            compressedData.resize(compressedData.size() + out_len);
-            lzo_memcpy(compressedData.data() + compressedOffset, out, out_len);
-            blockOffset += in_len;
+            cout << "LZO library internal error: compression failed!!!\n";
+            return 1;
         }
-        uint32_t tag = TAG;
-        ofstream outFile((string(argV[2]) + ".packed").c_str(), ios::binary);
+        cout << "compressed " << dataSize << " bytes into "
+             << compressedChunk.size() << " bytes\n";
+        ofstream outFile((args[1] + ".packed").c_str(), ios::binary);
         if (!outFile.is_open())
         {
             cerr << "Can't open output file!!!\n";
             return 1;
         }
-        outFile.write(reinterpret_cast<char*>(&tag), 4);
-        outFile.write(reinterpret_cast<char*>(&blockSize), 4);
-        outFile.write(reinterpret_cast<char*>(sizes.data()), 4 * sizes.size());
-        outFile.write(reinterpret_cast<char*>(compressedData.data()), compressedData.size());
+        outFile.write(compressedChunk.data(), compressedChunk.size());
         return 0;
     }
     else
     {
-        ofstream outFile((string(argV[2]) + ".unpacked").c_str(), ios::binary);
+        ofstream outFile((args[1] + ".unpacked").c_str(), ios::binary);
         if (!outFile.is_open())
         {
             cerr << "Can't open output file!!!\n";
             return 1;
         }
-        uint32_t tag = 0;
-        while (inFile.read(reinterpret_cast<char*>(&tag), 4).good())
+        while (inFile.peek() != char_traits<char>::eof())
         {
             cout << "Next block:\n";
-            if (tag != TAG)
-            {
-                cerr << "Missing magic number!\n";
-                return 1;
-            }
-            uint32_t blockSize = 0;
-            inFile.read(reinterpret_cast<char*>(&blockSize), 4);
-            if (blockSize != IN_LEN)
+            LZOChunkHeader header;
+            if (!LZOReadChunkHeader(inFile, header))
             {
-                cerr << "Incorrect max block size!\n";
+                cerr << "Bad data!\n";
                 return 1;
             }
-            vector<uint32_t> sizes(2); /// compressed/uncompressed pairs
-            inFile.read(reinterpret_cast<char*>(sizes.data()), 4 * sizes.size());
-            size_t dataSize = sizes[1]; /// uncompressed data chunk size
-            unsigned numBlocks = (dataSize + blockSize - 1) / blockSize;
-            //cout << "Num blocks: " << numBlocks << endl;
-            if (numBlocks < 1)
+            vector<char> compressedData(header.CompressedSize);
+            inFile.read(compressedData.data(), compressedData.size());
+            if (!inFile.good())
             {
                 cerr << "Bad data!\n";
                 return 1;
             }
-            sizes.resize((numBlocks + 1)*2);
-            inFile.read(reinterpret_cast<char*>(sizes.data()) + 8, 4 * sizes.size() - 8);
-            /*for (unsigned i = 0; i <= numBlocks; ++i)
-            {
-                cout << "Compressed size: " << sizes[i * 2]
-                     << "\tUncompressed size: " << sizes[i * 2 + 1] << endl;
-            }*/
-            vector<unsigned char> dataChunk(dataSize);
-            vector<unsigned char> compressedData(sizes[0]);
-            inFile.read(reinterpret_cast<char*>(compressedData.data()), compressedData.size());
-            size_t blockOffset = 0;
-            size_t dataOffset = 0;
-            for (unsigned i = 1; i <= numBlocks; ++i)
+            vector<char> dataChunk(header.UncompressedSize);
+            if (!LZODecompressBlocks(header, compressedData.data(), dataChunk.data(), NumThreads))
             {
-                out_len = sizes[i * 2]; /// compressed size
-                lzo_memcpy(out, compressedData.data() + blockOffset, out_len);
-                in_len = sizes[i * 2 + 1]; /// uncompressed size
-                new_len = in_len;
-                err = lzo1x_decompress(out, out_len, in, &new_len, NULL);
-                if (err == LZO_E_OK && new_len == in_len)
-                    cout << "decompressed " << (unsigned long) out_len << " bytes back into "
-                         << (unsigned long) in_len << endl;
-                else
-                {
-                    cout << "LZO library internal error: decompression failed!!!\n";
-                    return 3;
-                }
-                lzo_memcpy(dataChunk.data() + dataOffset, in, in_len);
-                blockOffset += out_len;
-                dataOffset += in_len;
+                cout << "LZO library internal error: decompression failed!!!\n";
+                return 3;
             }
-            outFile.write(reinterpret_cast<char*>(dataChunk.data()), dataSize);
+            cout << "decompressed " << header.CompressedSize << " bytes back into "
+                 << header.UncompressedSize << endl;
+            outFile.write(dataChunk.data(), dataChunk.size());
         }
         return 0;
     }
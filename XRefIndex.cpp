@@ -0,0 +1,242 @@
+#include "XRefIndex.h"
+#include "UToken.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+
+std::string FormatXRefKind(XRefKind Kind)
+{
+    switch (Kind)
+    {
+    case XRefKind::Call:
+        return "Call";
+    case XRefKind::Variable:
+        return "Variable";
+    case XRefKind::Object:
+        return "Object";
+    case XRefKind::Name:
+        return "Name";
+    }
+    return "Unknown";
+}
+
+static XRefKind GetXRefKind(const UScriptReference& Ref)
+{
+    switch (Ref.Type)
+    {
+    case UToken::VirtualFunction:
+    case UToken::FinalFunction:
+        return XRefKind::Call;
+    /// delegate call: delegate property and function name
+    case UToken::DelegateFunction:
+        return (Ref.IsName ? XRefKind::Call : XRefKind::Variable);
+    case UToken::LocalVariable:
+    case UToken::InstanceVariable:
+    case UToken::DefaultVariable:
+    case UToken::StateVariable:
+    case UToken::OutVariable:
+    case UToken::Context:
+    case UToken::ClassContext:
+    case UToken::StructMember:
+    case UToken::ReturnNothing:
+        return XRefKind::Variable;
+    case UToken::DelegateProperty:
+        return (Ref.IsName ? XRefKind::Name : XRefKind::Variable);
+    default:
+        break;
+    }
+    return (Ref.IsName ? XRefKind::Name : XRefKind::Object);
+}
+
+static bool LessBySource(const FXRef& a, const FXRef& b)
+{
+    if (a.From != b.From)
+        return a.From < b.From;
+    if (a.ByName != b.ByName)
+        return a.ByName < b.ByName;
+    if (a.To != b.To)
+        return a.To < b.To;
+    return a.Kind < b.Kind;
+}
+
+static bool LessByTarget(const FXRef& a, const FXRef& b)
+{
+    if (a.ByName != b.ByName)
+        return a.ByName < b.ByName;
+    if (a.To != b.To)
+        return a.To < b.To;
+    if (a.From != b.From)
+        return a.From < b.From;
+    return a.Kind < b.Kind;
+}
+
+static bool EqualXRefs(const FXRef& a, const FXRef& b)
+{
+    return (a.From == b.From && a.To == b.To && a.Kind == b.Kind && a.ByName == b.ByName);
+}
+
+void XRefIndex::Clear()
+{
+    BySource.clear();
+    ByTarget.clear();
+    NumScripts = 0;
+    NumBadScripts = 0;
+}
+
+bool XRefIndex::Build(UPKUtils& package, unsigned numThreads)
+{
+    Clear();
+    if (!package.IsLoaded())
+        return false;
+    const std::vector<FObjectExport>& ExportTable = package.GetExportTable();
+    std::vector<uint32_t> Scripts;
+    for (uint32_t i = 1; i < ExportTable.size(); ++i)
+    {
+        if (ExportTable[i].Type == "Function" || ExportTable[i].Type == "State")
+            Scripts.push_back(i);
+    }
+    /// read-only package can be safely shared between worker threads
+    bool ReadOnly = package.IsReadOnly();
+    if (!ReadOnly)
+        numThreads = 1;
+    std::vector<std::vector<FXRef>> Refs(Scripts.size());
+    std::vector<char> BadScripts(Scripts.size(), 0);
+    ParallelFor(Scripts.size(), GetNumThreads(numThreads), [&](size_t s)
+    {
+        uint32_t idx = Scripts[s];
+        UObject* Obj = UObjectFactory::Create(ExportTable[idx].Type);
+        UStruct* St = dynamic_cast<UStruct*>(Obj);
+        if (St == nullptr || !package.DecodeObject(St, idx))
+        {
+            BadScripts[s] = 1;
+            delete Obj;
+            return;
+        }
+        size_t ScrPos = St->GetScriptOffset() - ExportTable[idx].SerialOffset;
+        size_t ScrSize = St->GetScriptSerialSize();
+        delete Obj;
+        if (ScrSize == 0)
+            return;
+        std::vector<char> data;
+        UPKDataView view = {nullptr, 0};
+        if (ReadOnly)
+        {
+            view = package.GetExportDataView(idx);
+        }
+        else
+        {
+            data = package.GetExportData(idx);
+            view.Data = data.data();
+            view.Size = data.size();
+        }
+        if (ScrPos >= view.Size || ScrSize > view.Size - ScrPos)
+        {
+            BadScripts[s] = 1;
+            return;
+        }
+        /// script is decoded from its own data only
+        view.Data += ScrPos;
+        view.Size = ScrSize;
+        UPKMemoryStream stream(view);
+        std::vector<UScriptReference> ScriptRefs;
+        UScriptCode ScrCode;
+        BadScripts[s] = !ScrCode.CollectReferences(stream, package, ScriptRefs);
+        std::vector<FXRef>& Result = Refs[s];
+        Result.reserve(ScriptRefs.size());
+        for (unsigned i = 0; i < ScriptRefs.size(); ++i)
+        {
+            const UScriptReference& Ref = ScriptRefs[i];
+            int32_t To = (Ref.IsName ? (int32_t)Ref.NameIdx.NameTableIdx : Ref.ObjRef);
+            Result.push_back({(UObjectReference)idx, To, GetXRefKind(Ref), Ref.IsName});
+        }
+        std::sort(Result.begin(), Result.end(), LessBySource);
+        Result.erase(std::unique(Result.begin(), Result.end(), EqualXRefs), Result.end());
+    });
+    /// scripts are in export table order, so concatenated references stay sorted by source
+    size_t size = 0;
+    for (unsigned s = 0; s < Refs.size(); ++s)
+        size += Refs[s].size();
+    BySource.reserve(size);
+    for (unsigned s = 0; s < Refs.size(); ++s)
+    {
+        BySource.insert(BySource.end(), Refs[s].begin(), Refs[s].end());
+        std::vector<FXRef>().swap(Refs[s]);
+        NumBadScripts += BadScripts[s];
+    }
+    NumScripts = Scripts.size();
+    ByTarget = BySource;
+    std::sort(ByTarget.begin(), ByTarget.end(), LessByTarget);
+    return true;
+}
+
+std::vector<FXRef> XRefIndex::FindReferencesFrom(UObjectReference ObjRef)
+{
+    FXRef Key = {ObjRef, INT32_MIN, XRefKind::Call, false};
+    std::vector<FXRef>::iterator it = std::lower_bound(BySource.begin(), BySource.end(), Key, LessBySource);
+    std::vector<FXRef> Result;
+    for (; it != BySource.end() && it->From == ObjRef; ++it)
+        Result.push_back(*it);
+    return Result;
+}
+
+std::vector<FXRef> XRefIndex::FindTo(int32_t To, bool ByName)
+{
+    FXRef Key = {INT32_MIN, To, XRefKind::Call, ByName};
+    std::vector<FXRef>::iterator it = std::lower_bound(ByTarget.begin(), ByTarget.end(), Key, LessByTarget);
+    std::vector<FXRef> Result;
+    for (; it != ByTarget.end() && it->To == To && it->ByName == ByName; ++it)
+        Result.push_back(*it);
+    return Result;
+}
+
+std::vector<FXRef> XRefIndex::FindReferencesTo(UObjectReference ObjRef)
+{
+    return FindTo(ObjRef, false);
+}
+
+std::vector<FXRef> XRefIndex::FindReferencesToName(int NameTableIdx)
+{
+    return FindTo(NameTableIdx, true);
+}
+
+std::vector<FXRef> XRefIndex::FindCallers(UObjectReference FuncRef, UPKInfo& info)
+{
+    std::vector<FXRef> Result;
+    if (FuncRef == 0)
+        return Result;
+    std::vector<FXRef> Refs = FindTo(FuncRef, false);
+    UNameIndex NameIdx = (FuncRef > 0 ? info.GetExportEntry(FuncRef).NameIdx : info.GetImportEntry(-FuncRef).NameIdx);
+    std::vector<FXRef> NameRefs = FindTo(NameIdx.NameTableIdx, true);
+    Refs.insert(Refs.end(), NameRefs.begin(), NameRefs.end());
+    for (unsigned i = 0; i < Refs.size(); ++i)
+    {
+        if (Refs[i].Kind == XRefKind::Call)
+            Result.push_back(Refs[i]);
+    }
+    std::sort(Result.begin(), Result.end(), LessBySource);
+    return Result;
+}
+
+std::vector<FXRef> XRefIndex::FindCallees(UObjectReference ObjRef)
+{
+    std::vector<FXRef> Refs = FindReferencesFrom(ObjRef);
+    std::vector<FXRef> Result;
+    for (unsigned i = 0; i < Refs.size(); ++i)
+    {
+        if (Refs[i].Kind == XRefKind::Call)
+            Result.push_back(Refs[i]);
+    }
+    return Result;
+}
+
+std::vector<FXRef> XRefIndex::FindReaders(UObjectReference VarRef)
+{
+    std::vector<FXRef> Refs = FindTo(VarRef, false);
+    std::vector<FXRef> Result;
+    for (unsigned i = 0; i < Refs.size(); ++i)
+    {
+        if (Refs[i].Kind == XRefKind::Variable)
+            Result.push_back(Refs[i]);
+    }
+    return Result;
+}
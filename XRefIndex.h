@@ -0,0 +1,68 @@
+#ifndef XREFINDEX_H
+#define XREFINDEX_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "UPKUtils.h"
+
+/// kind of script reference
+enum class XRefKind : uint8_t
+{
+    Call = 0,           /// final, virtual and delegate function calls
+    Variable = 1,       /// local, instance, default, state and out variables, struct members
+    Object = 2,         /// object consts, casts and other object references
+    Name = 3            /// name consts and delegate names
+};
+
+std::string FormatXRefKind(XRefKind Kind);
+
+/// script of From references To: object reference or name table index if ByName is set
+/// virtual function calls are made by name, so they reference function name, not function object
+struct FXRef
+{
+    UObjectReference From;
+    int32_t To;
+    XRefKind Kind;
+    bool ByName;
+};
+
+/// cross-reference index of package scripts: objects and names referenced by each
+/// Function and State export, indexed by both referencing and referenced side
+/// variable references include both reading and writing, as bytecode does not tell them apart
+class XRefIndex
+{
+public:
+    XRefIndex(): NumScripts(0), NumBadScripts(0) {}
+    ~XRefIndex() {}
+    void Clear();
+    /// scan all the Function and State scripts with numThreads workers (0 = hardware threads)
+    /// packages, which are not read-only (see UPKUtils::ReadMapped), are scanned by one thread
+    bool Build(UPKUtils& package, unsigned numThreads = 0);
+    size_t GetNumScripts() { return NumScripts; }
+    /// scripts, which could not be decoded completely, their references are indexed up to error
+    size_t GetNumBadScripts() { return NumBadScripts; }
+    size_t GetNumRefs() { return BySource.size(); }
+    /// all the references made by script of ObjRef
+    std::vector<FXRef> FindReferencesFrom(UObjectReference ObjRef);
+    /// all the references to ObjRef
+    std::vector<FXRef> FindReferencesTo(UObjectReference ObjRef);
+    /// all the references to name
+    std::vector<FXRef> FindReferencesToName(int NameTableIdx);
+    /// final and delegate calls of FuncRef and virtual calls by its name
+    std::vector<FXRef> FindCallers(UObjectReference FuncRef, UPKInfo& info);
+    /// functions called by script of ObjRef
+    std::vector<FXRef> FindCallees(UObjectReference ObjRef);
+    /// scripts, which use variable VarRef
+    std::vector<FXRef> FindReaders(UObjectReference VarRef);
+private:
+    std::vector<FXRef> FindTo(int32_t To, bool ByName);
+    /// same references, sorted by From and by To
+    std::vector<FXRef> BySource;
+    std::vector<FXRef> ByTarget;
+    size_t NumScripts;
+    size_t NumBadScripts;
+};
+
+#endif // XREFINDEX_H
@@ -0,0 +1,106 @@
+#include "TestCommon.h"
+#include "ModScript.h"
+
+/// FuncA and FuncB scripts start at relative offset 48
+const char* ModA =
+    "UPK_FILE = batch.upk\n"
+    "OBJECT = TestClass.FuncA : KEEP\n"
+    "REL_OFFSET = 54\n"
+    "MODDED_HEX = 2C 07\n";
+
+/// overlaps ModA write
+const char* ModB =
+    "UPK_FILE = batch.upk\n"
+    "OBJECT = TestClass.FuncA : KEEP\n"
+    "REL_OFFSET = 55\n"
+    "MODDED_HEX = 09\n";
+
+const char* ModC =
+    "UPK_FILE = batch.upk\n"
+    "OBJECT = TestClass.FuncB : KEEP\n"
+    "REL_OFFSET = 48\n"
+    "MODDED_HEX = 04 2C 09\n";
+
+/// moves and resizes FuncB, changed by ModC
+const char* ModD =
+    "UPK_FILE = batch.upk\n"
+    "OBJECT = TestClass.FuncB : MOVE\n"
+    "[REPLACEMENT_CODE]\n"
+    "04 2C 07 0B 0B 0B 0B 0B 0B 53\n";
+
+/// fails after changing FuncB
+const char* BadMod =
+    "UPK_FILE = batch.upk\n"
+    "OBJECT = TestClass.FuncB : KEEP\n"
+    "REL_OFFSET = 48\n"
+    "MODDED_HEX = 04 2C 0A\n"
+    "OBJECT = TestClass.NoSuchFunction : KEEP\n"
+    "MODDED_HEX = 00\n";
+
+/// mods applied one by one
+std::vector<char> ApplySerial(const std::vector<const char*>& mods)
+{
+    CHECK(CopyTestPackage("batch.upk"));
+    for (unsigned i = 0; i < mods.size(); ++i)
+    {
+        std::ostringstream discard;
+        ModScript script;
+        script.InitStreams(discard, discard);
+        script.SetUPKPath(".");
+        CHECK(WriteTextFile("batch.txt", mods[i]));
+        CHECK(script.Parse("batch.txt") && script.ExecuteStack());
+    }
+    return ReadFileData("batch.upk");
+}
+
+/// mods applied in batch mode, returns number of applied mods
+unsigned ApplyBatch(const std::vector<const char*>& mods, unsigned& NumConflicts)
+{
+    CHECK(CopyTestPackage("batch.upk"));
+    std::ostringstream discard;
+    ModScript script;
+    script.InitStreams(discard, discard);
+    script.SetUPKPath(".");
+    script.SetBatchMode(true);
+    unsigned NumApplied = 0;
+    for (; NumApplied < mods.size(); ++NumApplied)
+    {
+        CHECK(WriteTextFile("batch.txt", mods[NumApplied]));
+        if (!script.Parse("batch.txt") || !script.ExecuteStack())
+            break;
+    }
+    CHECK(script.FlushPackages());
+    NumConflicts = script.GetConflictsCount();
+    return NumApplied;
+}
+
+void TestBatch(const std::vector<const char*>& mods, bool isConflicting)
+{
+    unsigned NumConflicts = 0;
+    CHECK(ApplyBatch(mods, NumConflicts) == mods.size());
+    CHECK((NumConflicts > 0) == isConflicting);
+    /// batch result is the same as the result of serial application
+    std::vector<char> data = ReadFileData("batch.upk");
+    CHECK(data == ApplySerial(mods));
+}
+
+void TestFailedMod()
+{
+    /// changes of the failed mod are undone, the other changes are kept
+    unsigned NumConflicts = 0;
+    CHECK(ApplyBatch({ ModA, BadMod }, NumConflicts) == 1);
+    std::vector<char> data = ReadFileData("batch.upk");
+    CHECK(data == ApplySerial({ ModA }));
+}
+
+int main(int argc, char* argv[])
+{
+    if (!InitTest(argc, argv))
+        return 1;
+    TestBatch({ ModA, ModC }, false);
+    TestBatch({ ModA, ModB }, true);
+    TestBatch({ ModC, ModD }, true);
+    TestBatch({ ModA, ModD }, false);
+    TestFailedMod();
+    return NumFailed;
+}
@@ -0,0 +1,116 @@
+#include <cstdlib>
+#include <cstdint>
+
+#include "TestCommon.h"
+#include "HexCodec.h"
+#include "ModParser.h"
+#include "UPKInfo.h"
+
+/// previous stream and sprintf based implementations
+
+std::vector<char> StreamDecodeHEX(const std::string& TextBuffer)
+{
+    std::vector<char> data;
+    if (TextBuffer.length() < 1)
+        return data;
+    std::istringstream ss(TextBuffer);
+    while (ss.good())
+    {
+        int byte;
+        ss >> std::hex >> byte;
+        if (!ss.fail() && !ss.bad())
+            data.push_back(byte);
+    }
+    return data;
+}
+
+std::string PrintfEncodeHEX(const std::vector<char>& DataChunk)
+{
+    std::string ret;
+    for (unsigned i = 0; i < DataChunk.size(); ++i)
+    {
+        char ch[255];
+        sprintf(ch, "%02X", (uint8_t)DataChunk[i]);
+        ret += std::string(ch) + " ";
+    }
+    return ret;
+}
+
+std::string PrintfEncodeHEXBlock(const std::vector<char>& DataChunk)
+{
+    std::string out = "";
+    for (unsigned i = 0; i < DataChunk.size(); ++i)
+    {
+        if ((i%16 == 0) && (i != 0))
+            out += '\n';
+        char ch[255];
+        sprintf(ch, "%02X ", (uint8_t)DataChunk[i]);
+        out += ch;
+    }
+    out += '\n';
+    return out;
+}
+
+std::vector<char> RandomData(size_t size)
+{
+    std::vector<char> ret(size);
+    for (size_t i = 0; i < size; ++i)
+        ret[i] = rand() % 256;
+    return ret;
+}
+
+void TestEncode()
+{
+    srand(1);
+    for (unsigned n = 0; n < 100; ++n)
+    {
+        /// empty data, partial and full lines
+        std::vector<char> data = RandomData(n < 50 ? n : rand() % 1000);
+        std::string expected = PrintfEncodeHEX(data);
+        CHECK(EncodeHEX(data.data(), data.size()) == expected);
+        CHECK(FormatHEX(data) == expected);
+        CHECK(FormatHEX(data.data(), data.size()) == expected);
+        CHECK(FormatHEX(std::string(data.begin(), data.end())) == expected);
+        CHECK(EncodeHEXBlock(data.data(), data.size()) == PrintfEncodeHEXBlock(data));
+        CHECK(MakeTextBlock(data.data(), data.size()) == PrintfEncodeHEXBlock(data));
+        /// encoded text is decoded back
+        CHECK(GetDataChunk(expected) == data);
+        CHECK(GetDataChunk(PrintfEncodeHEXBlock(data)) == data);
+    }
+}
+
+void TestDecode()
+{
+    /// short tokens are decoded by table, the rest falls back to stream reading
+    const char* texts[] =
+    {
+        "", " ", "0B", "0b 2c\t07\r\n53", "  1 2   3  ", "0B 0B", "0B 0B ", "\n0B\n",
+        "0x2C 07", "07 0x2C 0B", "123 45", "0B 123", "FFF 0B", "0B zz 0B", "0G 0B", "0B -1 0B",
+        "1G", "0B\v0C\f0D", "0B,0C", "0B 0C/", "100 0B", "7FFFFFFF 0B", "FFFFFFFFF 0B"
+    };
+    for (unsigned i = 0; i < sizeof(texts) / sizeof(texts[0]); ++i)
+    {
+        std::string text = texts[i];
+        CHECK(DecodeHEX(text.data(), text.size()) == StreamDecodeHEX(text));
+        CHECK(GetDataChunk(text) == StreamDecodeHEX(text));
+    }
+    /// random hex-like text
+    srand(2);
+    const char alphabet[] = "0123456789abcdefABCDEFxX -\t\n\rg";
+    for (unsigned n = 0; n < 2000; ++n)
+    {
+        std::string text;
+        for (unsigned i = 0, len = rand() % 40; i < len; ++i)
+            text += alphabet[rand() % (sizeof(alphabet) - 1)];
+        CHECK(DecodeHEX(text.data(), text.size()) == StreamDecodeHEX(text));
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (!InitTest(argc, argv))
+        return 1;
+    TestEncode();
+    TestDecode();
+    return NumFailed;
+}
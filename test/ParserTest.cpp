@@ -0,0 +1,94 @@
+#include "TestCommon.h"
+#include "ModParser.h"
+
+/// mixed line endings, all kinds of comments, unknown keys and text after sections,
+/// last line without new line
+const char* ModText =
+    "{ header comment\n spanning lines }\r\n"
+    "UPK_FILE = Test.upk // line comment\r\n"
+    "OBJECT=TestClass.FuncA:KEEP\r"
+    "  REL_OFFSET  =  0x30 /* block */ \n"
+    "MODDED_HEX = 0B {inline} 0B\n"
+    "  0B 0B\n"
+    "UNKNOWN_KEY = 1\n"
+    "[REPLACEMENT_CODE]\n"
+    "\n"
+    "\r\n"
+    "04 0B /* multi\nline */ 53\n"
+    "   [BEFORE_HEX]   \n"
+    "[/BEFORE_HEX]\n"
+    "a = b [x]\n"
+    "[AFTER_HEX] trailing\n"
+    "OBJECT = Last : AUTO";
+
+struct FExpectedRecord
+{
+    int Index;
+    const char* Name;
+    const char* Value;
+};
+
+/// records found by line by line stream parser
+const FExpectedRecord ExpectedRecords[] =
+{
+    { 0, "UPK_FILE", " Test.upk " },
+    { 1, "OBJECT", "TestClass.FuncA:KEEP" },
+    { 2, "REL_OFFSET", "  0x30  " },
+    { 3, "MODDED_HEX", " 0B  0B\n  0B 0B\nUNKNOWN_KEY = 1" },
+    { 0, "[REPLACEMENT_CODE]", "04 0B  53" },
+    { 1, "[BEFORE_HEX]", "" },
+    { 2, "[/BEFORE_HEX]", "a = b [x]\n[AFTER_HEX] trailing" },
+    { 1, "OBJECT", " Last : AUTO" }
+};
+
+void InitParser(ModParser& parser)
+{
+    parser.SetKeyNames({ "UPK_FILE", "OBJECT", "REL_OFFSET", "MODDED_HEX" });
+    parser.SetSectionNames({ "[REPLACEMENT_CODE]", "[BEFORE_HEX]", "[/BEFORE_HEX]", "[AFTER_HEX]" });
+    parser.SetCommentMarkers('{', '}', 0);
+}
+
+void TestRecords()
+{
+    CHECK(WriteTextFile("parser.txt", ModText));
+    ModParser parser;
+    InitParser(parser);
+    CHECK(parser.OpenModFile("parser.txt"));
+    unsigned count = sizeof(ExpectedRecords) / sizeof(ExpectedRecords[0]);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        CHECK(parser.FindNext() == ExpectedRecords[i].Index);
+        CHECK(parser.GetName() == ExpectedRecords[i].Name);
+        CHECK(parser.GetValue() == ExpectedRecords[i].Value);
+    }
+    CHECK(parser.FindNext() == -1);
+    CHECK(parser.GetName() == "" && parser.GetValue() == "");
+    /// values
+    CHECK(WriteTextFile("parser.txt", "REL_OFFSET = 48\nMODDED_HEX = 0B 1 0x2C\n"));
+    CHECK(parser.OpenModFile("parser.txt"));
+    CHECK(parser.FindNext() == 2 && parser.GetIntValue() == 48);
+    CHECK(parser.FindNext() == 3 && parser.GetDataChunk() == std::vector<char>({ 0x0B, 0x01, 0x2C }));
+}
+
+void TestBadFiles()
+{
+    ModParser parser;
+    InitParser(parser);
+    CHECK(WriteTextFile("parser.txt", ""));
+    CHECK(parser.OpenModFile("parser.txt"));
+    CHECK(parser.FindNext() == -1);
+    /// non-ASCII data
+    CHECK(WriteTextFile("parser.txt", "UPK_FILE = x\n\x80\x01\n"));
+    CHECK(!parser.OpenModFile("parser.txt"));
+    CHECK(parser.FindNext() == -1);
+    CHECK(!parser.OpenModFile("nosuchfile.txt"));
+}
+
+int main(int argc, char* argv[])
+{
+    if (!InitTest(argc, argv))
+        return 1;
+    TestRecords();
+    TestBadFiles();
+    return NumFailed;
+}
@@ -0,0 +1,84 @@
+#include "TestCommon.h"
+#include "ModScript.h"
+
+/// pseudo-code with object and name references and labels, function is resized
+const char* ModText =
+    "UPK_FILE = plan.upk\n"
+    "OBJECT = TestClass.FuncA : AUTO\n"
+    "[REPLACEMENT_CODE]\n"
+    "0F 01 <@VarX> 2C 07\n"
+    "07 [@label1] 9A 01 <@VarX> 2C 07 16\n"
+    "    1B <FuncB> 16\n"
+    "[#label1]\n"
+    "04 0B\n"
+    "53\n";
+
+/// moves FuncB and changes package header
+const char* PreModText =
+    "UPK_FILE = plan.upk\n"
+    "OBJECT = TestClass.FuncB : MOVE\n"
+    "[REPLACEMENT_CODE]\n"
+    "04 2C 07 0B 0B 0B 0B 0B 0B 53\n";
+
+/// applies mod to plan.upk, using precompiled plan if plan file name is not empty
+bool ApplyMod(const std::string& modName, const char* text, const std::string& planName = "", std::string* log = nullptr)
+{
+    CHECK(WriteTextFile(modName, text));
+    std::ostringstream err, res;
+    ModScript script;
+    script.InitStreams(err, res);
+    script.SetUPKPath(".");
+    bool ret = (planName == "" ? script.Parse(modName.c_str()) : script.ParsePlan(modName.c_str(), planName.c_str()));
+    ret = (ret && script.ExecuteStack());
+    if (ret && planName != "")
+        ret = script.SavePlan();
+    if (log != nullptr)
+        *log = res.str();
+    return ret;
+}
+
+/// result of the mod, applied to a fresh copy of test package
+std::vector<char> GetModResult(bool withPreMod, const std::string& planName = "", std::string* log = nullptr)
+{
+    CHECK(CopyTestPackage("plan.upk"));
+    if (withPreMod)
+        CHECK(ApplyMod("premod.txt", PreModText));
+    CHECK(ApplyMod("plan.txt", ModText, planName, log));
+    return ReadFileData("plan.upk");
+}
+
+void TestPlan(bool withPreMod)
+{
+    std::string log;
+    std::remove("plan.plan");
+    std::vector<char> data = GetModResult(withPreMod);
+    CHECK(data != ReadFileData(DataPath + "/Test.upk"));
+    /// plan is compiled on the first run and used on the next one
+    CHECK(GetModResult(withPreMod, "plan.plan", &log) == data);
+    CHECK(log.find("Compiling plan") != std::string::npos);
+    CHECK(FileExists("plan.plan"));
+    CHECK(GetModResult(withPreMod, "plan.plan", &log) == data);
+    CHECK(log.find("Using precompiled plan") != std::string::npos);
+}
+
+void TestChangedPackage()
+{
+    /// plan is compiled for unchanged package, compiled code is not used for the changed one
+    std::remove("plan.plan");
+    GetModResult(false, "plan.plan");
+    CHECK(GetModResult(true, "plan.plan") == GetModResult(true));
+    /// and the other way round
+    std::remove("plan.plan");
+    GetModResult(true, "plan.plan");
+    CHECK(GetModResult(false, "plan.plan") == GetModResult(false));
+}
+
+int main(int argc, char* argv[])
+{
+    if (!InitTest(argc, argv))
+        return 1;
+    TestPlan(false);
+    TestPlan(true);
+    TestChangedPackage();
+    return NumFailed;
+}
@@ -0,0 +1,131 @@
+#include <cstdlib>
+#include <algorithm>
+
+#include "TestCommon.h"
+#include "DataSearch.h"
+#include "ModScript.h"
+
+/// all (including overlapping) occurrences of pattern inside data
+std::vector<size_t> FindAllNaive(const std::vector<char>& data, const std::vector<char>& pattern, size_t beg = 0, size_t end = 0)
+{
+    std::vector<size_t> ret;
+    if (end == 0)
+        end = data.size();
+    for (size_t i = beg; i + pattern.size() <= end; ++i)
+    {
+        if (std::equal(pattern.begin(), pattern.end(), data.begin() + i))
+            ret.push_back(i);
+    }
+    return ret;
+}
+
+std::vector<char> RandomData(size_t size, int alphabet)
+{
+    std::vector<char> ret(size);
+    for (size_t i = 0; i < size; ++i)
+        ret[i] = 'a' + rand() % alphabet;
+    return ret;
+}
+
+void TestDataSearch()
+{
+    srand(1);
+    for (unsigned n = 0; n < 200; ++n)
+    {
+        std::vector<char> data = RandomData(200 + rand() % 200, 3);
+        std::vector<char> pattern = RandomData(1 + rand() % 6, 3);
+        std::vector<size_t> expected = FindAllNaive(data, pattern);
+        DataSearch Search(pattern);
+        size_t found = Search.Find(data.data(), data.size());
+        CHECK(found == (expected.empty() ? data.size() : expected[0]));
+    }
+}
+
+void TestMultiDataSearch()
+{
+    srand(2);
+    for (unsigned n = 0; n < 200; ++n)
+    {
+        std::vector<char> data = RandomData(500 + rand() % 500, 2 + n % 3);
+        /// patterns are often prefixes, suffixes and parts of each other
+        std::vector<std::vector<char>> patterns;
+        for (unsigned i = 0, count = 1 + rand() % 8; i < count; ++i)
+            patterns.push_back(RandomData(1 + rand() % 7, 2 + n % 3));
+        /// data are fed by random blocks
+        MultiDataSearch Search(patterns);
+        std::vector<std::vector<size_t>> found(patterns.size());
+        for (size_t pos = 0; pos < data.size(); )
+        {
+            size_t len = std::min(data.size() - pos, (size_t)(1 + rand() % 64));
+            Search.Feed(data.data() + pos, len, pos, found);
+            pos += len;
+        }
+        for (unsigned i = 0; i < patterns.size(); ++i)
+            CHECK(found[i] == FindAllNaive(data, patterns[i]));
+    }
+}
+
+void TestPackageSearch()
+{
+    CHECK(CopyTestPackage("searchtest.upk"));
+    std::vector<char> data = ReadFileData("searchtest.upk");
+    UPKUtils package("searchtest.upk");
+    CHECK(package.IsLoaded());
+    std::vector<std::vector<char>> patterns = { {0x00, 0x00}, {0x00, 0x00, 0x00}, {0x0B}, {0x16, 0x1C}, {0x53} };
+    std::vector<std::vector<size_t>> found = package.FindDataChunks(patterns);
+    std::vector<std::vector<size_t>> foundRange = package.FindDataChunks(patterns, 0x300, 0x3A0);
+    for (unsigned i = 0; i < patterns.size(); ++i)
+    {
+        CHECK(found[i] == FindAllNaive(data, patterns[i]));
+        /// found data must be inside the range
+        CHECK(foundRange[i] == FindAllNaive(data, patterns[i], 0x300, 0x3A1));
+        std::vector<size_t> expected = FindAllNaive(data, patterns[i], 0x100);
+        CHECK(package.FindDataChunk(patterns[i], 0x100) == (expected.empty() ? 0 : expected[0]));
+    }
+}
+
+bool ExecuteMod(const std::string& filename, const std::string& text)
+{
+    CHECK(WriteTextFile(filename, text));
+    std::ostringstream discard;
+    ModScript script;
+    script.InitStreams(discard, discard);
+    script.SetUPKPath(".");
+    return (script.Parse(filename.c_str()) && script.ExecuteStack());
+}
+
+void TestReplaceAll()
+{
+    /// consecutive REPLACE_HEX commands are searched together, later patterns are made by earlier writes
+    const char* commands[] =
+    {
+        "REPLACE_HEX = 00 00 00 00 : 00 00 00 01\n",
+        "REPLACE_HEX = 01 00 00 : 02 02 02\n",
+        "REPLACE_HEX = 02 02 : 0B 0B\n",
+        "REPLACE_HEX = 0B 0B 02 : 03 03 03\n",
+        "REPLACE_HEX = 03 00 : 04 04\n"
+    };
+    std::string all = "UPK_FILE = replaceall.upk\nOBJECT = TestClass : KEEP\n";
+    for (unsigned i = 0; i < sizeof(commands) / sizeof(commands[0]); ++i)
+        all += commands[i];
+    CHECK(CopyTestPackage("replaceall.upk"));
+    CHECK(ExecuteMod("ReplaceAll.txt", all));
+    /// same commands in separate mods
+    CHECK(CopyTestPackage("replaceone.upk"));
+    for (unsigned i = 0; i < sizeof(commands) / sizeof(commands[0]); ++i)
+        CHECK(ExecuteMod("ReplaceOne.txt", std::string("UPK_FILE = replaceone.upk\nOBJECT = TestClass : KEEP\n") + commands[i]));
+    std::vector<char> data = ReadFileData("replaceall.upk");
+    CHECK(data == ReadFileData("replaceone.upk"));
+    CHECK(data != ReadFileData(DataPath + "/Test.upk"));
+}
+
+int main(int argc, char* argv[])
+{
+    if (!InitTest(argc, argv))
+        return 1;
+    TestDataSearch();
+    TestMultiDataSearch();
+    TestPackageSearch();
+    TestReplaceAll();
+    return NumFailed;
+}
@@ -0,0 +1,77 @@
+#ifndef TESTCOMMON_H
+#define TESTCOMMON_H
+
+/// helpers for test programs
+/// test program gets test data folder as the first argument, runs in the build folder
+/// and returns the number of failed checks
+///
+/// data/Test.upk is a small uncompressed package:
+/// imports Core, Core.Function, Core.IntProperty
+/// exports TestClass, TestClass.FuncA, TestClass.FuncB, TestClass.VarX
+/// FuncA script: 0F 01 <@VarX> 2C 05 06 23 00 1B <FuncB> 16 1C <@FuncB> 16 04 0B 53
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+static unsigned NumFailed = 0;
+
+#define CHECK(expr) \
+    do \
+    { \
+        if (!(expr)) \
+        { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " << #expr << std::endl; \
+            ++NumFailed; \
+        } \
+    } while (0)
+
+static std::string DataPath = "data";
+
+inline bool InitTest(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " TestDataFolder" << std::endl;
+        return false;
+    }
+    DataPath = argv[1];
+    return true;
+}
+
+inline std::vector<char> ReadFileData(const std::string& filename)
+{
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    return std::vector<char>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+inline bool WriteFileData(const std::string& filename, const std::vector<char>& data)
+{
+    std::ofstream out(filename.c_str(), std::ios::binary);
+    out.write(data.data(), data.size());
+    return out.good();
+}
+
+inline bool WriteTextFile(const std::string& filename, const std::string& text)
+{
+    std::ofstream out(filename.c_str(), std::ios::binary);
+    out << text;
+    return out.good();
+}
+
+inline bool FileExists(const std::string& filename)
+{
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    return in.is_open();
+}
+
+/// fresh copy of test package in the current folder
+inline bool CopyTestPackage(const std::string& filename)
+{
+    return WriteFileData(filename, ReadFileData(DataPath + "/Test.upk"));
+}
+
+#endif // TESTCOMMON_H
@@ -0,0 +1,123 @@
+#include "TestCommon.h"
+#include "ModScript.h"
+#include "UndoJournal.h"
+
+/// changes FuncA, moves and resizes FuncB, then fails on a missing object
+const char* FailingMod =
+    "UPK_FILE = transaction.upk\n"
+    "OBJECT = TestClass.FuncA : KEEP\n"
+    "REL_OFFSET = 54\n"
+    "MODDED_HEX = 2C 07\n"
+    "OBJECT = TestClass.FuncB : MOVE\n"
+    "[REPLACEMENT_CODE]\n"
+    "04 2C 07 0B 0B 0B 0B 0B 0B 53\n"
+    "OBJECT = TestClass.NoSuchFunction : KEEP\n"
+    "MODDED_HEX = 00\n";
+
+/// transaction files must not be left behind
+bool NoTransactionFiles(const std::string& filename)
+{
+    return !FileExists(filename + ".tmp") && !FileExists(filename + ".journal");
+}
+
+/// same size writes and package resize, applied to transaction.upk
+bool ChangePackage(UPKUtils& package, bool withResize)
+{
+    UObjectReference FuncA = package.FindObject("TestClass.FuncA");
+    UObjectReference FuncB = package.FindObject("TestClass.FuncB");
+    if (FuncA <= 0 || FuncB <= 0)
+        return false;
+    size_t offset = package.GetExportEntry(FuncA).SerialOffset + 54;
+    if (!package.WriteData(offset, { 0x2C, 0x07 }))
+        return false;
+    if (withResize && !package.MoveResizeObject(FuncB, package.GetExportEntry(FuncB).SerialSize + 8))
+        return false;
+    return true;
+}
+
+void TestRollback(bool withResize)
+{
+    CHECK(CopyTestPackage("transaction.upk"));
+    std::vector<char> original = ReadFileData("transaction.upk");
+    UPKUtils package("transaction.upk");
+    CHECK(package.BeginTransaction());
+    CHECK(ChangePackage(package, withResize));
+    /// package file is not changed until commit
+    CHECK(ReadFileData("transaction.upk") == original);
+    CHECK(package.RollbackTransaction());
+    CHECK(ReadFileData("transaction.upk") == original);
+    CHECK(NoTransactionFiles("transaction.upk"));
+    CHECK(package.GetFileSize() == original.size());
+}
+
+void TestCommit(bool withResize)
+{
+    /// committed transaction gives the same result as direct writes
+    CHECK(CopyTestPackage("direct.upk"));
+    {
+        UPKUtils package("direct.upk");
+        CHECK(ChangePackage(package, withResize));
+    }
+    CHECK(CopyTestPackage("transaction.upk"));
+    {
+        UPKUtils package("transaction.upk");
+        CHECK(package.BeginTransaction());
+        CHECK(ChangePackage(package, withResize));
+        CHECK(package.CommitTransaction());
+    }
+    CHECK(ReadFileData("transaction.upk") == ReadFileData("direct.upk"));
+    CHECK(ReadFileData("transaction.upk") != ReadFileData(DataPath + "/Test.upk"));
+    CHECK(NoTransactionFiles("transaction.upk"));
+}
+
+void TestFailedMod()
+{
+    /// failed mod leaves package untouched
+    CHECK(CopyTestPackage("transaction.upk"));
+    CHECK(WriteTextFile("transaction.txt", FailingMod));
+    std::ostringstream discard;
+    ModScript script;
+    script.InitStreams(discard, discard);
+    script.SetUPKPath(".");
+    CHECK(!(script.Parse("transaction.txt") && script.ExecuteStack()));
+    CHECK(ReadFileData("transaction.upk") == ReadFileData(DataPath + "/Test.upk"));
+    CHECK(NoTransactionFiles("transaction.upk"));
+}
+
+void TestRecoverCommit()
+{
+    /// interrupted in-place commit: journal is written, package is partially changed
+    CHECK(CopyTestPackage("transaction.upk"));
+    std::vector<char> original = ReadFileData("transaction.upk");
+    const size_t offset = 0x32D + 54;
+    UndoJournal Journal;
+    FUndoPackage& Package = Journal.AddPackage("transaction.upk");
+    Package.FileSize = original.size();
+    Package.Records.push_back(FUndoRecord());
+    Package.Records.back().Offset = offset;
+    Package.Records.back().Size = 2;
+    Package.Records.back().Data.assign(original.begin() + offset, original.begin() + offset + 2);
+    CHECK(Journal.Write("transaction.upk.journal"));
+    std::vector<char> changed = original;
+    changed[offset] = 0x2C;
+    changed[offset + 1] = 0x07;
+    CHECK(WriteFileData("transaction.upk", changed));
+    /// original data are restored when package is opened
+    UPKUtils package("transaction.upk");
+    CHECK(package.IsLoaded());
+    CHECK(ReadFileData("transaction.upk") == original);
+    CHECK(NoTransactionFiles("transaction.upk"));
+}
+
+int main(int argc, char* argv[])
+{
+    if (!InitTest(argc, argv))
+        return 1;
+    TestRollback(false);
+    TestRollback(true);
+    TestCommit(false);
+    TestCommit(true);
+    TestFailedMod();
+    TestRecoverCommit();
+    return NumFailed;
+}
@@ -0,0 +1,107 @@
+#include "TestCommon.h"
+#include "ModScript.h"
+
+const char* SameSizeMod =
+    "UPK_FILE = undo.upk\n"
+    "OBJECT = TestClass.FuncA : KEEP\n"
+    "REL_OFFSET = 54\n"
+    "MODDED_HEX = 2C 07\n"
+    "OBJECT = TestClass : KEEP\n"
+    "REPLACE_HEX = 00 00 00 00 : 01 02 03 04\n";
+
+/// FuncB is moved to the end of package and resized
+const char* MoveMod =
+    "UPK_FILE = undo.upk\n"
+    "OBJECT = TestClass.FuncA : KEEP\n"
+    "REL_OFFSET = 54\n"
+    "MODDED_HEX = 2C 07\n"
+    "OBJECT = TestClass.FuncB : MOVE\n"
+    "[REPLACEMENT_CODE]\n"
+    "04 2C 07 0B 0B 0B 0B 0B 0B 53\n"
+    "OBJECT = TestClass.FuncB : KEEP\n"
+    "REL_OFFSET = 50\n"
+    "MODDED_HEX = 09\n";
+
+/// new name and FuncA local variable change package header and size
+const char* HeaderMod =
+    "UPK_FILE = undo.upk\n"
+    "[ADD_NAME_ENTRY]\n"
+    "<%u5> <%t\"VarY\"> <%u0x00000000> <%u0x00070010>\n"
+    "[ADD_EXPORT_ENTRY]\n"
+    "<Core.IntProperty> <NullRef> <TestClass.FuncA> <VarY> <NullRef>\n"
+    "<%u0x00000000> <%u0x00070004> <%u40> <%u0> <%u0>\n"
+    "<%u0> <%u0> <%u0> <%u0> <%u0> <%u0>\n"
+    "OBJECT = TestClass.FuncA.VarY\n"
+    "REL_OFFSET = 16\n"
+    "[MODDED_CODE]\n"
+    "<%s1> <%s0> <%u0x00000000> <%u0x00000000> <None> <NullRef>\n"
+    "OBJECT = TestClass.FuncA : KEEP\n"
+    "REL_OFFSET = 54\n"
+    "MODDED_HEX = 2C 07\n";
+
+/// applies mod to undo.upk and saves its undo journal
+bool InstallMod(const char* text)
+{
+    CHECK(WriteTextFile("undo.txt", text));
+    std::ostringstream discard;
+    ModScript script;
+    script.InitStreams(discard, discard);
+    script.SetUPKPath(".");
+    std::remove("undo.txt.uninstall.bin");
+    if (!script.Parse("undo.txt") || !script.ExecuteStack())
+        return false;
+    return (script.HasUndoJournal() && script.SaveUndoJournal("undo.txt.uninstall.bin"));
+}
+
+bool UninstallMod()
+{
+    std::ostringstream discard;
+    ModScript script;
+    script.InitStreams(discard, discard);
+    script.SetUPKPath(".");
+    return script.ExecuteUndo("undo.txt.uninstall.bin");
+}
+
+void TestUndo(const char* text)
+{
+    /// undo restores identical package
+    CHECK(CopyTestPackage("undo.upk"));
+    std::vector<char> original = ReadFileData("undo.upk");
+    CHECK(InstallMod(text));
+    std::vector<char> modded = ReadFileData("undo.upk");
+    CHECK(modded != original);
+    CHECK(UninstallMod());
+    CHECK(ReadFileData("undo.upk") == original);
+    CHECK(!FileExists("undo.upk.tmp"));
+    /// restored package is not the one the mod left, second undo is refused
+    CHECK(!UninstallMod());
+    CHECK(ReadFileData("undo.upk") == original);
+    /// the mod can be installed again with the same result
+    CHECK(InstallMod(text));
+    CHECK(ReadFileData("undo.upk") == modded);
+}
+
+void TestChangedPackage(const char* text, size_t changedOffset)
+{
+    /// package changed after the mod was installed is not touched
+    CHECK(CopyTestPackage("undo.upk"));
+    CHECK(InstallMod(text));
+    std::vector<char> changed = ReadFileData("undo.upk");
+    changed[changedOffset] ^= 0x01;
+    CHECK(WriteFileData("undo.upk", changed));
+    CHECK(!UninstallMod());
+    CHECK(ReadFileData("undo.upk") == changed);
+}
+
+int main(int argc, char* argv[])
+{
+    if (!InitTest(argc, argv))
+        return 1;
+    TestUndo(SameSizeMod);
+    TestUndo(MoveMod);
+    TestUndo(HeaderMod);
+    /// FuncA script data, changed by all the mods
+    TestChangedPackage(SameSizeMod, 0x32D + 54);
+    TestChangedPackage(MoveMod, 0x32D + 54);
+    return NumFailed;
+}
@@ -0,0 +1,83 @@
+#include "TestCommon.h"
+#include "XRefIndex.h"
+
+bool HasRef(const std::vector<FXRef>& refs, UObjectReference From, int32_t To, XRefKind Kind, bool ByName)
+{
+    for (unsigned i = 0; i < refs.size(); ++i)
+    {
+        if (refs[i].From == From && refs[i].To == To && refs[i].Kind == Kind && refs[i].ByName == ByName)
+            return true;
+    }
+    return false;
+}
+
+bool operator==(const FXRef& a, const FXRef& b)
+{
+    return (a.From == b.From && a.To == b.To && a.Kind == b.Kind && a.ByName == b.ByName);
+}
+
+void TestReferences(UPKUtils& package, unsigned numThreads)
+{
+    UObjectReference FuncA = package.FindObject("TestClass.FuncA");
+    UObjectReference FuncB = package.FindObject("TestClass.FuncB");
+    UObjectReference VarX = package.FindObject("TestClass.VarX");
+    int FuncBName = package.FindName("FuncB");
+    CHECK(FuncA > 0 && FuncB > 0 && VarX > 0 && FuncBName > 0);
+    XRefIndex Index;
+    CHECK(Index.Build(package, numThreads));
+    CHECK(Index.GetNumScripts() == 2);
+    CHECK(Index.GetNumBadScripts() == 0);
+    CHECK(Index.GetNumRefs() == 3);
+    /// FuncA: 1B <FuncB> (virtual call), 1C <@FuncB> (final call), 01 <@VarX> (instance variable)
+    std::vector<FXRef> refs = Index.FindReferencesFrom(FuncA);
+    CHECK(refs.size() == 3);
+    CHECK(HasRef(refs, FuncA, FuncB, XRefKind::Call, false));
+    CHECK(HasRef(refs, FuncA, FuncBName, XRefKind::Call, true));
+    CHECK(HasRef(refs, FuncA, VarX, XRefKind::Variable, false));
+    CHECK(Index.FindCallees(FuncA).size() == 2);
+    /// final and virtual calls
+    refs = Index.FindCallers(FuncB, package);
+    CHECK(refs.size() == 2);
+    CHECK(HasRef(refs, FuncA, FuncB, XRefKind::Call, false));
+    CHECK(HasRef(refs, FuncA, FuncBName, XRefKind::Call, true));
+    CHECK(Index.FindReferencesTo(FuncB).size() == 1);
+    CHECK(Index.FindReferencesToName(FuncBName).size() == 1);
+    refs = Index.FindReaders(VarX);
+    CHECK(refs.size() == 1 && HasRef(refs, FuncA, VarX, XRefKind::Variable, false));
+    /// FuncB makes no references
+    CHECK(Index.FindReferencesFrom(FuncB).empty());
+    CHECK(Index.FindCallers(FuncA, package).empty());
+}
+
+void TestThreads()
+{
+    /// script text does not depend on scanning the package by several threads
+    UPKUtils package;
+    CHECK(package.ReadMapped("xref.upk"));
+    UObjectReference FuncA = package.FindObject("TestClass.FuncA");
+    std::string text = package.Deserialize(FuncA);
+    XRefIndex Single, Multi;
+    CHECK(Single.Build(package, 1));
+    CHECK(Multi.Build(package, 4));
+    CHECK(Single.FindReferencesFrom(FuncA) == Multi.FindReferencesFrom(FuncA));
+    CHECK(package.Deserialize(FuncA) == text);
+}
+
+int main(int argc, char* argv[])
+{
+    if (!InitTest(argc, argv))
+        return 1;
+    CHECK(CopyTestPackage("xref.upk"));
+    {
+        UPKUtils package("xref.upk");
+        TestReferences(package, 1);
+    }
+    {
+        /// read-only packages are scanned by several threads
+        UPKUtils package;
+        CHECK(package.ReadMapped("xref.upk"));
+        TestReferences(package, 4);
+    }
+    TestThreads();
+    return NumFailed;
+}